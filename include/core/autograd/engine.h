@@ -0,0 +1,42 @@
+#pragma once
+#ifndef AUTOGRAD_ENGINE_H
+#define AUTOGRAD_ENGINE_H
+
+namespace torchscratch {
+namespace core {
+namespace autograd {
+
+/**
+ * Number of threads a backward pass may run independent graph nodes on, the
+ * calling thread included. Defaults to the number of hardware threads. Only
+ * graphs with independent branches, e.g. several heads or towers, use more
+ * than one; a chain of ops always runs on the calling thread. This is
+ * inter-op parallelism, separate from the intra-op pool of
+ * tensor::set_num_threads().
+ */
+int get_num_backward_threads();
+
+/**
+ * Resize the backward thread pool. 1 runs every backward pass on the calling
+ * thread.
+ */
+void set_num_backward_threads(int num_threads);
+
+/**
+ * Whether gradients are bitwise reproducible. When several consumers send a
+ * gradient to the same node, they are normally summed in the order they
+ * arrive, which depends on thread timing. In deterministic mode each node
+ * keeps them apart and sums them in graph order once all have arrived, so the
+ * result does not depend on scheduling or on the number of threads, at the
+ * cost of holding those gradients until then. Defaults to off, or to the
+ * TORCHSCRATCH_DETERMINISTIC_BACKWARD environment variable ("1" or "0").
+ */
+bool deterministic_backward();
+
+void set_deterministic_backward(bool deterministic);
+
+}  // namespace autograd
+}  // namespace core
+}  // namespace torchscratch
+
+#endif  // AUTOGRAD_ENGINE_H
@@ -2,7 +2,9 @@
 #ifndef AUTOGRAD_FUNCTION_H
 #define AUTOGRAD_FUNCTION_H
 
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -12,17 +14,35 @@ namespace torchscratch {
 namespace core {
 namespace autograd {
 
-// Forward declaration
-class Variable;
+// Forward declarations
+class Function;
+struct AutogradMeta;
+
+/**
+ * Edge from a Function to the graph node that receives the gradient of one of
+ * its inputs: the Function that produced the input, or the AccumulateGrad node
+ * of a leaf. Empty when the input does not require gradients.
+ */
+struct Edge {
+  std::shared_ptr<Function> function;
+
+  bool valid() const { return function != nullptr; }
+};
 
 /**
  * Base class for all autograd functions.
  * Each subclass implements a particular operation (like Add, MatMul, etc.)
  * with its forward and backward pass logic.
+ *
+ * A Function owns its next edges, so the graph stays valid for as long as the
+ * output holds its grad_fn, independently of the Variable objects it was built
+ * from, and it keeps only the tensors its backward pass needs.
  */
 class Function {
 public:
-  virtual ~Function() = default;
+  // Releases chains of producers iteratively, so dropping a deep graph cannot
+  // overflow the stack
+  virtual ~Function();
 
   // Rule of 5: Allow proper inheritance
   Function() = default;
@@ -41,7 +61,8 @@ public:
   /**
    * Apply the backward pass of this function.
    * @param grad_output Gradient of the loss with respect to the output
-   * @return Vector of gradients with respect to the inputs
+   * @return Vector of gradients with respect to the inputs; an entry may be
+   *         left undefined when needs_input_grad() is false for it
    */
   virtual std::vector<tensor::Tensor> backward(const std::vector<tensor::Tensor>& grad_output) = 0;
 
@@ -51,19 +72,75 @@ public:
   virtual std::string name() const = 0;
 
   /**
-   * Save pointers to the input variables for backward pass.
-   * @param inputs Vector of input variables
+   * Set the nodes the input gradients are sent to, one edge per input in the
+   * order of the gradients backward() returns.
+   */
+  void set_next_edges(std::vector<Edge> edges) { next_edges_ = std::move(edges); }
+
+  const std::vector<Edge>& next_edges() const { return next_edges_; }
+
+  /**
+   * Whether the gradient of input i is used. True when no edges have been set,
+   * so a Function can also be run on its own.
+   */
+  bool needs_input_grad(size_t i) const {
+    return next_edges_.empty() || (i < next_edges_.size() && next_edges_[i].valid());
+  }
+
+  /**
+   * Keep tensors for the backward pass, along with the current version of
+   * their data. Typically called from forward().
+   * @param tensors Tensors needed to compute the gradients
+   */
+  void save_for_backward(const std::vector<tensor::Tensor>& tensors);
+
+  /**
+   * Get the saved tensors, in the order they were saved.
    */
-  void save_for_backward(const std::vector<Variable*>& inputs);
+  const std::vector<tensor::Tensor>& saved_tensors() const { return saved_tensors_; }
 
   /**
-   * Get the saved input variables.
-   * @return Vector of saved input variables
+   * Throw if a saved tensor was modified in place since it was saved, which
+   * would make the gradient silently wrong.
    */
-  const std::vector<Variable*>& get_saved_variables() const;
+  void check_saved_versions() const;
+
+  /**
+   * Drop the saved tensors. The engine calls this once the function's
+   * gradients have been passed on, so a graph can only be backpropagated
+   * through once.
+   */
+  void release_saved();
+
+  /**
+   * Whether release_saved() has freed tensors this function needs.
+   */
+  bool released() const { return released_; }
 
 private:
-  std::vector<Variable*> saved_variables_;
+  std::vector<Edge> next_edges_;
+  std::vector<tensor::Tensor> saved_tensors_;
+  std::vector<uint64_t> saved_versions_;  // Data version of each saved tensor
+  bool released_ = false;
+};
+
+/**
+ * AccumulateGrad is the graph node of a leaf variable: it adds the incoming
+ * gradient into the variable's grad. Every use of the leaf in a graph shares
+ * one node, and backward passes running on several threads at once take turns
+ * updating the grad.
+ */
+class AccumulateGrad : public Function {
+public:
+  explicit AccumulateGrad(std::shared_ptr<AutogradMeta> meta) : meta_(std::move(meta)) {}
+
+  std::vector<tensor::Tensor> forward(const std::vector<tensor::Tensor>& inputs) override;
+  std::vector<tensor::Tensor> backward(const std::vector<tensor::Tensor>& grad_output) override;
+  std::string name() const override { return "AccumulateGrad"; }
+
+private:
+  std::shared_ptr<AutogradMeta> meta_;
+  std::mutex mutex_;  // Guards meta_->grad
 };
 
 /**
@@ -74,34 +151,111 @@ public:
   std::vector<tensor::Tensor> forward(const std::vector<tensor::Tensor>& inputs) override;
   std::vector<tensor::Tensor> backward(const std::vector<tensor::Tensor>& grad_output) override;
   std::string name() const override { return "AddFunction"; }
+
+private:
+  tensor::DimVector input1_shape_;  // Gradients are summed back to the input shapes
+  tensor::DimVector input2_shape_;
 };
 
 /**
- * MulFunction implements element-wise multiplication.
+ * MulFunction implements element-wise multiplication with broadcasting.
  */
 class MulFunction : public Function {
 public:
   std::vector<tensor::Tensor> forward(const std::vector<tensor::Tensor>& inputs) override;
   std::vector<tensor::Tensor> backward(const std::vector<tensor::Tensor>& grad_output) override;
   std::string name() const override { return "MulFunction"; }
-
-private:
-  tensor::Tensor input1_;  // Save inputs for backward pass
-  tensor::Tensor input2_;
 };
 
 /**
- * MatMulFunction implements matrix multiplication.
+ * MatMulFunction implements matrix multiplication, batched over any leading
+ * dimensions.
  */
 class MatMulFunction : public Function {
 public:
   std::vector<tensor::Tensor> forward(const std::vector<tensor::Tensor>& inputs) override;
   std::vector<tensor::Tensor> backward(const std::vector<tensor::Tensor>& grad_output) override;
   std::string name() const override { return "MatMulFunction"; }
+};
+
+/**
+ * BmmFunction implements batched matrix multiplication of 3-D tensors. The
+ * backward pass is MatMulFunction's.
+ */
+class BmmFunction : public MatMulFunction {
+public:
+  std::vector<tensor::Tensor> forward(const std::vector<tensor::Tensor>& inputs) override;
+  std::string name() const override { return "BmmFunction"; }
+};
+
+/**
+ * SumFunction implements the sum over some dimensions (all of them when none
+ * are given). The gradient is grad_output broadcast back to the input shape.
+ */
+class SumFunction : public Function {
+public:
+  SumFunction(const tensor::DimVector& dims, bool keepdim) : dims_(dims), keepdim_(keepdim) {}
+
+  std::vector<tensor::Tensor> forward(const std::vector<tensor::Tensor>& inputs) override;
+  std::vector<tensor::Tensor> backward(const std::vector<tensor::Tensor>& grad_output) override;
+  std::string name() const override { return "SumFunction"; }
+
+protected:
+  // Reduces inputs[0] with keepdim, records the shapes, and drops the reduced
+  // dimensions unless keepdim_ is set
+  tensor::Tensor finish_forward(const tensor::Tensor& input, const tensor::Tensor& kept);
+  // grad_output reshaped to keepdim_shape_
+  tensor::Tensor kept_grad(const tensor::Tensor& grad_output) const;
+
+  tensor::DimVector dims_;
+  bool keepdim_;
+  tensor::DimVector input_shape_;
+  tensor::DimVector keepdim_shape_;  // Output shape with the reduced dimensions as size 1
+};
+
+/**
+ * MeanFunction implements the mean over some dimensions.
+ */
+class MeanFunction : public SumFunction {
+public:
+  using SumFunction::SumFunction;
+
+  std::vector<tensor::Tensor> forward(const std::vector<tensor::Tensor>& inputs) override;
+  std::vector<tensor::Tensor> backward(const std::vector<tensor::Tensor>& grad_output) override;
+  std::string name() const override { return "MeanFunction"; }
+};
+
+/**
+ * MaxFunction implements the maximum (or, with largest = false, the minimum)
+ * over some dimensions. The gradient is shared evenly between tied elements.
+ */
+class MaxFunction : public SumFunction {
+public:
+  MaxFunction(const tensor::DimVector& dims, bool keepdim, bool largest = true)
+      : SumFunction(dims, keepdim), largest_(largest) {}
+
+  std::vector<tensor::Tensor> forward(const std::vector<tensor::Tensor>& inputs) override;
+  std::vector<tensor::Tensor> backward(const std::vector<tensor::Tensor>& grad_output) override;
+  std::string name() const override { return largest_ ? "MaxFunction" : "MinFunction"; }
+
+private:
+  bool largest_;
+};
+
+/**
+ * NormFunction implements the p-norm over some dimensions.
+ */
+class NormFunction : public SumFunction {
+public:
+  NormFunction(double p, const tensor::DimVector& dims, bool keepdim)
+      : SumFunction(dims, keepdim), p_(p) {}
+
+  std::vector<tensor::Tensor> forward(const std::vector<tensor::Tensor>& inputs) override;
+  std::vector<tensor::Tensor> backward(const std::vector<tensor::Tensor>& grad_output) override;
+  std::string name() const override { return "NormFunction"; }
 
 private:
-  tensor::Tensor input1_;  // Save inputs for backward pass
-  tensor::Tensor input2_;
+  double p_;
 };
 
 }  // namespace autograd
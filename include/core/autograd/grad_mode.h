@@ -0,0 +1,81 @@
+#pragma once
+#ifndef AUTOGRAD_GRAD_MODE_H
+#define AUTOGRAD_GRAD_MODE_H
+
+namespace torchscratch {
+namespace core {
+namespace autograd {
+
+/**
+ * Whether operations on the calling thread record the autograd graph. When
+ * disabled, ops compute their result only: no Function is allocated, no input
+ * is saved and the result does not require gradients. Enabled by default on
+ * every thread.
+ */
+class GradMode {
+public:
+  static bool is_enabled();
+  static void set_enabled(bool enabled);
+};
+
+/**
+ * Sets the grad mode of the current thread for the guard's lifetime and
+ * restores the previous one on exit.
+ */
+class AutoGradMode {
+public:
+  explicit AutoGradMode(bool enabled);
+
+  AutoGradMode(const AutoGradMode&) = delete;
+  AutoGradMode& operator=(const AutoGradMode&) = delete;
+
+  ~AutoGradMode();
+
+private:
+  bool previous_;
+};
+
+/**
+ * Disables gradient recording on the current thread for the guard's lifetime:
+ *
+ *   {
+ *     NoGradGuard no_grad;
+ *     auto output = model.forward(x);  // output.requires_grad() == false
+ *   }
+ */
+class NoGradGuard : public AutoGradMode {
+public:
+  NoGradGuard() : AutoGradMode(false) {}
+};
+
+/**
+ * Scope for serving code. Disables gradient recording exactly like
+ * NoGradGuard, and sets the flag InferenceMode::is_enabled() reports for the
+ * current thread; nothing else behaves differently. InferenceMode(false)
+ * re-enables recording inside an enclosing scope. Each scope restores both
+ * settings on exit.
+ */
+class InferenceMode {
+public:
+  explicit InferenceMode(bool enabled = true);
+
+  InferenceMode(const InferenceMode&) = delete;
+  InferenceMode& operator=(const InferenceMode&) = delete;
+
+  ~InferenceMode();
+
+  /**
+   * Whether the calling thread is inside an enabled InferenceMode scope.
+   */
+  static bool is_enabled();
+
+private:
+  bool previous_inference_;
+  AutoGradMode grad_mode_;
+};
+
+}  // namespace autograd
+}  // namespace core
+}  // namespace torchscratch
+
+#endif  // AUTOGRAD_GRAD_MODE_H
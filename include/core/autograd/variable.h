@@ -3,18 +3,31 @@
 #define AUTOGRAD_VARIABLE_H
 
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "core/autograd/function.h"
+#include "core/autograd/grad_mode.h"
 #include "core/tensor/tensor.h"
 
 namespace torchscratch {
 namespace core {
 namespace autograd {
 
+/**
+ * Autograd state of a Variable, shared by all of its copies.
+ */
+struct AutogradMeta {
+  tensor::Tensor grad;                // Gradient with respect to the variable
+  bool requires_grad = false;         // Whether to track gradients for the variable
+  std::shared_ptr<Function> grad_fn;  // The function that created the variable
+  std::weak_ptr<Function> grad_accumulator;  // AccumulateGrad node of a leaf, while in use
+};
+
 /**
  * Variable wraps a Tensor and tracks gradient information for automatic differentiation.
- * It represents a node in the computational graph.
+ * It represents a node in the computational graph. Copies of a Variable share
+ * its gradient and grad_fn.
  */
 class Variable {
 public:
@@ -39,32 +52,39 @@ public:
   /**
    * Get the gradient tensor.
    */
-  const tensor::Tensor& grad() const { return grad_; }
+  const tensor::Tensor& grad() const { return meta_->grad; }
 
   /**
    * Set the gradient tensor.
    */
-  void set_grad(const tensor::Tensor& grad) { grad_ = grad; }
+  void set_grad(const tensor::Tensor& grad) { meta_->grad = grad; }
 
   /**
    * Check if this variable requires gradient computation.
    */
-  bool requires_grad() const { return requires_grad_; }
+  bool requires_grad() const { return meta_->requires_grad; }
 
   /**
    * Set whether this variable requires gradient computation.
    */
-  void set_requires_grad(bool requires_grad) { requires_grad_ = requires_grad; }
+  void set_requires_grad(bool requires_grad) { meta_->requires_grad = requires_grad; }
 
   /**
    * Get the gradient function that created this variable.
    */
-  std::shared_ptr<Function> grad_fn() const { return grad_fn_; }
+  std::shared_ptr<Function> grad_fn() const { return meta_->grad_fn; }
 
   /**
    * Set the gradient function for this variable.
    */
-  void set_grad_fn(std::shared_ptr<Function> grad_fn) { grad_fn_ = grad_fn; }
+  void set_grad_fn(std::shared_ptr<Function> grad_fn) { meta_->grad_fn = std::move(grad_fn); }
+
+  /**
+   * Graph edge a consumer of this variable sends its gradient along: the
+   * grad_fn, or for a leaf that requires gradients its AccumulateGrad node.
+   * Empty when the variable does not require gradients.
+   */
+  Edge gradient_edge() const;
 
   /**
    * Start backpropagation from this variable.
@@ -74,7 +94,7 @@ public:
   /**
    * Get the shape of the underlying tensor.
    */
-  const std::vector<int64_t>& shape() const { return data_.shape(); }
+  const tensor::DimVector& shape() const { return data_.shape(); }
 
   /**
    * Get the number of dimensions of the underlying tensor.
@@ -87,12 +107,43 @@ public:
   int64_t numel() const { return data_.numel(); }
 
 private:
-  tensor::Tensor data_;                // The tensor data
-  tensor::Tensor grad_;                // Gradient with respect to this variable
-  bool requires_grad_;                 // Whether to track gradients for this variable
-  std::shared_ptr<Function> grad_fn_;  // The function that created this variable
+  tensor::Tensor data_;                 // The tensor data
+  std::shared_ptr<AutogradMeta> meta_;  // Shared with copies of this variable
 };
 
+/**
+ * Run the Function F, constructed from args, on the inputs' data. When grad
+ * mode is on and an input requires gradients, F is allocated, connected to the
+ * inputs' graph nodes and made the grad_fn of the result; otherwise it is a
+ * temporary and nothing it saved outlives the call. Pass detach() of an input
+ * that must not receive a gradient.
+ */
+template <typename F, typename... Args>
+Variable apply_function(const std::vector<Variable>& inputs, Args&&... args) {
+  std::vector<tensor::Tensor> data;
+  data.reserve(inputs.size());
+  bool records = false;
+  for (const Variable& input : inputs) {
+    data.push_back(input.data());
+    records = records || input.requires_grad();
+  }
+  if (!records || !GradMode::is_enabled()) {
+    F func(std::forward<Args>(args)...);
+    return Variable(func.forward(data)[0]);
+  }
+
+  auto func = std::make_shared<F>(std::forward<Args>(args)...);
+  Variable result(func->forward(data)[0], true);
+  std::vector<Edge> edges;
+  edges.reserve(inputs.size());
+  for (const Variable& input : inputs) {
+    edges.push_back(input.gradient_edge());
+  }
+  func->set_next_edges(std::move(edges));
+  result.set_grad_fn(func);
+  return result;
+}
+
 /**
  * Element-wise addition of two variables.
  */
@@ -108,6 +159,21 @@ Variable mul(const Variable& a, const Variable& b);
  */
 Variable matmul(const Variable& a, const Variable& b);
 
+/**
+ * Batched matrix multiplication of two 3-D variables.
+ */
+Variable bmm(const Variable& a, const Variable& b);
+
+/**
+ * Reductions of a variable; see the tensor versions in core/tensor/ops.h.
+ */
+Variable sum(const Variable& a, const tensor::DimVector& dims = {}, bool keepdim = false);
+Variable mean(const Variable& a, const tensor::DimVector& dims = {}, bool keepdim = false);
+Variable max(const Variable& a, const tensor::DimVector& dims = {}, bool keepdim = false);
+Variable min(const Variable& a, const tensor::DimVector& dims = {}, bool keepdim = false);
+Variable norm(const Variable& a, double p = 2, const tensor::DimVector& dims = {},
+              bool keepdim = false);
+
 }  // namespace autograd
 }  // namespace core
 }  // namespace torchscratch
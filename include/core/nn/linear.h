@@ -4,11 +4,26 @@
 #include <vector>
 
 #include "core/autograd/variable.h"
+#include "core/tensor/gemm.h"
 
 namespace torchscratch {
 namespace core {
 namespace nn {
 
+using tensor::Activation;
+
+// Fused fully connected layer: activation(input @ weight.T + bias). The forward
+// pass applies bias and activation in the GEMM epilogue; the backward pass
+// computes the activation gradient and the bias gradient in one sweep (with no
+// activation, the incoming gradient is used as is and summed for the bias)
+autograd::Variable linear_act(const autograd::Variable& input, const autograd::Variable& weight,
+                              const autograd::Variable& bias,
+                              Activation activation = Activation::None);
+
+// Same without a bias
+autograd::Variable linear_act(const autograd::Variable& input, const autograd::Variable& weight,
+                              Activation activation = Activation::None);
+
 class Linear {
 public:
   Linear(int64_t in_features, int64_t out_features, bool bias = true);
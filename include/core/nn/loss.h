@@ -1,16 +1,50 @@
 #pragma once
 
+#include <string>
+
 #include "core/autograd/variable.h"
 
 namespace torchscratch {
 namespace core {
 namespace nn {
 
+/**
+ * How a loss combines its per-element terms: None keeps the input's shape,
+ * Sum and Mean return a single-element tensor.
+ */
+enum class Reduction {
+  None,
+  Sum,
+  Mean,
+};
+
+const char* reduction_name(Reduction reduction);
+
+/**
+ * Parse "none", "sum" or "mean". Throws on anything else.
+ */
+Reduction parse_reduction(const std::string& name);
+
 // Loss functions
-autograd::Variable mse_loss(const autograd::Variable& predicted, const autograd::Variable& target);
 
+/**
+ * Squared error between predicted and target. Same-shape float32 inputs are
+ * handled in a single vectorized pass each way, and backward only produces
+ * gradients for the inputs that require them.
+ */
+autograd::Variable mse_loss(const autograd::Variable& predicted, const autograd::Variable& target,
+                            Reduction reduction = Reduction::Mean);
+
+/**
+ * Softmax cross entropy between [batch, classes] float32 logits and one class
+ * index per row (Int32, or a float tensor holding whole numbers), averaged over
+ * the rows whose target is not ignore_index. label_smoothing in [0, 1] mixes
+ * the one-hot target with a uniform distribution. Softmax and log are fused, so
+ * no probability tensor is materialized in either pass.
+ */
 autograd::Variable cross_entropy_loss(const autograd::Variable& predicted,
-                                      const autograd::Variable& target);
+                                      const autograd::Variable& target,
+                                      float label_smoothing = 0.0f, int64_t ignore_index = -100);
 
 autograd::Variable binary_cross_entropy_loss(const autograd::Variable& predicted,
                                              const autograd::Variable& target);
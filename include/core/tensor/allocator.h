@@ -0,0 +1,92 @@
+#pragma once
+#ifndef TENSOR_ALLOCATOR_H
+#define TENSOR_ALLOCATOR_H
+
+#include <cstddef>  // For std::size_t
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace torchscratch {
+namespace core {
+namespace tensor {
+
+/**
+ * Counters reported by CachingAllocator::stats().
+ */
+struct AllocatorStats {
+  uint64_t hits = 0;                   // Allocations served from a free list
+  uint64_t misses = 0;                 // Allocations that went to the system allocator
+  std::size_t bytes_cached = 0;        // Bytes sitting in free lists
+  std::size_t bytes_in_use = 0;        // Bytes handed out and not yet returned
+  std::size_t peak_bytes_in_use = 0;   // High-water mark of bytes_in_use
+};
+
+/**
+ * Size-class caching allocator used for all tensor storage.
+ *
+ * Requests are rounded up to a size class (four classes per power of two) and
+ * freed blocks are parked on a per-class free list instead of being returned to
+ * the system, so the repeated same-sized allocations of a training step are
+ * served without touching malloc. Every block is aligned to kAlignment bytes.
+ */
+class CachingAllocator {
+public:
+  // Alignment of every returned block (one cache line / one AVX-512 register)
+  static constexpr std::size_t kAlignment = 64;
+
+  /**
+   * Process-wide allocator instance.
+   */
+  static CachingAllocator& instance();
+
+  CachingAllocator() = default;
+  CachingAllocator(const CachingAllocator&) = delete;
+  CachingAllocator& operator=(const CachingAllocator&) = delete;
+
+  ~CachingAllocator();
+
+  /**
+   * Allocate at least nbytes bytes.
+   */
+  void* allocate(std::size_t nbytes);
+
+  /**
+   * Return a block obtained from allocate(nbytes) with the same nbytes.
+   */
+  void deallocate(void* ptr, std::size_t nbytes);
+
+  /**
+   * Release every cached block back to the system.
+   */
+  void empty_cache();
+
+  /**
+   * Cap the number of bytes kept in free lists; blocks that would exceed the cap
+   * are released immediately. A cap of 0 disables caching.
+   */
+  void set_max_cached_bytes(std::size_t max_bytes);
+
+  AllocatorStats stats() const;
+  void reset_peak_stats();
+
+  /**
+   * Size class that a request of nbytes is rounded up to.
+   */
+  static std::size_t round_size(std::size_t nbytes);
+
+private:
+  void release_all_locked();
+
+  mutable std::mutex mutex_;
+  std::unordered_map<std::size_t, std::vector<void*>> free_blocks_;  // Keyed by size class
+  std::size_t max_cached_bytes_ = static_cast<std::size_t>(1) << 30;
+  AllocatorStats stats_;
+};
+
+}  // namespace tensor
+}  // namespace core
+}  // namespace torchscratch
+
+#endif  // TENSOR_ALLOCATOR_H
@@ -0,0 +1,121 @@
+#pragma once
+#ifndef TENSOR_ARENA_H
+#define TENSOR_ARENA_H
+
+#include <cstddef>  // For std::size_t
+#include <memory>
+#include <vector>
+
+#include "core/tensor/storage.h"
+
+namespace torchscratch {
+namespace core {
+namespace tensor {
+
+/**
+ * Bump allocator for tensors that live for a single training step.
+ *
+ * While a StepArena is active on a thread (see StepArenaGuard), every
+ * Tensor::allocate() on that thread carves its storage out of large chunks
+ * instead of calling the caching allocator. reset() rewinds all chunks in bulk.
+ *
+ * Each storage keeps its chunk alive, so a tensor that escapes the step (for
+ * example a loss value kept for logging) stays valid; its chunk is simply not
+ * reused until that tensor dies. Tensors created outside the guard (parameters,
+ * optimizer state) are unaffected.
+ */
+class StepArena {
+public:
+  /**
+   * @param chunk_size Size of each chunk in bytes; larger requests get their own chunk
+   */
+  explicit StepArena(std::size_t chunk_size = static_cast<std::size_t>(4) << 20);
+
+  StepArena(const StepArena&) = delete;
+  StepArena& operator=(const StepArena&) = delete;
+
+  ~StepArena();
+
+  /**
+   * Carve a storage of nbytes out of the current chunk.
+   */
+  std::shared_ptr<Storage> allocate(std::size_t nbytes);
+
+  /**
+   * Rewind every chunk that no tensor references any more; chunks still in use
+   * are handed over to their tensors and freed when the last one dies.
+   */
+  void reset();
+
+  /**
+   * Arena active on the calling thread, or nullptr.
+   */
+  static StepArena* current();
+
+  // Bytes handed out since the last reset
+  std::size_t bytes_used() const { return bytes_used_; }
+  // Total bytes held in chunks owned by the arena
+  std::size_t capacity() const;
+
+private:
+  friend class StepArenaGuard;
+
+  struct Chunk;
+
+  std::size_t chunk_size_;
+  std::vector<std::shared_ptr<Chunk>> chunks_;
+  std::size_t active_chunk_ = 0;  // Index of the chunk currently being bumped
+  std::size_t bytes_used_ = 0;
+};
+
+/**
+ * Activates a StepArena on the current thread for the guard's lifetime and
+ * resets it on exit:
+ *
+ *   StepArena arena;
+ *   for (...) {
+ *     StepArenaGuard guard(arena);
+ *     auto loss = mse_loss(model.forward(x), y);
+ *     loss.backward();
+ *     optimizer.step();
+ *   }
+ *
+ * Leaf gradients created by backward() inside the guard are moved to the heap,
+ * since they live across steps.
+ */
+class StepArenaGuard {
+public:
+  explicit StepArenaGuard(StepArena& arena);
+
+  StepArenaGuard(const StepArenaGuard&) = delete;
+  StepArenaGuard& operator=(const StepArenaGuard&) = delete;
+
+  ~StepArenaGuard();
+
+private:
+  StepArena& arena_;
+  StepArena* previous_;
+};
+
+/**
+ * Suspends the current thread's StepArena for the guard's lifetime, for
+ * tensors allocated inside a step that must outlive it.
+ */
+class NoStepArenaGuard {
+public:
+  NoStepArenaGuard();
+
+  NoStepArenaGuard(const NoStepArenaGuard&) = delete;
+  NoStepArenaGuard& operator=(const NoStepArenaGuard&) = delete;
+
+  ~NoStepArenaGuard();
+
+private:
+  StepArena* previous_;
+};
+
+}  // namespace tensor
+}  // namespace core
+}  // namespace torchscratch
+
+#endif  // TENSOR_ARENA_H
@@ -0,0 +1,233 @@
+#pragma once
+#ifndef TENSOR_DTYPE_H
+#define TENSOR_DTYPE_H
+
+#include <cstddef>  // For std::size_t
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace torchscratch {
+namespace core {
+namespace tensor {
+
+/**
+ * Element type of a tensor.
+ */
+enum class DType : int8_t {
+  Float32,
+  Float64,
+  Int32,
+  Int8,
+  BFloat16,
+  Float16,
+};
+
+/**
+ * Size of one element of the given type in bytes.
+ */
+std::size_t element_size(DType dtype);
+
+/**
+ * Human-readable name of the given type ("float32", "int8", ...).
+ */
+const char* dtype_name(DType dtype);
+
+/**
+ * Whether the type is a floating point type.
+ */
+bool is_floating_point(DType dtype);
+
+namespace detail {
+
+inline uint32_t float_bits(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+inline float bits_float(uint32_t bits) {
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+}  // namespace detail
+
+/**
+ * IEEE 754 binary16 storage type. Arithmetic goes through float.
+ */
+struct Half {
+  uint16_t bits = 0;
+
+  Half() = default;
+  Half(float value) : bits(from_float(value)) {}  // NOLINT: implicit like a builtin float
+  operator float() const { return to_float(bits); }
+
+  static uint16_t from_float(float value) {
+    uint32_t f = detail::float_bits(value);
+    uint32_t sign = (f >> 16) & 0x8000u;
+    uint32_t abs = f & 0x7fffffffu;
+    if (abs >= 0x7f800000u) {  // Inf or NaN
+      return static_cast<uint16_t>(sign | 0x7c00u | (abs > 0x7f800000u ? 0x200u : 0u));
+    }
+    if (abs >= 0x477ff000u) {  // Rounds past the largest half: overflow to inf
+      return static_cast<uint16_t>(sign | 0x7c00u);
+    }
+    if (abs < 0x38800000u) {  // Subnormal half (or zero)
+      // Adding 0.5 shifts the mantissa into place and rounds to nearest even
+      float shifted = detail::bits_float(abs) + 0.5f;
+      return static_cast<uint16_t>(sign | (detail::float_bits(shifted) - 0x3f000000u));
+    }
+    uint32_t mantissa_odd = (abs >> 13) & 1u;
+    abs += 0xc8000fffu + mantissa_odd;  // Rebias exponent and round to nearest even
+    return static_cast<uint16_t>(sign | (abs >> 13));
+  }
+
+  static float to_float(uint16_t h) {
+    uint32_t sign = static_cast<uint32_t>(h & 0x8000u) << 16;
+    uint32_t exponent = (h >> 10) & 0x1fu;
+    uint32_t mantissa = h & 0x3ffu;
+    if (exponent == 0x1fu) {  // Inf or NaN
+      return detail::bits_float(sign | 0x7f800000u | (mantissa << 13));
+    }
+    if (exponent == 0) {  // Zero or subnormal: mantissa * 2^-24
+      float magnitude = static_cast<float>(mantissa) * 5.9604644775390625e-8f;
+      return sign ? -magnitude : magnitude;
+    }
+    return detail::bits_float(sign | ((exponent + 112u) << 23) | (mantissa << 13));
+  }
+};
+
+/**
+ * bfloat16 storage type (upper half of a float32). Arithmetic goes through float.
+ */
+struct BFloat16 {
+  uint16_t bits = 0;
+
+  BFloat16() = default;
+  BFloat16(float value) : bits(from_float(value)) {}  // NOLINT: implicit like a builtin float
+  operator float() const { return detail::bits_float(static_cast<uint32_t>(bits) << 16); }
+
+  static uint16_t from_float(float value) {
+    uint32_t f = detail::float_bits(value);
+    if ((f & 0x7fffffffu) > 0x7f800000u) {  // Keep NaN a NaN
+      return static_cast<uint16_t>((f >> 16) | 0x40u);
+    }
+    f += 0x7fffu + ((f >> 16) & 1u);  // Round to nearest even
+    return static_cast<uint16_t>(f >> 16);
+  }
+};
+
+/**
+ * Maps a C++ element type to its DType.
+ */
+template <typename T>
+struct dtype_of;
+
+template <>
+struct dtype_of<float> {
+  static constexpr DType value = DType::Float32;
+};
+template <>
+struct dtype_of<double> {
+  static constexpr DType value = DType::Float64;
+};
+template <>
+struct dtype_of<int32_t> {
+  static constexpr DType value = DType::Int32;
+};
+template <>
+struct dtype_of<int8_t> {
+  static constexpr DType value = DType::Int8;
+};
+template <>
+struct dtype_of<BFloat16> {
+  static constexpr DType value = DType::BFloat16;
+};
+template <>
+struct dtype_of<Half> {
+  static constexpr DType value = DType::Float16;
+};
+
+/**
+ * Type that kernels accumulate and compute in for a given element type:
+ * reduced-precision floats widen to float, integers widen to int64_t.
+ */
+template <typename T>
+struct acc_type {
+  using type = T;
+};
+template <>
+struct acc_type<Half> {
+  using type = float;
+};
+template <>
+struct acc_type<BFloat16> {
+  using type = float;
+};
+template <>
+struct acc_type<int8_t> {
+  using type = int64_t;
+};
+template <>
+struct acc_type<int32_t> {
+  using type = int64_t;
+};
+
+[[noreturn]] inline void throw_unsupported_dtype(const char* op, DType dtype) {
+  throw std::runtime_error(std::string(op) + ": unsupported dtype " + dtype_name(dtype));
+}
+
+}  // namespace tensor
+}  // namespace core
+}  // namespace torchscratch
+
+/**
+ * Kernel dispatch over element types.
+ *
+ * Expands the given lambda once per supported type with `scalar_t` bound to the
+ * element type of DTYPE, and calls the matching instantiation:
+ *
+ *   TS_DISPATCH_ALL_TYPES(a.dtype(), "add", [&] { add_kernel<scalar_t>(a, b, out); });
+ */
+#define TS_DISPATCH_CASE(ENUM, TYPE, ...) \
+  case ENUM: {                            \
+    using scalar_t = TYPE;                \
+    return __VA_ARGS__();                 \
+  }
+
+#define TS_DISPATCH_FLOATING_TYPES(DTYPE, NAME, ...)                                          \
+  [&] {                                                                                     \
+    const ::torchscratch::core::tensor::DType dispatch_dtype_ = (DTYPE);                    \
+    switch (dispatch_dtype_) {                                                              \
+      TS_DISPATCH_CASE(::torchscratch::core::tensor::DType::Float32, float, __VA_ARGS__)    \
+      TS_DISPATCH_CASE(::torchscratch::core::tensor::DType::Float64, double, __VA_ARGS__)   \
+      TS_DISPATCH_CASE(::torchscratch::core::tensor::DType::BFloat16,                       \
+                       ::torchscratch::core::tensor::BFloat16, __VA_ARGS__)                 \
+      TS_DISPATCH_CASE(::torchscratch::core::tensor::DType::Float16,                        \
+                       ::torchscratch::core::tensor::Half, __VA_ARGS__)                     \
+      default:                                                                              \
+        ::torchscratch::core::tensor::throw_unsupported_dtype(NAME, dispatch_dtype_);       \
+    }                                                                                       \
+  }()
+
+#define TS_DISPATCH_ALL_TYPES(DTYPE, NAME, ...)                                             \
+  [&] {                                                                                     \
+    const ::torchscratch::core::tensor::DType dispatch_dtype_ = (DTYPE);                    \
+    switch (dispatch_dtype_) {                                                              \
+      TS_DISPATCH_CASE(::torchscratch::core::tensor::DType::Float32, float, __VA_ARGS__)    \
+      TS_DISPATCH_CASE(::torchscratch::core::tensor::DType::Float64, double, __VA_ARGS__)   \
+      TS_DISPATCH_CASE(::torchscratch::core::tensor::DType::Int32, int32_t, __VA_ARGS__)    \
+      TS_DISPATCH_CASE(::torchscratch::core::tensor::DType::Int8, int8_t, __VA_ARGS__)      \
+      TS_DISPATCH_CASE(::torchscratch::core::tensor::DType::BFloat16,                       \
+                       ::torchscratch::core::tensor::BFloat16, __VA_ARGS__)                 \
+      TS_DISPATCH_CASE(::torchscratch::core::tensor::DType::Float16,                        \
+                       ::torchscratch::core::tensor::Half, __VA_ARGS__)                     \
+      default:                                                                              \
+        ::torchscratch::core::tensor::throw_unsupported_dtype(NAME, dispatch_dtype_);       \
+    }                                                                                       \
+  }()
+
+#endif  // TENSOR_DTYPE_H
@@ -0,0 +1,102 @@
+#pragma once
+#ifndef TENSOR_GEMM_H
+#define TENSOR_GEMM_H
+
+#include <cstdint>
+
+namespace torchscratch {
+namespace core {
+namespace tensor {
+
+/**
+ * Instruction sets the float32 GEMM micro-kernel can use, in increasing order.
+ */
+enum class GemmIsa {
+  Scalar,  // Portable C++; the compiler may still auto-vectorize
+  AVX2,    // 256-bit FMA
+  AVX512,  // 512-bit FMA (AVX-512F)
+};
+
+const char* gemm_isa_name(GemmIsa isa);
+
+/**
+ * Best instruction set supported by the running CPU.
+ */
+GemmIsa gemm_max_isa();
+
+/**
+ * Instruction set the float32 kernel currently uses. Defaults to gemm_max_isa().
+ */
+GemmIsa gemm_isa();
+
+/**
+ * Force a (lower) instruction set, e.g. to compare paths or work around a
+ * suspected miscompile. Throws if the CPU does not support it.
+ */
+void set_gemm_isa(GemmIsa isa);
+
+/**
+ * Element-wise activation a GEMM epilogue can apply.
+ */
+enum class Activation {
+  None,
+  ReLU,
+  Sigmoid,
+  Tanh,
+};
+
+/**
+ * Work folded into the GEMM write-back while a tile is still in registers:
+ * C[i, j] = activation(C[i, j] + bias[j * bias_stride]). bias may be null.
+ */
+template <typename scalar_t>
+struct GemmEpilogue {
+  const scalar_t* bias = nullptr;
+  int64_t bias_stride = 1;
+  Activation activation = Activation::None;
+};
+
+/**
+ * C = A @ B, or C += A @ B when accumulate is set, for A: [m, k], B: [k, n],
+ * C: [m, n]. Every matrix is addressed through a row and a column stride in
+ * elements, so transposed views are consumed without a copy.
+ *
+ * GotoBLAS-style blocking: B is packed into k x NR column panels sized for L3,
+ * A into MR x k row panels sized for L2, and an MR x NR register tile is
+ * computed with the micro-kernel for gemm_isa(). Half and BFloat16 are
+ * widened to float while packing; double uses a scalar micro-kernel.
+ *
+ * Large products run on the intra-op pool (see parallel.h): threads pack B
+ * together, then each computes its own blocks of MC rows by a group of
+ * NR-wide panels against the shared packed B.
+ *
+ * A non-null epilogue is applied to the final sums (after accumulation into C).
+ *
+ * Instantiated for float, double, Half and BFloat16.
+ */
+template <typename scalar_t>
+void gemm(int64_t m, int64_t n, int64_t k, const scalar_t* a, int64_t a_row_stride,
+          int64_t a_col_stride, const scalar_t* b, int64_t b_row_stride, int64_t b_col_stride,
+          scalar_t* c, int64_t c_row_stride, int64_t c_col_stride, bool accumulate = false,
+          const GemmEpilogue<scalar_t>* epilogue = nullptr);
+
+/**
+ * gemm() over a batch of matrices that share m, n, k and the row/column
+ * strides: matrix i of A starts at a + a_offsets[i], and likewise for B and C.
+ * Repeated offsets express broadcast batch dimensions without copies.
+ *
+ * Blocks of all matrices are scheduled together on the intra-op pool, so many
+ * small products parallelize as well as one large one.
+ */
+template <typename scalar_t>
+void gemm_batched(int64_t batch, int64_t m, int64_t n, int64_t k, const scalar_t* a,
+                  const int64_t* a_offsets, int64_t a_row_stride, int64_t a_col_stride,
+                  const scalar_t* b, const int64_t* b_offsets, int64_t b_row_stride,
+                  int64_t b_col_stride, scalar_t* c, const int64_t* c_offsets,
+                  int64_t c_row_stride, int64_t c_col_stride, bool accumulate = false);
+
+}  // namespace tensor
+}  // namespace core
+}  // namespace torchscratch
+
+#endif  // TENSOR_GEMM_H
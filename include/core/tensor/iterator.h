@@ -0,0 +1,109 @@
+#pragma once
+#ifndef TENSOR_ITERATOR_H
+#define TENSOR_ITERATOR_H
+
+#include <cstdint>
+#include <initializer_list>
+
+#include "core/tensor/small_vector.h"
+#include "core/tensor/tensor.h"
+
+namespace torchscratch {
+namespace core {
+namespace tensor {
+
+/**
+ * Shape that a and b broadcast to under NumPy rules: shapes are aligned on the
+ * right and each pair of sizes must match or contain a 1. Throws if the shapes
+ * are incompatible.
+ */
+DimVector broadcast_shapes(const DimVector& a, const DimVector& b);
+
+/**
+ * Walks several tensors of the same dtype over a common broadcast shape without
+ * materializing expanded copies.
+ *
+ * Every operand is viewed with stride 0 along the dimensions it is broadcast
+ * over. Size-1 dimensions are dropped and neighbouring dimensions that are laid
+ * out contiguously for every operand are merged, so a dense op over any shape
+ * becomes a single inner loop, and [B, F] + [F] becomes B loops of length F.
+ *
+ * Operand 0 is conventionally the output. Giving it stride 0 along some
+ * dimensions (a smaller shape broadcast to the full one) turns the walk into a
+ * reduction; see sum_to().
+ */
+class TensorIterator {
+public:
+  static constexpr int kMaxOperands = 3;
+
+  /**
+   * @param shape Shape to iterate over; every operand must broadcast to it
+   * @param operands Allocated tensors, at most kMaxOperands of them
+   */
+  TensorIterator(const DimVector& shape, std::initializer_list<const Tensor*> operands);
+
+  // Broadcast shape being iterated
+  const DimVector& shape() const { return shape_; }
+  int64_t numel() const { return numel_; }
+  int num_operands() const { return num_operands_; }
+  // Number of dimensions left after coalescing
+  int64_t ndim() const { return static_cast<int64_t>(sizes_.size()); }
+
+  /**
+   * Invoke loop(data, strides, n) once per run of the innermost dimension.
+   * data[i] points at the first element of operand i in the run, strides[i] is
+   * the byte distance between its consecutive elements (0 when broadcast), and n
+   * is the run length.
+   */
+  template <typename Loop>
+  void for_each(Loop&& loop) const;
+
+private:
+  DimVector shape_;
+  int64_t numel_ = 0;
+  int num_operands_ = 0;
+  char* data_[kMaxOperands] = {};
+  // Coalesced sizes and per-operand byte strides, innermost dimension first
+  DimVector sizes_;
+  DimVector strides_[kMaxOperands];
+};
+
+template <typename Loop>
+void TensorIterator::for_each(Loop&& loop) const {
+  if (numel_ == 0) {
+    return;
+  }
+
+  char* data[kMaxOperands];
+  int64_t inner_strides[kMaxOperands] = {};
+  for (int op = 0; op < num_operands_; ++op) {
+    data[op] = data_[op];
+    inner_strides[op] = sizes_.empty() ? 0 : strides_[op][0];
+  }
+  const int64_t inner = sizes_.empty() ? 1 : sizes_[0];
+
+  // Odometer over the outer dimensions, advancing the data pointers incrementally
+  DimVector counter(sizes_.size(), 0);
+  for (int64_t done = 0; done < numel_; done += inner) {
+    loop(data, inner_strides, inner);
+
+    for (std::size_t dim = 1; dim < sizes_.size(); ++dim) {
+      for (int op = 0; op < num_operands_; ++op) {
+        data[op] += strides_[op][dim];
+      }
+      if (++counter[dim] < sizes_[dim]) {
+        break;
+      }
+      for (int op = 0; op < num_operands_; ++op) {
+        data[op] -= strides_[op][dim] * sizes_[dim];
+      }
+      counter[dim] = 0;
+    }
+  }
+}
+
+}  // namespace tensor
+}  // namespace core
+}  // namespace torchscratch
+
+#endif  // TENSOR_ITERATOR_H
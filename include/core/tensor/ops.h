@@ -2,11 +2,14 @@
 #ifndef TENSOR_OPS_H
 #define TENSOR_OPS_H
 
+#include "core/tensor/gemm.h"
+#include "core/tensor/iterator.h"
 #include "core/tensor/tensor.h"
 
 namespace torchscratch::core::tensor {
 
 // Core tensor operations
+// Element-wise ops broadcast their inputs NumPy-style (see broadcast_shapes)
 // Addition: Element-wise addition of two tensors
 Tensor add(const Tensor& a, const Tensor& b);
 
@@ -16,12 +19,83 @@ Tensor sub(const Tensor& a, const Tensor& b);
 // Multiplication: Element-wise multiplication of two tensors
 Tensor mul(const Tensor& a, const Tensor& b);
 
-// Matrix multiplication
-Tensor matmul(const Tensor& a, const Tensor& b);
+// Matrix multiplication: a [..., m, k] @ b [..., k, n]. Operands with more than
+// two dimensions are batches of matrices; their leading dimensions broadcast.
+// trans_a / trans_b use the operand with its last two dimensions swapped (NN,
+// NT, TN, TT); the GEMM packs straight from the untransposed memory
+Tensor matmul(const Tensor& a, const Tensor& b, bool trans_a = false, bool trans_b = false);
+
+// Batched matrix multiplication of 3-D tensors: [B, m, k] @ [B, k, n] -> [B, m, n].
+// A batch dimension of 1 broadcasts against the other operand's
+Tensor bmm(const Tensor& a, const Tensor& b);
+
+// Fully connected layer: activation(input @ weight.T + bias) for input [..., in],
+// weight [out, in] and bias [out], or an unallocated bias for none. Bias and
+// activation run in the GEMM epilogue, so the output is written exactly once.
+// Floating-point dtypes only
+Tensor linear_act(const Tensor& input, const Tensor& weight, const Tensor& bias,
+                  Activation activation = Activation::None);
 
 // Transpose: Swap two dimensions of a tensor
 Tensor transpose(const Tensor& a, int dim0 = 0, int dim1 = 1);
 
+// View of a broadcast to shape, with stride 0 along the broadcast dimensions.
+// No data is copied; use contiguous() for a dense tensor
+Tensor expand(const Tensor& a, const DimVector& shape);
+
+// Sum a over the dimensions along which shape was broadcast, producing a tensor
+// of that shape; the reverse of broadcasting, used by autograd. Returns a itself
+// when the shapes already match.
+Tensor sum_to(const Tensor& a, const DimVector& shape);
+
+// Reductions. dims lists the dimensions to reduce, negative values counting from
+// the end; an empty list reduces over all of them. keepdim leaves the reduced
+// dimensions in place with size 1. Accumulation is pairwise and split over the
+// intra-op pool in chunks fixed by the shape, so results do not depend on the
+// number of threads
+//
+// The result has the input's dtype. Integer sums are accumulated in int64_t and
+// throw if the total does not fit the input dtype instead of wrapping around
+Tensor sum(const Tensor& a, const DimVector& dims = {}, bool keepdim = false);
+// Floating-point dtypes only
+Tensor mean(const Tensor& a, const DimVector& dims = {}, bool keepdim = false);
+// NaN propagates. Throws when reducing over a zero-size dimension
+Tensor max(const Tensor& a, const DimVector& dims = {}, bool keepdim = false);
+Tensor min(const Tensor& a, const DimVector& dims = {}, bool keepdim = false);
+// p-norm (sum |x|^p)^(1/p) for p > 0; p = INFINITY gives max |x|. Floating-point
+// dtypes only
+Tensor norm(const Tensor& a, double p = 2, const DimVector& dims = {}, bool keepdim = false);
+// Int32 index of the first maximum along dim, NaN counting as the maximum
+Tensor argmax(const Tensor& a, int64_t dim, bool keepdim = false);
+// Index into the flattened tensor
+Tensor argmax(const Tensor& a);
+
+// Out variants: write the result into out instead of allocating a new tensor.
+// An unallocated out is allocated with the result shape; otherwise it must
+// already have that shape and dtype, and may be any non-expanded view.
+// Element-wise variants allow out to be one of the inputs. Each returns out
+// and bumps its version.
+Tensor& add_out(Tensor& out, const Tensor& a, const Tensor& b);
+Tensor& sub_out(Tensor& out, const Tensor& a, const Tensor& b);
+Tensor& mul_out(Tensor& out, const Tensor& a, const Tensor& b);
+// out must not share storage with a or b
+Tensor& matmul_out(Tensor& out, const Tensor& a, const Tensor& b, bool trans_a = false,
+                   bool trans_b = false);
+Tensor& bmm_out(Tensor& out, const Tensor& a, const Tensor& b);
+
+// In-place variants: overwrite self with the result and bump its version. other
+// may broadcast to self, but not the other way round
+// self += other
+Tensor& add_(Tensor& self, const Tensor& other);
+// self -= other
+Tensor& sub_(Tensor& self, const Tensor& other);
+// self *= other
+Tensor& mul_(Tensor& self, const Tensor& other);
+// self *= alpha
+Tensor& scale_(Tensor& self, double alpha);
+// self += alpha * x, for x of the same shape as self
+Tensor& axpy_(Tensor& self, double alpha, const Tensor& x);
+
 }  // namespace torchscratch::core::tensor
 
 #endif  // TENSOR_OPS_H
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+#ifndef TENSOR_PARALLEL_H
+#define TENSOR_PARALLEL_H
+
+#include <cstdint>
+#include <functional>
+
+namespace torchscratch {
+namespace core {
+namespace tensor {
+
+/**
+ * Number of threads intra-op parallel kernels may use, including the calling
+ * thread. Defaults to the number of hardware threads.
+ */
+int get_num_threads();
+
+/**
+ * Resize the intra-op thread pool. 1 makes every kernel single-threaded.
+ */
+void set_num_threads(int num_threads);
+
+/**
+ * Whether the calling thread is running a chunk of a parallel_for.
+ */
+bool in_parallel_region();
+
+/**
+ * Split [begin, end) into at most get_num_threads() contiguous chunks of at
+ * least grain_size elements and call fn(chunk_begin, chunk_end) for each on the
+ * intra-op pool, the calling thread included. Returns once every chunk is done
+ * and rethrows the first exception a chunk threw.
+ *
+ * Runs fn(begin, end) inline when the range is a single grain, when only one
+ * thread is allowed, and when called from inside another parallel_for.
+ */
+void parallel_for(int64_t begin, int64_t end, int64_t grain_size,
+                  const std::function<void(int64_t, int64_t)>& fn);
+
+}  // namespace tensor
+}  // namespace core
+}  // namespace torchscratch
+
+#endif  // TENSOR_PARALLEL_H
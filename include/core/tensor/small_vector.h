@@ -0,0 +1,208 @@
+#pragma once
+#ifndef TENSOR_SMALL_VECTOR_H
+#define TENSOR_SMALL_VECTOR_H
+
+#include <algorithm>
+#include <cstddef>  // For std::size_t
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+namespace torchscratch {
+namespace core {
+namespace tensor {
+
+/**
+ * Vector that stores up to N elements inline and only touches the heap beyond
+ * that. Used for tensor shapes and strides so that creating or copying tensor
+ * metadata does not allocate.
+ */
+template <typename T, std::size_t N>
+class SmallVector {
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using iterator = T*;
+  using const_iterator = const T*;
+  using reference = T&;
+  using const_reference = const T&;
+
+  SmallVector() {}
+
+  explicit SmallVector(size_type count, const T& value = T()) { assign(count, value); }
+
+  SmallVector(std::initializer_list<T> values) { assign(values.begin(), values.end()); }
+
+  template <typename InputIt,
+            typename = typename std::iterator_traits<InputIt>::iterator_category>
+  SmallVector(InputIt first, InputIt last) {
+    assign(first, last);
+  }
+
+  // Implicit, so existing call sites can keep passing std::vector shapes
+  SmallVector(const std::vector<T>& values) {  // NOLINT(google-explicit-constructor)
+    assign(values.begin(), values.end());
+  }
+
+  SmallVector(const SmallVector& other) { assign(other.begin(), other.end()); }
+
+  SmallVector(SmallVector&& other) noexcept { move_from(other); }
+
+  SmallVector& operator=(const SmallVector& other) {
+    if (this != &other) {
+      assign(other.begin(), other.end());
+    }
+    return *this;
+  }
+
+  SmallVector& operator=(SmallVector&& other) noexcept {
+    if (this != &other) {
+      move_from(other);
+    }
+    return *this;
+  }
+
+  ~SmallVector() = default;
+
+  // Implicit, so callers that need a std::vector (Python bindings, tests) still work
+  operator std::vector<T>() const { return std::vector<T>(begin(), end()); }  // NOLINT
+
+  template <typename InputIt>
+  void assign(InputIt first, InputIt last) {
+    size_type count = static_cast<size_type>(std::distance(first, last));
+    reserve_discard(count);
+    std::copy(first, last, data());
+    size_ = count;
+  }
+
+  void assign(size_type count, const T& value) {
+    reserve_discard(count);
+    std::fill(data(), data() + count, value);
+    size_ = count;
+  }
+
+  T* data() { return heap_ ? heap_.get() : inline_; }
+  const T* data() const { return heap_ ? heap_.get() : inline_; }
+
+  size_type size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  size_type capacity() const { return heap_ ? heap_capacity_ : N; }
+  static constexpr size_type inline_capacity() { return N; }
+  bool is_inline() const { return !heap_; }
+
+  iterator begin() { return data(); }
+  iterator end() { return data() + size_; }
+  const_iterator begin() const { return data(); }
+  const_iterator end() const { return data() + size_; }
+
+  T& operator[](size_type i) { return data()[i]; }
+  const T& operator[](size_type i) const { return data()[i]; }
+
+  T& front() { return data()[0]; }
+  const T& front() const { return data()[0]; }
+  T& back() { return data()[size_ - 1]; }
+  const T& back() const { return data()[size_ - 1]; }
+
+  void push_back(const T& value) {
+    if (size_ == capacity()) {
+      grow(size_ * 2);
+    }
+    data()[size_++] = value;
+  }
+
+  void pop_back() { --size_; }
+
+  void resize(size_type count, const T& value = T()) {
+    if (count > capacity()) {
+      grow(count);
+    }
+    if (count > size_) {
+      std::fill(data() + size_, data() + count, value);
+    }
+    size_ = count;
+  }
+
+  void clear() { size_ = 0; }
+
+private:
+  // Make room for count elements without preserving the current contents
+  void reserve_discard(size_type count) {
+    if (count <= N) {
+      heap_.reset();
+      heap_capacity_ = 0;
+    } else if (count > capacity() || !heap_) {
+      heap_.reset(new T[count]);
+      heap_capacity_ = count;
+    }
+  }
+
+  void grow(size_type min_capacity) {
+    size_type new_capacity = std::max(min_capacity, std::max<size_type>(N * 2, 1));
+    std::unique_ptr<T[]> bigger(new T[new_capacity]);
+    std::copy(begin(), end(), bigger.get());
+    heap_ = std::move(bigger);
+    heap_capacity_ = new_capacity;
+  }
+
+  void move_from(SmallVector& other) {
+    if (other.heap_) {
+      heap_ = std::move(other.heap_);
+      heap_capacity_ = other.heap_capacity_;
+    } else {
+      heap_.reset();
+      heap_capacity_ = 0;
+      std::copy(other.begin(), other.end(), inline_);
+    }
+    size_ = other.size_;
+    other.size_ = 0;
+    other.heap_capacity_ = 0;
+  }
+
+  T inline_[N];
+  size_type size_ = 0;
+  std::unique_ptr<T[]> heap_;  // Only used beyond N elements
+  size_type heap_capacity_ = 0;
+};
+
+template <typename T, std::size_t N>
+bool operator==(const SmallVector<T, N>& a, const SmallVector<T, N>& b) {
+  return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+}
+
+template <typename T, std::size_t N>
+bool operator!=(const SmallVector<T, N>& a, const SmallVector<T, N>& b) {
+  return !(a == b);
+}
+
+template <typename T, std::size_t N>
+bool operator==(const SmallVector<T, N>& a, const std::vector<T>& b) {
+  return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+}
+
+template <typename T, std::size_t N>
+bool operator==(const std::vector<T>& a, const SmallVector<T, N>& b) {
+  return b == a;
+}
+
+template <typename T, std::size_t N>
+bool operator!=(const SmallVector<T, N>& a, const std::vector<T>& b) {
+  return !(a == b);
+}
+
+template <typename T, std::size_t N>
+bool operator!=(const std::vector<T>& a, const SmallVector<T, N>& b) {
+  return !(b == a);
+}
+
+// Tensors with up to this many dimensions keep their metadata inline
+constexpr std::size_t kMaxInlineDims = 6;
+
+using DimVector = SmallVector<int64_t, kMaxInlineDims>;
+
+}  // namespace tensor
+}  // namespace core
+}  // namespace torchscratch
+
+#endif  // TENSOR_SMALL_VECTOR_H
@@ -0,0 +1,101 @@
+#pragma once
+#ifndef TENSOR_STORAGE_H
+#define TENSOR_STORAGE_H
+
+#include <atomic>
+#include <cstddef>  // For std::size_t
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace torchscratch {
+namespace core {
+namespace tensor {
+
+/**
+ * How a file is mapped by Storage::map_file().
+ */
+enum class MmapMode {
+  ReadOnly,     // Shared, read-only pages; in-place and out= ops on the tensor throw
+  CopyOnWrite,  // Private pages; writes stay in this process and never reach the file
+};
+
+/**
+ * Reference-counted buffer backing one or more tensors.
+ *
+ * A Storage is always held through std::shared_ptr. Every Tensor that views the
+ * buffer (copies, reshapes, transposes) shares the same Storage, so the memory is
+ * released exactly once, when the last view goes away.
+ *
+ * The storage also carries a version counter that every in-place write bumps.
+ * Because it lives here rather than on the Tensor, a write through any view is
+ * visible to all the others, which is what autograd needs to notice that a
+ * tensor saved for backward was modified.
+ */
+class Storage {
+public:
+  using Deleter = std::function<void(void*)>;
+
+  /**
+   * Wrap an existing buffer.
+   * @param data Pointer to the buffer
+   * @param nbytes Size of the buffer in bytes
+   * @param deleter Called with data when the storage dies; empty for borrowed memory
+   */
+  Storage(void* data, std::size_t nbytes, Deleter deleter = nullptr);
+
+  Storage(const Storage&) = delete;
+  Storage& operator=(const Storage&) = delete;
+  Storage(Storage&&) = delete;
+  Storage& operator=(Storage&&) = delete;
+
+  ~Storage();
+
+  /**
+   * Allocate a new owning storage of the given size, from the thread's active
+   * StepArena if there is one and from the caching allocator otherwise.
+   */
+  static std::shared_ptr<Storage> allocate(std::size_t nbytes);
+
+  /**
+   * Wrap memory owned by someone else. The caller keeps it alive.
+   */
+  static std::shared_ptr<Storage> borrow(void* data, std::size_t nbytes = 0);
+
+  /**
+   * Map nbytes of a file starting at offset. Pages are loaded lazily from the page
+   * cache and shared between processes mapping the same file; the mapping is
+   * released when the storage dies.
+   */
+  static std::shared_ptr<Storage> map_file(const std::string& path, std::size_t offset,
+                                           std::size_t nbytes, MmapMode mode);
+
+  void* data() const { return data_; }
+  std::size_t nbytes() const { return nbytes_; }
+  bool owns_data() const { return static_cast<bool>(deleter_); }
+  // Carved out of a StepArena chunk, so it pins that chunk while alive
+  bool from_arena() const { return from_arena_; }
+  // Mapped with MmapMode::ReadOnly; ops refuse to write to it
+  bool read_only() const { return read_only_; }
+
+  // Number of in-place writes to this buffer so far
+  uint64_t version() const { return version_.load(std::memory_order_relaxed); }
+  void bump_version() { version_.fetch_add(1, std::memory_order_relaxed); }
+
+private:
+  friend class StepArena;
+
+  void* data_;
+  std::size_t nbytes_;
+  Deleter deleter_;
+  std::atomic<uint64_t> version_{0};
+  bool from_arena_ = false;
+  bool read_only_ = false;
+};
+
+}  // namespace tensor
+}  // namespace core
+}  // namespace torchscratch
+
+#endif  // TENSOR_STORAGE_H
@@ -2,11 +2,14 @@
 #ifndef TENSOR_H
 #define TENSOR_H
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <stdexcept>
+#include <string>
 #include <vector>
 
+#include "core/tensor/dtype.h"
 #include "core/tensor/tensor_impl.h"
 
 namespace torchscratch {
@@ -14,7 +17,6 @@ namespace core {
 namespace tensor {
 
 class TensorImpl;
-class DType;
 
 // Forward declaration for the accessor class
 template <typename T>
@@ -24,9 +26,9 @@ class Tensor {
 public:
   Tensor() = default;
 
-  explicit Tensor(const std::vector<int64_t>& shape, DType* dtype = nullptr);
+  explicit Tensor(const DimVector& shape, DType dtype = DType::Float32);
 
-  Tensor(void* data, const std::vector<int64_t>& shape, DType* dtype = nullptr);
+  Tensor(void* data, const DimVector& shape, DType dtype = DType::Float32);
 
   Tensor(const Tensor& other);
   Tensor(Tensor&& other) noexcept;
@@ -36,28 +38,78 @@ public:
 
   ~Tensor();
 
-  const std::vector<int64_t>& shape() const;
-  const std::vector<int64_t>& strides() const;
+  /**
+   * Create a tensor backed by a memory-mapped file instead of heap memory.
+   * @param path File to map
+   * @param offset Byte offset of the first element in the file
+   * @param shape Shape of the tensor (row-major, contiguous in the file)
+   * @param dtype Element type stored in the file
+   * @param mode ReadOnly shares pages with other processes; CopyOnWrite allows writes
+   */
+  static Tensor from_mmap(const std::string& path, int64_t offset,
+                          const DimVector& shape, DType dtype = DType::Float32,
+                          MmapMode mode = MmapMode::ReadOnly);
+
+  const DimVector& shape() const;
+  const DimVector& strides() const;
 
   int64_t dim() const;
   int64_t numel() const;
 
+  DType dtype() const;
+
+  // Size of one element and of the whole tensor, in bytes
+  int64_t itemsize() const;
+  int64_t nbytes() const;
+
+  // Alignment (bytes) of data_ptr() for every tensor created by allocate()
+  static constexpr std::size_t kAlignment = 64;
+
   void* data_ptr() const;
+  // Typed access; throws if T does not match dtype()
   template <typename T>
   T* data_ptr() const;
 
   static bool is_cuda() { return false; }
+
+  /**
+   * Allocate nbytes() of storage. The data pointer is aligned to kAlignment, so
+   * kernels may use aligned vector loads and stores on freshly allocated tensors
+   * (views with a non-zero storage offset are not guaranteed to be aligned).
+   */
   void allocate();
   void deallocate();
 
-  Tensor reshape(const std::vector<int64_t>& new_shape) const;
+  // Views share storage with this tensor and keep it alive. Reshaping a
+  // non-contiguous view has to copy, and returns a reshaped contiguous() copy
+  Tensor reshape(const DimVector& new_shape) const;
+  Tensor as_strided(const DimVector& shape, const DimVector& strides,
+                    int64_t storage_offset) const;
+  // Dense row-major copy of the data, whatever the layout of this view
   Tensor clone() const;
 
+  /**
+   * This tensor if it is already contiguous, otherwise a dense copy made with a
+   * cache-blocked kernel. Use it in front of kernels that cannot consume strides.
+   */
+  Tensor contiguous() const;
+
+  // Contiguous copy converted to the given element type
+  Tensor to(DType dtype) const;
+
   bool is_contiguous() const;
 
+  // Underlying refcounted buffer (null until allocated)
+  const std::shared_ptr<Storage>& storage() const;
+  int64_t storage_offset() const;
+
+  // Version counter of the storage, shared by all views; bumped by in-place ops
+  uint64_t version() const;
+  void bump_version() const;
+
   // New methods to expose TensorImpl functionality
   void set_data_ptr(void* data);
-  void set_strides(const std::vector<int64_t>& strides);
+  void set_strides(const DimVector& strides);
   void set_contiguous(bool is_contiguous);
 
   // Add accessor method for transposed tensors
@@ -114,18 +166,6 @@ TransposedTensorAccessor<T> Tensor::transposed_accessor() const {
   return TransposedTensorAccessor<T>(*this);
 }
 
-class DType {
-public:
-  virtual ~DType() = default;
-
-  // Rule of 5: Implement copy/move operations
-  DType() = default;
-  DType(const DType&) = default;
-  DType& operator=(const DType&) = default;
-  DType(DType&&) noexcept = default;
-  DType& operator=(DType&&) noexcept = default;
-};
-
 }  // namespace tensor
 }  // namespace core
 }  // namespace torchscratch
@@ -4,60 +4,83 @@
 
 #include <cstddef>  // For std::size_t
 #include <cstdint>
+#include <memory>
 #include <vector>
 
+#include "core/tensor/dtype.h"
+#include "core/tensor/small_vector.h"
+#include "core/tensor/storage.h"
+
 namespace torchscratch {
 namespace core {
 namespace tensor {
 
-class DType;
-
 /**
  * Internal implementation for Tensor class.
+ *
+ * A TensorImpl is a view: it describes how to read a (possibly shared) Storage
+ * through an offset, a shape and a set of strides. Copying a TensorImpl is O(1)
+ * and keeps the underlying buffer alive.
  */
 struct TensorImpl {
-  void* data_ = nullptr;          // Raw data pointer
-  std::vector<int64_t> shape_;    // Tensor shape
-  std::vector<int64_t> strides_;  // Strides (bytes between elements)
-  DType* dtype_ = nullptr;        // Placeholder for data type
-  bool is_contiguous_ = true;     // Contiguity flag
-  bool owns_data_ = true;         // Ownership of data
+  std::shared_ptr<Storage> storage_;      // Shared buffer (null until allocated)
+  int64_t storage_offset_ = 0;            // Offset into storage (elements)
+  DimVector shape_;                       // Tensor shape (inline up to kMaxInlineDims)
+  DimVector strides_;                     // Strides (elements between neighbours)
+  int64_t numel_ = 0;                     // Cached product of shape_
+  DType dtype_ = DType::Float32;          // Element type
+  std::size_t itemsize_ = sizeof(float);  // Size of one element in bytes (cached from dtype_)
+  bool is_contiguous_ = true;             // Contiguity flag
 
   TensorImpl() = default;
 
-  TensorImpl(const std::vector<int64_t>& shape, DType* dtype);
+  TensorImpl(const DimVector& shape, DType dtype);
+
+  // Copies share the storage (O(1) view), moves steal it
+  TensorImpl(const TensorImpl& other) = default;
+  TensorImpl(TensorImpl&& other) noexcept = default;
+  TensorImpl& operator=(const TensorImpl& other) = default;
+  TensorImpl& operator=(TensorImpl&& other) noexcept = default;
 
-  // Copy constructor - Create a shallow copy (share data pointer)
-  TensorImpl(const TensorImpl& other);
+  ~TensorImpl() = default;
+
+  // Pointer to the first element of this view, or nullptr if unallocated
+  void* data() const {
+    if (!storage_ || !storage_->data()) {
+      return nullptr;
+    }
+    return static_cast<char*>(storage_->data()) + storage_offset_ * itemsize_;
+  }
 
-  // Move constructor
-  TensorImpl(TensorImpl&& other) noexcept;
+  // Bytes needed to hold numel_ elements of itemsize_
+  std::size_t nbytes() const { return static_cast<std::size_t>(numel_) * itemsize_; }
 
-  // Assignment operators
-  TensorImpl& operator=(const TensorImpl& other);
-  TensorImpl& operator=(TensorImpl&& other) noexcept;
+  // Replace the view geometry, keeping numel_ and is_contiguous_ in sync
+  void set_sizes_and_strides(const DimVector& shape, const DimVector& strides);
 
-  ~TensorImpl();
+  static DimVector compute_strides(const DimVector& shape);
+  static int64_t compute_numel(const DimVector& shape);
 
-  static std::vector<int64_t> compute_strides(const std::vector<int64_t>& shape);
+  // Whether the given strides describe a dense row-major layout of shape
+  static bool compute_contiguous(const DimVector& shape, const DimVector& strides);
 
   // Helper method to get element at specified indices
   template <typename T>
-  T& get(const std::vector<int64_t>& indices) {
+  T& get(const DimVector& indices) {
     std::size_t offset = 0;
     for (std::size_t i = 0; i < indices.size(); ++i) {
       offset += indices[i] * strides_[i];
     }
-    return static_cast<T*>(data_)[offset];
+    return static_cast<T*>(data())[offset];
   }
 
   template <typename T>
-  const T& get(const std::vector<int64_t>& indices) const {
+  const T& get(const DimVector& indices) const {
     std::size_t offset = 0;
     for (std::size_t i = 0; i < indices.size(); ++i) {
       offset += indices[i] * strides_[i];
     }
-    return static_cast<const T*>(data_)[offset];
+    return static_cast<const T*>(data())[offset];
   }
 };
 
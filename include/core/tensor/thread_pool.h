@@ -0,0 +1,64 @@
+#pragma once
+#ifndef TENSOR_THREAD_POOL_H
+#define TENSOR_THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace torchscratch {
+namespace core {
+namespace tensor {
+
+/**
+ * Fixed set of workers that, together with the submitting thread, run the
+ * tasks of one batch at a time. Tasks are claimed under the mutex, so a worker
+ * can never pick up a task from a batch other than the one it woke up for.
+ *
+ * Backs parallel_for (intra-op) and the backward engine (inter-op), each with
+ * a pool of its own.
+ */
+class ThreadPool {
+public:
+  explicit ThreadPool(int num_workers);
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  ~ThreadPool();
+
+  /**
+   * Run task(0) ... task(num_tasks - 1) and wait for all of them, rethrowing
+   * the first exception a task threw. While another thread's batch is running,
+   * the caller runs its tasks itself, one after the other.
+   */
+  void run(int64_t num_tasks, const std::function<void(int64_t)>& task);
+
+private:
+  void worker_loop();
+
+  // Claim and run the next task; called and returns with the lock held
+  void execute_one(std::unique_lock<std::mutex>& lock);
+
+  std::vector<std::thread> workers_;
+  std::mutex batch_mutex_;
+  std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable done_cv_;
+  const std::function<void(int64_t)>* task_ = nullptr;
+  int64_t num_tasks_ = 0;
+  int64_t next_task_ = 0;
+  int64_t remaining_ = 0;
+  std::exception_ptr error_;
+  bool stop_ = false;
+};
+
+}  // namespace tensor
+}  // namespace core
+}  // namespace torchscratch
+
+#endif  // TENSOR_THREAD_POOL_H
@@ -0,0 +1,123 @@
+#pragma once
+#ifndef TENSOR_VECTORIZED_H
+#define TENSOR_VECTORIZED_H
+
+#include <cstdint>
+#include <string>
+
+namespace torchscratch {
+namespace core {
+namespace tensor {
+
+/**
+ * Instruction sets the element-wise float32 kernels are built for, in
+ * increasing order.
+ */
+enum class CpuIsa {
+  Scalar,  // Portable C++
+  SSE42,   // 128-bit
+  AVX2,    // 256-bit, with FMA
+  AVX512,  // 512-bit (AVX-512F)
+};
+
+const char* cpu_isa_name(CpuIsa isa);
+
+/**
+ * Parse a name as printed by cpu_isa_name() ("scalar", "sse4.2", "avx2",
+ * "avx512"). Throws on anything else.
+ */
+CpuIsa parse_cpu_isa(const std::string& name);
+
+/**
+ * Best instruction set supported by the running CPU, from cpuid.
+ */
+CpuIsa cpu_max_isa();
+
+/**
+ * Instruction set the element-wise kernels currently use. Defaults to
+ * cpu_max_isa(), capped by the TORCHSCRATCH_CPU_ISA environment variable when
+ * it names a lower one, so the same binary can be A/B tested per process.
+ */
+CpuIsa cpu_isa();
+
+/**
+ * Switch every element-wise kernel to another (lower) instruction set. Throws
+ * if the CPU does not support it.
+ */
+void set_cpu_isa(CpuIsa isa);
+
+/**
+ * Accuracy tier of the transcendental kernels (exp, log, tanh, sigmoid).
+ *
+ * Fast: SIMD polynomial approximations with Cephes-style range reduction,
+ * about 6-20x the throughput of libm. Max error against a double-precision
+ * reference over the whole float range, denormals included: exp 1.5 ulp,
+ * log 1 ulp, tanh 1.5 ulp, sigmoid 3 ulp. Inf and NaN behave as in libm.
+ * Precise: the C library per element, within 1 ulp, but not vectorized.
+ */
+enum class MathAccuracy {
+  Fast,
+  Precise,
+};
+
+const char* math_accuracy_name(MathAccuracy accuracy);
+
+/**
+ * Parse "fast" or "precise". Throws on anything else.
+ */
+MathAccuracy parse_math_accuracy(const std::string& name);
+
+/**
+ * Accuracy tier in use. Defaults to Fast, or to the TORCHSCRATCH_MATH_ACCURACY
+ * environment variable when set.
+ */
+MathAccuracy math_accuracy();
+
+void set_math_accuracy(MathAccuracy accuracy);
+
+/**
+ * Contiguous float32 loops behind the element-wise ops. Every pointer may
+ * alias another (e.g. out == a for in-place ops) as long as they are equal.
+ */
+struct ElementwiseKernels {
+  // out[i] = a[i] op b[i]
+  void (*add)(int64_t n, const float* a, const float* b, float* out);
+  void (*sub)(int64_t n, const float* a, const float* b, float* out);
+  void (*mul)(int64_t n, const float* a, const float* b, float* out);
+  // out[i] = a[i] op s
+  void (*add_scalar)(int64_t n, const float* a, float s, float* out);
+  void (*mul_scalar)(int64_t n, const float* a, float s, float* out);
+  // y[i] += alpha * x[i]
+  void (*axpy)(int64_t n, float alpha, const float* x, float* y);
+  // out[i] = max(x[i], 0)
+  void (*relu)(int64_t n, const float* x, float* out);
+  // out[i] = x[i] > 0 ? grad[i] : 0
+  void (*relu_backward)(int64_t n, const float* x, const float* grad, float* out);
+  // out[i] = f(x[i]), to the active MathAccuracy
+  void (*exp)(int64_t n, const float* x, float* out);
+  void (*log)(int64_t n, const float* x, float* out);
+  void (*tanh)(int64_t n, const float* x, float* out);
+  void (*sigmoid)(int64_t n, const float* x, float* out);
+  // out[i] = grad[i] * f'(x) given y[i] = f(x)
+  void (*sigmoid_backward)(int64_t n, const float* y, const float* grad, float* out);
+  void (*tanh_backward)(int64_t n, const float* y, const float* grad, float* out);
+};
+
+/**
+ * Kernels for cpu_isa() and math_accuracy(), bound once per switch rather
+ * than per call.
+ */
+const ElementwiseKernels& elementwise_kernels();
+
+/**
+ * Kernels for a specific instruction set, e.g. to check it against the scalar
+ * reference. Throws if the CPU does not support it.
+ */
+const ElementwiseKernels& elementwise_kernels(CpuIsa isa);
+const ElementwiseKernels& elementwise_kernels(CpuIsa isa, MathAccuracy accuracy);
+
+}  // namespace tensor
+}  // namespace core
+}  // namespace torchscratch
+
+#endif  // TENSOR_VECTORIZED_H
@@ -22,37 +22,119 @@ except ImportError as e:
 from torchscratch_cpp import (
     Tensor,
     Variable,
+    dtype,
+    float32,
+    float64,
+    int32,
+    int8,
+    bfloat16,
+    float16,
     add,
     sub,
     mul,
     matmul,
+    bmm,
     transpose,
+    sum_to,
+    expand,
+    broadcast_shapes,
+    sum,
+    mean,
+    max,
+    min,
+    norm,
+    argmax,
+    add_out,
+    sub_out,
+    mul_out,
+    matmul_out,
+    bmm_out,
+    add_,
+    sub_,
+    mul_,
+    scale_,
+    axpy_,
     tensor,
+    memory_stats,
+    empty_cache,
+    get_num_threads,
+    set_num_threads,
+    get_num_backward_threads,
+    set_num_backward_threads,
+    deterministic_backward,
+    set_deterministic_backward,
+    get_cpu_isa,
+    get_max_cpu_isa,
+    set_cpu_isa,
+    get_math_accuracy,
+    set_math_accuracy,
+    StepArena,
+    no_grad,
+    inference_mode,
+    is_grad_enabled,
+    set_grad_enabled,
+    is_inference_mode_enabled,
 )
 
 # Import submodules
 from . import nn
 from . import optim
 
-# Add no_grad context manager
-class no_grad:
-    """Context manager for disabling gradient computation"""
-    def __enter__(self):
-        return self
-    
-    def __exit__(self, exc_type, exc_val, exc_tb):
-        pass
-
 __all__ = [
     "Tensor",
     "Variable",
+    "dtype",
+    "float32",
+    "float64",
+    "int32",
+    "int8",
+    "bfloat16",
+    "float16",
     "add",
     "sub",
     "mul",
     "matmul",
+    "bmm",
     "transpose",
+    "sum_to",
+    "expand",
+    "broadcast_shapes",
+    "sum",
+    "mean",
+    "max",
+    "min",
+    "norm",
+    "argmax",
+    "add_out",
+    "sub_out",
+    "mul_out",
+    "matmul_out",
+    "bmm_out",
+    "add_",
+    "sub_",
+    "mul_",
+    "scale_",
+    "axpy_",
     "tensor",
+    "memory_stats",
+    "empty_cache",
+    "get_num_threads",
+    "set_num_threads",
+    "get_num_backward_threads",
+    "set_num_backward_threads",
+    "deterministic_backward",
+    "set_deterministic_backward",
+    "get_cpu_isa",
+    "get_max_cpu_isa",
+    "set_cpu_isa",
+    "get_math_accuracy",
+    "set_math_accuracy",
+    "StepArena",
     "no_grad",
+    "inference_mode",
+    "is_grad_enabled",
+    "set_grad_enabled",
+    "is_inference_mode_enabled",
     "nn",
     "optim",
 ]
\ No newline at end of file
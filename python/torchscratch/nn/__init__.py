@@ -12,7 +12,7 @@ except ImportError:
     pass
 
 __all__ = [
-    "Linear",
+    "Linear", "linear_act", "Activation",
     "relu", "sigmoid", "tanh",
     "mse_loss", "binary_cross_entropy_loss", "cross_entropy_loss"
 ]
\ No newline at end of file
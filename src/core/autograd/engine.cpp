@@ -1,30 +1,129 @@
+#include "core/autograd/engine.h"
+
 #include <algorithm>
-#include <iostream>
-#include <queue>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <string>
+#include <thread>
 #include <unordered_map>
-#include <unordered_set>
+#include <vector>
 
 #include "core/autograd/variable.h"
+#include "core/tensor/arena.h"
 #include "core/tensor/ops.h"
 #include "core/tensor/tensor_impl.h"
+#include "core/tensor/thread_pool.h"
 
 namespace torchscratch {
 namespace core {
 namespace autograd {
 
 // Function implementation
-void Function::save_for_backward(const std::vector<Variable*>& inputs) {
-  saved_variables_ = inputs;
+Function::~Function() {
+  // Producers only this Function owns would otherwise be destroyed recursively,
+  // one stack frame per node of the chain. Queue them instead and let the
+  // outermost destructor on this thread release them one at a time.
+  thread_local std::vector<std::shared_ptr<Function>> pending;
+  thread_local bool draining = false;
+  for (Edge& edge : next_edges_) {
+    if (edge.function && edge.function.use_count() == 1) {
+      pending.push_back(std::move(edge.function));
+    }
+  }
+  if (draining) {
+    return;
+  }
+  draining = true;
+  while (!pending.empty()) {
+    std::shared_ptr<Function> next = std::move(pending.back());
+    pending.pop_back();
+    next.reset();
+  }
+  draining = false;
+}
+
+void Function::save_for_backward(const std::vector<tensor::Tensor>& tensors) {
+  saved_tensors_ = tensors;
+  saved_versions_.clear();
+  saved_versions_.reserve(tensors.size());
+  for (const tensor::Tensor& saved : tensors) {
+    saved_versions_.push_back(saved.version());
+  }
+}
+
+void Function::check_saved_versions() const {
+  for (size_t i = 0; i < saved_tensors_.size(); ++i) {
+    if (saved_tensors_[i].version() != saved_versions_[i]) {
+      throw std::runtime_error(name() +
+                               ": a tensor needed for gradient computation has been modified "
+                               "by an in-place operation");
+    }
+  }
+}
+
+void Function::release_saved() {
+  // Only a Function that kept tensors has lost anything it needs
+  released_ = released_ || !saved_tensors_.empty();
+  saved_tensors_.clear();
+  saved_tensors_.shrink_to_fit();
+  saved_versions_.clear();
+  saved_versions_.shrink_to_fit();
 }
 
-const std::vector<Variable*>& Function::get_saved_variables() const { return saved_variables_; }
+namespace {
+
+// Whether grad is the only reference to a dense buffer of its own, so it can
+// be written in place or kept without a copy. The engine hands over gradient
+// buffers by move, so freshly computed gradients usually are.
+bool owns_buffer(const tensor::Tensor& grad) {
+  return grad.storage() && grad.storage().use_count() == 1 && grad.is_contiguous() &&
+         grad.storage_offset() == 0;
+}
+
+}  // namespace
+
+// AccumulateGrad implementation
+std::vector<tensor::Tensor> AccumulateGrad::forward(const std::vector<tensor::Tensor>&) {
+  throw std::runtime_error("AccumulateGrad has no forward pass");
+}
+
+std::vector<tensor::Tensor> AccumulateGrad::backward(
+    const std::vector<tensor::Tensor>& grad_output) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  tensor::Tensor& grad = meta_->grad;
+  const tensor::Tensor& incoming = grad_output[0];
+  if (grad.data_ptr()) {
+    // Accumulate into the existing gradient buffer instead of allocating a new one
+    tensor::add_(grad, incoming);
+  } else if (owns_buffer(incoming) && !incoming.storage()->from_arena()) {
+    // Nothing else refers to the incoming buffer: keep it as the gradient
+    grad = incoming;
+  } else {
+    // The incoming gradient may be shared with another input (AddFunction hands
+    // out the same tensor twice) or with the caller, so take a private copy.
+    // The gradient outlives the step, so never in a StepArena: it would pin a
+    // chunk for good
+    tensor::NoStepArenaGuard heap;
+    grad = incoming.clone();
+  }
+  return {};
+}
 
 // AddFunction implementation
 std::vector<tensor::Tensor> AddFunction::forward(const std::vector<tensor::Tensor>& inputs) {
   if (inputs.size() != 2) {
     throw std::runtime_error("AddFunction expects exactly 2 inputs");
   }
+  input1_shape_ = inputs[0].shape();
+  input2_shape_ = inputs[1].shape();
+
   std::vector<tensor::Tensor> outputs;
   outputs.push_back(tensor::add(inputs[0], inputs[1]));
   return outputs;
@@ -35,10 +134,11 @@ std::vector<tensor::Tensor> AddFunction::backward(const std::vector<tensor::Tens
     throw std::runtime_error("AddFunction backward expects exactly 1 gradient");
   }
 
-  // Gradient of addition is passed unchanged to both inputs
+  // Gradient of addition is passed unchanged to both inputs, summed over any
+  // dimensions they were broadcast along
   std::vector<tensor::Tensor> grad_inputs;
-  grad_inputs.push_back(grad_output[0]);
-  grad_inputs.push_back(grad_output[0]);
+  grad_inputs.push_back(tensor::sum_to(grad_output[0], input1_shape_));
+  grad_inputs.push_back(tensor::sum_to(grad_output[0], input2_shape_));
   return grad_inputs;
 }
 
@@ -49,8 +149,7 @@ std::vector<tensor::Tensor> MulFunction::forward(const std::vector<tensor::Tenso
   }
 
   // Store inputs for backward pass
-  input1_ = inputs[0];
-  input2_ = inputs[1];
+  save_for_backward({inputs[0], inputs[1]});
 
   std::vector<tensor::Tensor> outputs;
   outputs.push_back(tensor::mul(inputs[0], inputs[1]));
@@ -64,9 +163,15 @@ std::vector<tensor::Tensor> MulFunction::backward(const std::vector<tensor::Tens
 
   // d(a*b)/da = b * grad_output
   // d(a*b)/db = a * grad_output
-  std::vector<tensor::Tensor> grad_inputs;
-  grad_inputs.push_back(tensor::mul(input2_, grad_output[0]));
-  grad_inputs.push_back(tensor::mul(input1_, grad_output[0]));
+  const tensor::Tensor& input1 = saved_tensors()[0];
+  const tensor::Tensor& input2 = saved_tensors()[1];
+  std::vector<tensor::Tensor> grad_inputs(2);
+  if (needs_input_grad(0)) {
+    grad_inputs[0] = tensor::sum_to(tensor::mul(input2, grad_output[0]), input1.shape());
+  }
+  if (needs_input_grad(1)) {
+    grad_inputs[1] = tensor::sum_to(tensor::mul(input1, grad_output[0]), input2.shape());
+  }
   return grad_inputs;
 }
 
@@ -77,8 +182,7 @@ std::vector<tensor::Tensor> MatMulFunction::forward(const std::vector<tensor::Te
   }
 
   // Store inputs for backward pass
-  input1_ = inputs[0];
-  input2_ = inputs[1];
+  save_for_backward({inputs[0], inputs[1]});
 
   std::vector<tensor::Tensor> outputs;
   outputs.push_back(tensor::matmul(inputs[0], inputs[1]));
@@ -93,111 +197,610 @@ std::vector<tensor::Tensor> MatMulFunction::backward(
 
   // d(a@b)/da = grad_output @ b.T
   // d(a@b)/db = a.T @ grad_output
-  std::vector<tensor::Tensor> grad_inputs;
-  grad_inputs.push_back(tensor::matmul(grad_output[0], tensor::transpose(input2_, 0, 1)));
-  grad_inputs.push_back(tensor::matmul(tensor::transpose(input1_, 0, 1), grad_output[0]));
+  // The transposes are GEMM flags, so neither operand is copied. Gradients are
+  // summed over any batch dimensions an input was broadcast along
+  const tensor::Tensor& input1 = saved_tensors()[0];
+  const tensor::Tensor& input2 = saved_tensors()[1];
+  std::vector<tensor::Tensor> grad_inputs(2);
+  if (needs_input_grad(0)) {
+    grad_inputs[0] = tensor::sum_to(
+        tensor::matmul(grad_output[0], input2, /*trans_a=*/false, /*trans_b=*/true),
+        input1.shape());
+  }
+  if (needs_input_grad(1)) {
+    grad_inputs[1] = tensor::sum_to(
+        tensor::matmul(input1, grad_output[0], /*trans_a=*/true, /*trans_b=*/false),
+        input2.shape());
+  }
   return grad_inputs;
 }
 
+// BmmFunction implementation
+std::vector<tensor::Tensor> BmmFunction::forward(const std::vector<tensor::Tensor>& inputs) {
+  if (inputs.size() != 2) {
+    throw std::runtime_error("BmmFunction expects exactly 2 inputs");
+  }
+
+  // Store inputs for backward pass
+  save_for_backward({inputs[0], inputs[1]});
+
+  std::vector<tensor::Tensor> outputs;
+  outputs.push_back(tensor::bmm(inputs[0], inputs[1]));
+  return outputs;
+}
+
+namespace {
+
+// out = fn(a, b) elementwise over shape, a and b broadcasting to it, computed
+// in the floating-point accumulation type
+template <typename Fn>
+tensor::Tensor map2(const tensor::Tensor& a, const tensor::Tensor& b,
+                    const tensor::DimVector& shape, const char* name, Fn fn) {
+  tensor::Tensor out(shape, a.dtype());
+  out.allocate();
+  tensor::TensorIterator iter(shape, {&out, &a, &b});
+  TS_DISPATCH_FLOATING_TYPES(a.dtype(), name, [&] {
+    using acc_t = typename tensor::acc_type<scalar_t>::type;
+    iter.for_each([&](char** data, const int64_t* strides, int64_t n) {
+      for (int64_t i = 0; i < n; ++i) {
+        const scalar_t& x = *reinterpret_cast<const scalar_t*>(data[1] + i * strides[1]);
+        const scalar_t& y = *reinterpret_cast<const scalar_t*>(data[2] + i * strides[2]);
+        *reinterpret_cast<scalar_t*>(data[0] + i * strides[0]) =
+            static_cast<scalar_t>(fn(static_cast<acc_t>(x), static_cast<acc_t>(y)));
+      }
+    });
+  });
+  return out;
+}
+
+// Gradient of an extremum: kept_grad shared evenly between the elements of
+// input equal to kept_value (both in keepdim shape)
+tensor::Tensor extremum_backward(const tensor::Tensor& input, const tensor::Tensor& kept_value,
+                                 const tensor::Tensor& kept_grad,
+                                 const tensor::DimVector& dims) {
+  tensor::Tensor mask = map2(input, kept_value, input.shape(), "max_backward",
+                             [](auto x, auto m) { return x == m ? decltype(x)(1) : decltype(x)(0); });
+  tensor::Tensor ties = tensor::sum(mask, dims, /*keepdim=*/true);
+  tensor::Tensor share = map2(kept_grad, ties, kept_grad.shape(), "max_backward",
+                              [](auto g, auto count) { return g / count; });
+  return tensor::mul(mask, share);
+}
+
+}  // namespace
+
+// SumFunction implementation
+tensor::Tensor SumFunction::finish_forward(const tensor::Tensor& input,
+                                           const tensor::Tensor& kept) {
+  input_shape_ = input.shape();
+  keepdim_shape_ = kept.shape();
+  if (keepdim_) {
+    return kept;
+  }
+  // The tensor op has validated dims_ by now
+  const int64_t ndim = input.dim();
+  tensor::DimVector shape;
+  for (int64_t d = 0; d < ndim; ++d) {
+    bool reduced = dims_.empty();
+    for (int64_t dim : dims_) {
+      reduced = reduced || (dim < 0 ? dim + ndim : dim) == d;
+    }
+    if (!reduced) {
+      shape.push_back(kept.shape()[d]);
+    }
+  }
+  return kept.reshape(shape);
+}
+
+tensor::Tensor SumFunction::kept_grad(const tensor::Tensor& grad_output) const {
+  return grad_output.contiguous().reshape(keepdim_shape_);
+}
+
+std::vector<tensor::Tensor> SumFunction::forward(const std::vector<tensor::Tensor>& inputs) {
+  if (inputs.size() != 1) {
+    throw std::runtime_error("SumFunction expects exactly 1 input");
+  }
+  return {finish_forward(inputs[0], tensor::sum(inputs[0], dims_, /*keepdim=*/true))};
+}
+
+std::vector<tensor::Tensor> SumFunction::backward(const std::vector<tensor::Tensor>& grad_output) {
+  if (grad_output.size() != 1) {
+    throw std::runtime_error("SumFunction backward expects exactly 1 gradient");
+  }
+  // Every input element contributes once to its output element
+  return {tensor::expand(kept_grad(grad_output[0]), input_shape_).contiguous()};
+}
+
+// MeanFunction implementation
+std::vector<tensor::Tensor> MeanFunction::forward(const std::vector<tensor::Tensor>& inputs) {
+  if (inputs.size() != 1) {
+    throw std::runtime_error("MeanFunction expects exactly 1 input");
+  }
+  return {finish_forward(inputs[0], tensor::mean(inputs[0], dims_, /*keepdim=*/true))};
+}
+
+std::vector<tensor::Tensor> MeanFunction::backward(
+    const std::vector<tensor::Tensor>& grad_output) {
+  std::vector<tensor::Tensor> grad_inputs = SumFunction::backward(grad_output);
+  int64_t output_numel = 1;
+  for (int64_t size : keepdim_shape_) {
+    output_numel *= size;
+  }
+  int64_t input_numel = 1;
+  for (int64_t size : input_shape_) {
+    input_numel *= size;
+  }
+  if (input_numel > 0) {
+    tensor::scale_(grad_inputs[0], static_cast<double>(output_numel) / input_numel);
+  }
+  return grad_inputs;
+}
+
+// MaxFunction implementation
+std::vector<tensor::Tensor> MaxFunction::forward(const std::vector<tensor::Tensor>& inputs) {
+  if (inputs.size() != 1) {
+    throw std::runtime_error(name() + " expects exactly 1 input");
+  }
+  tensor::Tensor kept_output = largest_ ? tensor::max(inputs[0], dims_, /*keepdim=*/true)
+                                        : tensor::min(inputs[0], dims_, /*keepdim=*/true);
+  save_for_backward({inputs[0], kept_output});
+  return {finish_forward(inputs[0], kept_output)};
+}
+
+std::vector<tensor::Tensor> MaxFunction::backward(const std::vector<tensor::Tensor>& grad_output) {
+  if (grad_output.size() != 1) {
+    throw std::runtime_error(name() + " backward expects exactly 1 gradient");
+  }
+  return {extremum_backward(saved_tensors()[0], saved_tensors()[1], kept_grad(grad_output[0]),
+                            dims_)};
+}
+
+// NormFunction implementation
+std::vector<tensor::Tensor> NormFunction::forward(const std::vector<tensor::Tensor>& inputs) {
+  if (inputs.size() != 1) {
+    throw std::runtime_error("NormFunction expects exactly 1 input");
+  }
+  tensor::Tensor kept_output = tensor::norm(inputs[0], p_, dims_, /*keepdim=*/true);
+  save_for_backward({inputs[0], kept_output});
+  return {finish_forward(inputs[0], kept_output)};
+}
+
+std::vector<tensor::Tensor> NormFunction::backward(
+    const std::vector<tensor::Tensor>& grad_output) {
+  if (grad_output.size() != 1) {
+    throw std::runtime_error("NormFunction backward expects exactly 1 gradient");
+  }
+  const tensor::Tensor& input = saved_tensors()[0];
+  const tensor::Tensor& kept_output = saved_tensors()[1];
+  const tensor::Tensor grad = kept_grad(grad_output[0]);
+  auto sign = [](auto x) { return x > 0 ? decltype(x)(1) : x < 0 ? decltype(x)(-1) : decltype(x)(0); };
+
+  if (std::isinf(p_)) {
+    // max |x|: the max gradient through |x|, times sign(x)
+    tensor::Tensor magnitude =
+        map2(input, input, input.shape(), "norm_backward", [](auto x, auto) { return std::abs(x); });
+    tensor::Tensor grad_magnitude = extremum_backward(magnitude, kept_output, grad, dims_);
+    return {map2(grad_magnitude, input, input.shape(), "norm_backward",
+                 [sign](auto g, auto x) { return g * sign(x); })};
+  }
+
+  // d|x|_p / dx = sign(x) |x|^(p-1) / |x|_p^(p-1), and 0 where the norm is 0
+  const double p = p_;
+  tensor::Tensor factor = map2(grad, kept_output, grad.shape(), "norm_backward",
+                               [p](auto g, auto norm) {
+                                 using T = decltype(g);
+                                 return norm == 0 ? T(0) : g / std::pow(norm, static_cast<T>(p - 1));
+                               });
+  return {map2(input, factor, input.shape(), "norm_backward", [p, sign](auto x, auto f) {
+    using T = decltype(x);
+    return p == 2 ? x * f : sign(x) * std::pow(std::abs(x), static_cast<T>(p - 1)) * f;
+  })};
+}
+
 // Variable implementation
 Variable::Variable(const tensor::Tensor& data, bool requires_grad)
-    : data_(data), requires_grad_(requires_grad), grad_fn_(nullptr) {
-  if (requires_grad) {
-    // Initialize gradient tensor with same shape as data but filled with zeros
-    grad_ = tensor::Tensor(data.shape());
-    grad_.allocate();
-    // Initialize gradient to zeros (in a real implementation, we would use a zeros_like function)
-    float* grad_ptr = grad_.data_ptr<float>();
-    if (grad_ptr) {
-      std::fill(grad_ptr, grad_ptr + grad_.numel(), 0.0f);
+    : data_(data), meta_(std::make_shared<AutogradMeta>()) {
+  // The gradient is allocated by the first backward pass that reaches it
+  meta_->requires_grad = requires_grad;
+}
+
+Variable Variable::detach() const { return Variable(data_, false); }
+
+Edge Variable::gradient_edge() const {
+  if (meta_->grad_fn) {
+    return Edge{meta_->grad_fn};
+  }
+  if (!meta_->requires_grad) {
+    return Edge{};
+  }
+  // One accumulator per leaf while any graph uses it, so all of a leaf's uses
+  // meet in a single node
+  std::shared_ptr<Function> accumulator = meta_->grad_accumulator.lock();
+  if (!accumulator) {
+    accumulator = std::make_shared<AccumulateGrad>(meta_);
+    meta_->grad_accumulator = accumulator;
+  }
+  return Edge{accumulator};
+}
+
+namespace {
+
+std::mutex backward_pool_mutex;
+int num_backward_threads = std::max(1u, std::thread::hardware_concurrency());
+// Created on first use with num_backward_threads - 1 workers
+std::shared_ptr<tensor::ThreadPool> backward_pool;
+
+std::shared_ptr<tensor::ThreadPool> get_backward_pool() {
+  std::lock_guard<std::mutex> lock(backward_pool_mutex);
+  if (!backward_pool) {
+    backward_pool = std::make_shared<tensor::ThreadPool>(num_backward_threads - 1);
+  }
+  return backward_pool;
+}
+
+// Off unless TORCHSCRATCH_DETERMINISTIC_BACKWARD is set to anything but "0"
+bool initial_deterministic() {
+  const char* requested = std::getenv("TORCHSCRATCH_DETERMINISTIC_BACKWARD");
+  return requested && *requested && std::string(requested) != "0";
+}
+
+std::atomic<bool> deterministic{initial_deterministic()};
+
+}  // namespace
+
+int get_num_backward_threads() {
+  std::lock_guard<std::mutex> lock(backward_pool_mutex);
+  return num_backward_threads;
+}
+
+void set_num_backward_threads(int threads) {
+  if (threads < 1) {
+    throw std::runtime_error("Number of backward threads must be at least 1");
+  }
+  std::shared_ptr<tensor::ThreadPool> old_pool;
+  {
+    std::lock_guard<std::mutex> lock(backward_pool_mutex);
+    if (threads == num_backward_threads) {
+      return;
     }
+    num_backward_threads = threads;
+    old_pool = std::move(backward_pool);
   }
+  // Joined outside the lock; a backward pass still using it keeps it alive until done
+  old_pool.reset();
 }
 
-Variable Variable::detach() const { return Variable(data_, false); }
+bool deterministic_backward() { return deterministic.load(std::memory_order_relaxed); }
 
-// Helper class for backpropagation
-class BackwardEngine {
+void set_deterministic_backward(bool value) {
+  deterministic.store(value, std::memory_order_relaxed);
+}
+
+// One backward pass. The Functions reachable from the root along the next
+// edges are discovered iteratively and numbered once, each with a count of the
+// consumers of its output that still have to run; a Function becomes ready
+// when that count drops to zero, so deep graphs need no recursion and the run
+// itself does no hashing. Leaves are AccumulateGrad nodes like any other.
+//
+// Graphs with independent branches run on the backward pool: every thread has
+// a deque of ready nodes, takes work from its back and, when it runs dry,
+// steals from the front of the others'. A thread follows a chain itself as
+// long as each step readies one node, so only the extra branches are handed
+// out, and the leaves a step readies are run on the spot.
+class GraphTask {
 public:
-  static void execute_backward(Variable& root_var) {
-    // Initialize the root gradient to ones if no gradient is set
-    // This applies to all tensors regardless of shape, as we need to
-    // start the backward pass with a gradient
-    if (!root_var.grad().data_ptr()) {
-      std::cout << "Initializing root gradient to ones" << std::endl;
-      tensor::Tensor ones(root_var.shape());
-      ones.allocate();
-      float* ones_ptr = ones.data_ptr<float>();
-      for (int64_t i = 0; i < ones.numel(); ++i) {
-        ones_ptr[i] = 1.0f;
+  explicit GraphTask(Function* root) : deterministic_(deterministic_backward()) {
+    discover(root);
+  }
+
+  void run(const tensor::Tensor& root_grad) {
+    nodes_[0].grad = root_grad;
+    const int threads = branches_ ? get_num_backward_threads() : 1;
+    if (threads > 1) {
+      run_parallel(threads);
+      return;
+    }
+
+    std::vector<size_t> ready = {0};
+    while (!ready.empty()) {
+      const size_t index = ready.back();
+      ready.pop_back();
+      execute(index, ready);
+    }
+  }
+
+private:
+  struct Node {
+    explicit Node(Function* fn) : fn(fn) {}
+
+    Function* fn;
+    int64_t consumers = 0;      // Edges into this node from the rest of the graph
+    std::vector<int64_t> next;  // Node at the end of each next edge, or -1 for none
+    std::vector<int64_t> slot;  // Which of that node's consumers each edge is
+    tensor::Tensor grad;        // Gradient w.r.t. the output, summed over the consumers
+    // Deterministic mode: the consumers' gradients, summed in this order once all arrived
+    std::vector<tensor::Tensor> inputs;
+  };
+
+  // Ready nodes of one thread of a parallel run
+  struct WorkQueue {
+    std::mutex mutex;
+    std::deque<size_t> nodes;
+  };
+
+  // Run a node all of whose consumers have run, send its input gradients along
+  // its edges and append the nodes that became ready to ready
+  void execute(size_t index, std::vector<size_t>& ready) {
+    Node& node = nodes_[index];
+    Function* fn = node.fn;
+
+    if (fn->released()) {
+      throw std::runtime_error(fn->name() +
+                               ": trying to backward through the graph a second time; the "
+                               "saved tensors were freed by the first backward");
+    }
+    fn->check_saved_versions();
+    for (tensor::Tensor& input : node.inputs) {
+      if (input.data_ptr()) {
+        accumulate(node.grad, std::move(input));
       }
-      root_var.set_grad(ones);
     }
+    std::vector<tensor::Tensor>().swap(node.inputs);
+
+    // A node none of whose consumers produced a gradient passes none on. The
+    // buffer is moved in, so the function may keep or overwrite it
+    std::vector<tensor::Tensor> grad_inputs;
+    if (node.grad.data_ptr()) {
+      std::vector<tensor::Tensor> grad_output;
+      grad_output.push_back(std::move(node.grad));
+      grad_inputs = fn->backward(grad_output);
+    }
+    node.grad = tensor::Tensor();
 
-    // Build the topological ordering of the graph
-    std::vector<Variable*> topo_order;
-    std::unordered_set<Function*> visited_functions;
+    // Send each input gradient along its edge
+    for (size_t i = 0; i < node.next.size(); ++i) {
+      const int64_t next = node.next[i];
+      if (next < 0) {
+        continue;
+      }
+      if (i < grad_inputs.size() && grad_inputs[i].data_ptr()) {
+        deliver(next, node.slot[i], std::move(grad_inputs[i]));
+      }
+      // The last consumer to finish sees every gradient the others delivered
+      if (dependencies_[next].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        ready.push_back(static_cast<size_t>(next));
+      }
+    }
 
-    // Start DFS from the root variable
-    build_graph(root_var, topo_order, visited_functions);
+    // Nothing downstream needs this Function's saved state any more
+    fn->release_saved();
+  }
 
-    // Reverse to get proper execution order for backward pass
-    std::reverse(topo_order.begin(), topo_order.end());
+  void deliver(int64_t next, int64_t slot, tensor::Tensor&& grad) {
+    Node& producer = nodes_[next];
+    if (deterministic_) {
+      // Only this edge writes the slot
+      producer.inputs[slot] = std::move(grad);
+    } else if (!locks_.empty()) {
+      std::lock_guard<std::mutex> lock(locks_[next]);
+      accumulate(producer.grad, std::move(grad));
+    } else {
+      accumulate(producer.grad, std::move(grad));
+    }
+  }
 
-    // Execute backward pass in topological order
-    for (Variable* var : topo_order) {
-      if (!var->grad_fn())
-        continue;
+  // Sum a gradient into a node's buffer: the first one is moved in, later ones
+  // are added in place when the buffer is not shared with anything else (the
+  // same tensor may reach two inputs, e.g. through AddFunction)
+  static void accumulate(tensor::Tensor& buffer, tensor::Tensor&& grad) {
+    if (!buffer.data_ptr()) {
+      buffer = std::move(grad);
+    } else if (owns_buffer(buffer) && buffer.shape() == grad.shape() &&
+               buffer.dtype() == grad.dtype()) {
+      tensor::add_(buffer, grad);
+    } else {
+      buffer = tensor::add(buffer, grad);
+    }
+  }
 
-      auto grad_fn = var->grad_fn();
-      std::vector<tensor::Tensor> grad_output = {var->grad()};
-      std::vector<tensor::Tensor> grad_inputs = grad_fn->backward(grad_output);
+  void run_parallel(int threads) {
+    queues_ = std::vector<WorkQueue>(threads);
+    if (!deterministic_) {
+      locks_ = std::vector<std::mutex>(nodes_.size());
+    }
+    remaining_ = static_cast<int64_t>(nodes_.size());
+    push(0, {0});
 
-      // Distribute gradients to input variables
-      const auto& saved_vars = grad_fn->get_saved_variables();
-      for (size_t i = 0; i < saved_vars.size(); ++i) {
-        Variable* input_var = saved_vars[i];
-        if (!input_var->requires_grad())
-          continue;
+    get_backward_pool()->run(threads, [this](int64_t worker) { work(worker); });
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+  }
 
-        if (i < grad_inputs.size()) {
-          // Accumulate gradients (for variables used multiple times)
-          if (input_var->grad().data_ptr()) {
-            // Accumulate gradients by adding to existing ones
-            input_var->set_grad(tensor::add(input_var->grad(), grad_inputs[i]));
-          } else {
-            input_var->set_grad(grad_inputs[i]);
+  void work(size_t worker) {
+    std::vector<size_t> ready;
+    std::vector<size_t> handout;
+    size_t index;
+    try {
+      while (next_ready(worker, index)) {
+        while (!failed_.load(std::memory_order_relaxed)) {
+          ready.clear();
+          execute(index, ready);
+          finish_one();
+
+          // Leaves ready nothing further; of the rest keep one and hand out the others
+          size_t keep = nodes_.size();
+          handout.clear();
+          for (size_t r = 0; r < ready.size(); ++r) {
+            if (nodes_[ready[r]].next.empty()) {
+              execute(ready[r], ready);
+              finish_one();
+            } else if (keep == nodes_.size()) {
+              keep = ready[r];
+            } else {
+              handout.push_back(ready[r]);
+            }
           }
+          push(worker, handout);
+          if (keep == nodes_.size()) {
+            break;
+          }
+          index = keep;
         }
       }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!error_) {
+        error_ = std::current_exception();
+      }
+      failed_ = true;
+      ready_cv_.notify_all();
     }
   }
 
-private:
-  static void build_graph(Variable& var, std::vector<Variable*>& topo_order,
-                          std::unordered_set<Function*>& visited_functions) {
-    if (!var.grad_fn())
-      return;
+  // Take a ready node, from this thread's deque if possible, otherwise from
+  // another's. Waits while none is queued; false once the run is over
+  bool next_ready(size_t worker, size_t& index) {
+    const size_t count = queues_.size();
+    while (true) {
+      for (size_t k = 0; k < count; ++k) {
+        WorkQueue& queue = queues_[(worker + k) % count];
+        std::lock_guard<std::mutex> queue_lock(queue.mutex);
+        if (queue.nodes.empty()) {
+          continue;
+        }
+        if (k == 0) {
+          index = queue.nodes.back();
+          queue.nodes.pop_back();
+        } else {
+          index = queue.nodes.front();
+          queue.nodes.pop_front();
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        --queued_;
+        return true;
+      }
 
-    auto grad_fn = var.grad_fn();
-    if (visited_functions.find(grad_fn.get()) != visited_functions.end()) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      ready_cv_.wait(lock, [this] { return queued_ > 0 || remaining_ == 0 || failed_; });
+      if (remaining_ == 0 || failed_) {
+        return false;
+      }
+    }
+  }
+
+  void push(size_t worker, const std::vector<size_t>& nodes) {
+    if (nodes.empty()) {
       return;
     }
+    WorkQueue& queue = queues_[worker];
+    {
+      std::lock_guard<std::mutex> queue_lock(queue.mutex);
+      queue.nodes.insert(queue.nodes.end(), nodes.begin(), nodes.end());
+      std::lock_guard<std::mutex> lock(mutex_);
+      queued_ += static_cast<int64_t>(nodes.size());
+    }
+    if (nodes.size() > 1) {
+      ready_cv_.notify_all();
+    } else {
+      ready_cv_.notify_one();
+    }
+  }
+
+  void finish_one() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--remaining_ == 0) {
+      ready_cv_.notify_all();
+    }
+  }
+
+  void discover(Function* root) {
+    std::unordered_map<Function*, int64_t> index = {{root, 0}};
+    nodes_.emplace_back(root);
+    std::vector<int64_t> stack = {0};
+
+    while (!stack.empty()) {
+      const int64_t current = stack.back();
+      stack.pop_back();
+      const auto& edges = nodes_[current].fn->next_edges();
+      std::vector<int64_t> next(edges.size(), -1);
+      std::vector<int64_t> slot(edges.size(), -1);
+      for (size_t i = 0; i < edges.size(); ++i) {
+        Function* producer = edges[i].function.get();
+        if (!producer) {
+          continue;
+        }
+        auto inserted = index.emplace(producer, static_cast<int64_t>(nodes_.size()));
+        if (inserted.second) {
+          nodes_.emplace_back(producer);
+          stack.push_back(inserted.first->second);
+        }
+        next[i] = inserted.first->second;
+        slot[i] = nodes_[next[i]].consumers++;
+      }
+      nodes_[current].next = std::move(next);
+      nodes_[current].slot = std::move(slot);
+    }
 
-    visited_functions.insert(grad_fn.get());
+    dependencies_ = std::vector<std::atomic<int64_t>>(nodes_.size());
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+      Node& node = nodes_[i];
+      dependencies_[i].store(node.consumers, std::memory_order_relaxed);
+      if (deterministic_) {
+        node.inputs.resize(node.consumers);
+      }
+      // A node that readies two producers with work of their own is a branch
+      // another thread could take
+      int64_t interior = 0;
+      for (int64_t next : node.next) {
+        interior += next >= 0 && !nodes_[next].next.empty();
+      }
+      branches_ = branches_ || interior > 1;
+    }
+  }
 
-    // Recursively build graph through saved variables
-    for (auto input_var : grad_fn->get_saved_variables()) {
-      build_graph(*input_var, topo_order, visited_functions);
+  const bool deterministic_;
+  std::vector<Node> nodes_;  // Discovery order; the root is nodes_[0]
+  std::vector<std::atomic<int64_t>> dependencies_;  // Consumers of each node yet to run
+  bool branches_ = false;
+
+  // Parallel runs only
+  std::vector<WorkQueue> queues_;  // One per thread
+  std::vector<std::mutex> locks_;  // Guard each node's grad while consumers deliver to it
+  std::mutex mutex_;               // Guards the fields below
+  std::condition_variable ready_cv_;
+  int64_t queued_ = 0;     // Nodes in the queues
+  int64_t remaining_ = 0;  // Nodes not run yet
+  std::atomic<bool> failed_{false};
+  std::exception_ptr error_;
+};
+
+// Helper class for backpropagation
+class BackwardEngine {
+public:
+  static void execute_backward(Variable& root_var) {
+    // Initialize the root gradient to ones if no gradient is set
+    // This applies to all tensors regardless of shape, as we need to
+    // start the backward pass with a gradient
+    if (!root_var.grad().data_ptr()) {
+      tensor::Tensor ones(root_var.shape(), root_var.data().dtype());
+      ones.allocate();
+      TS_DISPATCH_ALL_TYPES(ones.dtype(), "backward", [&] {
+        scalar_t* ones_ptr = ones.data_ptr<scalar_t>();
+        std::fill(ones_ptr, ones_ptr + ones.numel(), static_cast<scalar_t>(1));
+      });
+      root_var.set_grad(ones);
     }
 
-    topo_order.push_back(&var);
+    if (!root_var.grad_fn()) {
+      return;
+    }
+    GraphTask(root_var.grad_fn().get()).run(root_var.grad());
   }
 };
 
 // Variable::backward implementation
 void Variable::backward() {
-  if (!requires_grad_) {
+  if (!requires_grad()) {
     throw std::runtime_error(
         "Cannot backpropagate through a variable that doesn't require gradients");
   }
@@ -207,72 +810,41 @@ void Variable::backward() {
 
 // Operation implementations
 Variable add(const Variable& a, const Variable& b) {
-  // Create function object
-  auto func = std::make_shared<AddFunction>();
-
-  // Forward pass
-  std::vector<tensor::Tensor> inputs = {a.data(), b.data()};
-  auto outputs = func->forward(inputs);
-
-  // Create output variable
-  bool requires_grad = a.requires_grad() || b.requires_grad();
-
-  // Ensure the output tensor is properly initialized
-  tensor::Tensor result_tensor = outputs[0];
-
-  Variable result(result_tensor, requires_grad);
-
-  if (requires_grad) {
-    // Set gradient function and save inputs for backward pass
-    result.set_grad_fn(func);
-    func->save_for_backward({const_cast<Variable*>(&a), const_cast<Variable*>(&b)});
-  }
-
-  return result;
+  return apply_function<AddFunction>({a, b});
 }
 
 Variable mul(const Variable& a, const Variable& b) {
-  auto func = std::make_shared<MulFunction>();
-
-  std::vector<tensor::Tensor> inputs = {a.data(), b.data()};
-  auto outputs = func->forward(inputs);
-
-  bool requires_grad = a.requires_grad() || b.requires_grad();
-
-  // Ensure the output tensor is properly initialized
-  tensor::Tensor result_tensor = outputs[0];
-
-  Variable result(result_tensor, requires_grad);
-
-  if (requires_grad) {
-    result.set_grad_fn(func);
-    func->save_for_backward({const_cast<Variable*>(&a), const_cast<Variable*>(&b)});
-  }
-
-  return result;
+  return apply_function<MulFunction>({a, b});
 }
 
 Variable matmul(const Variable& a, const Variable& b) {
-  auto func = std::make_shared<MatMulFunction>();
+  return apply_function<MatMulFunction>({a, b});
+}
 
-  std::vector<tensor::Tensor> inputs = {a.data(), b.data()};
-  auto outputs = func->forward(inputs);
+Variable bmm(const Variable& a, const Variable& b) {
+  return apply_function<BmmFunction>({a, b});
+}
 
-  bool requires_grad = a.requires_grad() || b.requires_grad();
+Variable sum(const Variable& a, const tensor::DimVector& dims, bool keepdim) {
+  return apply_function<SumFunction>({a}, dims, keepdim);
+}
 
-  // Ensure the output tensor is properly initialized
-  tensor::Tensor result_tensor = outputs[0];
+Variable mean(const Variable& a, const tensor::DimVector& dims, bool keepdim) {
+  return apply_function<MeanFunction>({a}, dims, keepdim);
+}
 
-  Variable result(result_tensor, requires_grad);
+Variable max(const Variable& a, const tensor::DimVector& dims, bool keepdim) {
+  return apply_function<MaxFunction>({a}, dims, keepdim, /*largest=*/true);
+}
 
-  if (requires_grad) {
-    result.set_grad_fn(func);
-    func->save_for_backward({const_cast<Variable*>(&a), const_cast<Variable*>(&b)});
-  }
+Variable min(const Variable& a, const tensor::DimVector& dims, bool keepdim) {
+  return apply_function<MaxFunction>({a}, dims, keepdim, /*largest=*/false);
+}
 
-  return result;
+Variable norm(const Variable& a, double p, const tensor::DimVector& dims, bool keepdim) {
+  return apply_function<NormFunction>({a}, p, dims, keepdim);
 }
 
 }  // namespace autograd
 }  // namespace core
-}  // namespace torchscratch
\ No newline at end of file
+}  // namespace torchscratch
@@ -0,0 +1,33 @@
+#include "core/autograd/grad_mode.h"
+
+namespace torchscratch {
+namespace core {
+namespace autograd {
+
+namespace {
+
+thread_local bool grad_enabled = true;
+thread_local bool inference_enabled = false;
+
+}  // namespace
+
+bool GradMode::is_enabled() { return grad_enabled; }
+
+void GradMode::set_enabled(bool enabled) { grad_enabled = enabled; }
+
+AutoGradMode::AutoGradMode(bool enabled) : previous_(grad_enabled) { grad_enabled = enabled; }
+
+AutoGradMode::~AutoGradMode() { grad_enabled = previous_; }
+
+InferenceMode::InferenceMode(bool enabled)
+    : previous_inference_(inference_enabled), grad_mode_(!enabled) {
+  inference_enabled = enabled;
+}
+
+InferenceMode::~InferenceMode() { inference_enabled = previous_inference_; }
+
+bool InferenceMode::is_enabled() { return inference_enabled; }
+
+}  // namespace autograd
+}  // namespace core
+}  // namespace torchscratch
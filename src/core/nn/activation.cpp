@@ -2,47 +2,97 @@
 
 #include <algorithm>
 #include <cmath>
+#include <type_traits>
 
 #include "core/autograd/function.h"
+#include "core/tensor/iterator.h"
+#include "core/tensor/vectorized.h"
 
 namespace torchscratch {
 namespace core {
 namespace nn {
 
+namespace {
+
+using UnaryKernel = void (*)(int64_t n, const float* x, float* out);
+using BinaryKernel = void (*)(int64_t n, const float* a, const float* b, float* out);
+
+// output[i] = fn(input[i]) for every floating-point dtype, computed in acc_type.
+// Contiguous float32 runs go through simd instead when one is given.
+template <typename Fn>
+tensor::Tensor map_floating(const tensor::Tensor& input, const char* name, Fn fn,
+                            UnaryKernel simd = nullptr) {
+  tensor::Tensor output(input.shape(), input.dtype());
+  output.allocate();
+
+  // The iterator walks input through its strides, so views need no copy
+  tensor::TensorIterator iter(input.shape(), {&output, &input});
+  TS_DISPATCH_FLOATING_TYPES(input.dtype(), name, [&] {
+    using acc_t = tensor::acc_type<scalar_t>::type;
+    iter.for_each([&](char** data, const int64_t* strides, int64_t n) {
+      if (simd && std::is_same<scalar_t, float>::value && strides[0] == sizeof(float) &&
+          strides[1] == sizeof(float)) {
+        simd(n, reinterpret_cast<const float*>(data[1]), reinterpret_cast<float*>(data[0]));
+        return;
+      }
+      for (int64_t i = 0; i < n; ++i) {
+        const scalar_t& x = *reinterpret_cast<const scalar_t*>(data[1] + i * strides[1]);
+        *reinterpret_cast<scalar_t*>(data[0] + i * strides[0]) =
+            static_cast<scalar_t>(fn(static_cast<acc_t>(x)));
+      }
+    });
+  });
+
+  return output;
+}
+
+// grad_input[i] = fn(saved[i], grad_output[i]), used by the backward passes
+template <typename Fn>
+tensor::Tensor map_floating(const tensor::Tensor& saved, const tensor::Tensor& grad_output,
+                            const char* name, Fn fn, BinaryKernel simd = nullptr) {
+  tensor::Tensor grad_input(saved.shape(), saved.dtype());
+  grad_input.allocate();
+
+  tensor::TensorIterator iter(saved.shape(), {&grad_input, &saved, &grad_output});
+  TS_DISPATCH_FLOATING_TYPES(saved.dtype(), name, [&] {
+    using acc_t = tensor::acc_type<scalar_t>::type;
+    iter.for_each([&](char** data, const int64_t* strides, int64_t n) {
+      if (simd && std::is_same<scalar_t, float>::value && strides[0] == sizeof(float) &&
+          strides[1] == sizeof(float) && strides[2] == sizeof(float)) {
+        simd(n, reinterpret_cast<const float*>(data[1]), reinterpret_cast<const float*>(data[2]),
+             reinterpret_cast<float*>(data[0]));
+        return;
+      }
+      for (int64_t i = 0; i < n; ++i) {
+        const scalar_t& s = *reinterpret_cast<const scalar_t*>(data[1] + i * strides[1]);
+        const scalar_t& g = *reinterpret_cast<const scalar_t*>(data[2] + i * strides[2]);
+        *reinterpret_cast<scalar_t*>(data[0] + i * strides[0]) =
+            static_cast<scalar_t>(fn(static_cast<acc_t>(s), static_cast<acc_t>(g)));
+      }
+    });
+  });
+
+  return grad_input;
+}
+
+}  // namespace
+
 // ReLU Forward Function
 class ReLUFunction : public autograd::Function {
 public:
   std::vector<tensor::Tensor> forward(const std::vector<tensor::Tensor>& inputs) override {
-    const tensor::Tensor& input = inputs[0];
-    tensor::Tensor output(input.shape());
-    output.allocate();
-
-    const float* input_data = input.data_ptr<float>();
-    float* output_data = output.data_ptr<float>();
-
-    for (int64_t i = 0; i < input.numel(); ++i) {
-      output_data[i] = std::max(0.0f, input_data[i]);
-    }
-
-    return {output};
+    save_for_backward({inputs[0]});  // Save input for backward
+    return {map_floating(inputs[0], "relu",
+                         [](auto x) { return std::max(static_cast<decltype(x)>(0), x); },
+                         tensor::elementwise_kernels().relu)};
   }
 
   std::vector<tensor::Tensor> backward(const std::vector<tensor::Tensor>& grad_output) override {
-    const auto& saved_vars = get_saved_variables();
-    const tensor::Tensor& input = saved_vars[0]->data();
-    const tensor::Tensor& grad_out = grad_output[0];
-    tensor::Tensor grad_input(input.shape());
-    grad_input.allocate();
-
-    const float* input_data = input.data_ptr<float>();
-    const float* grad_output_data = grad_out.data_ptr<float>();
-    float* grad_input_data = grad_input.data_ptr<float>();
-
-    for (int64_t i = 0; i < input.numel(); ++i) {
-      grad_input_data[i] = input_data[i] > 0.0f ? grad_output_data[i] : 0.0f;
-    }
-
-    return {grad_input};
+    const tensor::Tensor& input = saved_tensors()[0];
+    return {map_floating(
+        input, grad_output[0], "relu_backward",
+        [](auto x, auto grad) { return x > 0 ? grad : static_cast<decltype(grad)>(0); },
+        tensor::elementwise_kernels().relu_backward)};
   }
 
   std::string name() const override { return "ReLUFunction"; }
@@ -52,37 +102,18 @@ public:
 class SigmoidFunction : public autograd::Function {
 public:
   std::vector<tensor::Tensor> forward(const std::vector<tensor::Tensor>& inputs) override {
-    const tensor::Tensor& input = inputs[0];
-    tensor::Tensor output(input.shape());
-    output.allocate();
-
-    const float* input_data = input.data_ptr<float>();
-    float* output_data = output.data_ptr<float>();
-
-    for (int64_t i = 0; i < input.numel(); ++i) {
-      output_data[i] = 1.0f / (1.0f + std::exp(-input_data[i]));
-    }
-
+    tensor::Tensor output =
+        map_floating(inputs[0], "sigmoid", [](auto x) { return 1 / (1 + std::exp(-x)); },
+                     tensor::elementwise_kernels().sigmoid);
+    save_for_backward({output});  // Save output for sigmoid
     return {output};
   }
 
   std::vector<tensor::Tensor> backward(const std::vector<tensor::Tensor>& grad_output) override {
-    const auto& saved_vars = get_saved_variables();
-    const tensor::Tensor& output = saved_vars[0]->data();  // We save the output for sigmoid
-    const tensor::Tensor& grad_out = grad_output[0];
-    tensor::Tensor grad_input(output.shape());
-    grad_input.allocate();
-
-    const float* output_data = output.data_ptr<float>();
-    const float* grad_output_data = grad_out.data_ptr<float>();
-    float* grad_input_data = grad_input.data_ptr<float>();
-
-    for (int64_t i = 0; i < output.numel(); ++i) {
-      float sig = output_data[i];
-      grad_input_data[i] = grad_output_data[i] * sig * (1.0f - sig);
-    }
-
-    return {grad_input};
+    const tensor::Tensor& output = saved_tensors()[0];  // We save the output for sigmoid
+    return {map_floating(output, grad_output[0], "sigmoid_backward",
+                         [](auto sig, auto grad) { return grad * sig * (1 - sig); },
+                         tensor::elementwise_kernels().sigmoid_backward)};
   }
 
   std::string name() const override { return "SigmoidFunction"; }
@@ -92,100 +123,33 @@ public:
 class TanhFunction : public autograd::Function {
 public:
   std::vector<tensor::Tensor> forward(const std::vector<tensor::Tensor>& inputs) override {
-    const tensor::Tensor& input = inputs[0];
-    tensor::Tensor output(input.shape());
-    output.allocate();
-
-    const float* input_data = input.data_ptr<float>();
-    float* output_data = output.data_ptr<float>();
-
-    for (int64_t i = 0; i < input.numel(); ++i) {
-      output_data[i] = std::tanh(input_data[i]);
-    }
-
+    tensor::Tensor output = map_floating(inputs[0], "tanh", [](auto x) { return std::tanh(x); },
+                                         tensor::elementwise_kernels().tanh);
+    save_for_backward({output});  // Save output for tanh
     return {output};
   }
 
   std::vector<tensor::Tensor> backward(const std::vector<tensor::Tensor>& grad_output) override {
-    const auto& saved_vars = get_saved_variables();
-    const tensor::Tensor& output = saved_vars[0]->data();  // We save the output for tanh
-    const tensor::Tensor& grad_out = grad_output[0];
-    tensor::Tensor grad_input(output.shape());
-    grad_input.allocate();
-
-    const float* output_data = output.data_ptr<float>();
-    const float* grad_output_data = grad_out.data_ptr<float>();
-    float* grad_input_data = grad_input.data_ptr<float>();
-
-    for (int64_t i = 0; i < output.numel(); ++i) {
-      float tanh_val = output_data[i];
-      grad_input_data[i] = grad_output_data[i] * (1.0f - tanh_val * tanh_val);
-    }
-
-    return {grad_input};
+    const tensor::Tensor& output = saved_tensors()[0];  // We save the output for tanh
+    return {map_floating(
+        output, grad_output[0], "tanh_backward",
+        [](auto tanh_val, auto grad) { return grad * (1 - tanh_val * tanh_val); },
+        tensor::elementwise_kernels().tanh_backward)};
   }
 
   std::string name() const override { return "TanhFunction"; }
 };
 
 autograd::Variable relu(const autograd::Variable& input) {
-  auto func = std::make_shared<ReLUFunction>();
-
-  // Forward pass
-  std::vector<tensor::Tensor> result_tensors = func->forward({input.data()});
-  tensor::Tensor result_tensor = result_tensors[0];
-
-  bool requires_grad = input.requires_grad();
-  autograd::Variable result(result_tensor, requires_grad);
-
-  if (requires_grad) {
-    result.set_grad_fn(func);
-    // Create a temporary Variable for saving
-    auto input_var = const_cast<autograd::Variable*>(&input);
-    func->save_for_backward({input_var});  // Save input for backward
-  }
-
-  return result;
+  return autograd::apply_function<ReLUFunction>({input});
 }
 
 autograd::Variable sigmoid(const autograd::Variable& input) {
-  auto func = std::make_shared<SigmoidFunction>();
-
-  // Forward pass
-  std::vector<tensor::Tensor> result_tensors = func->forward({input.data()});
-  tensor::Tensor result_tensor = result_tensors[0];
-
-  bool requires_grad = input.requires_grad();
-  autograd::Variable result(result_tensor, requires_grad);
-
-  if (requires_grad) {
-    result.set_grad_fn(func);
-    // Save output for sigmoid backward pass
-    auto result_var = new autograd::Variable(result_tensor, false);
-    func->save_for_backward({result_var});  // Save output for sigmoid
-  }
-
-  return result;
+  return autograd::apply_function<SigmoidFunction>({input});
 }
 
 autograd::Variable tanh_activation(const autograd::Variable& input) {
-  auto func = std::make_shared<TanhFunction>();
-
-  // Forward pass
-  std::vector<tensor::Tensor> result_tensors = func->forward({input.data()});
-  tensor::Tensor result_tensor = result_tensors[0];
-
-  bool requires_grad = input.requires_grad();
-  autograd::Variable result(result_tensor, requires_grad);
-
-  if (requires_grad) {
-    result.set_grad_fn(func);
-    // Save output for tanh backward pass
-    auto result_var = new autograd::Variable(result_tensor, false);
-    func->save_for_backward({result_var});  // Save output for tanh
-  }
-
-  return result;
+  return autograd::apply_function<TanhFunction>({input});
 }
 
 }  // namespace nn
@@ -1,14 +1,214 @@
 #include "core/nn/linear.h"
 
+#include <algorithm>
 #include <cmath>
+#include <memory>
 #include <random>
+#include <vector>
 
+#include "core/autograd/function.h"
 #include "core/tensor/ops.h"
+#include "core/tensor/parallel.h"
+#include "core/tensor/vectorized.h"
 
 namespace torchscratch {
 namespace core {
 namespace nn {
 
+namespace {
+
+// Rows per block of the float32 sweep; a block's bias partial sums stay in L1
+constexpr int64_t kBiasBlockRows = 64;
+
+// grad_z = grad_output * activation'(z) for output = activation(z), written
+// into grad_z, and when bias_grad is given its column sums in the same sweep.
+// output and grad_output are contiguous [rows, cols]. Reference loop for the
+// dtypes without vectorized kernels
+template <typename scalar_t>
+void activation_backward(const tensor::Tensor& output, const tensor::Tensor& grad_output,
+                         Activation activation, tensor::Tensor& grad_z,
+                         tensor::Tensor* bias_grad) {
+  using acc_t = typename tensor::acc_type<scalar_t>::type;
+  const int64_t cols = output.shape()[output.dim() - 1];
+  const int64_t rows = cols > 0 ? output.numel() / cols : 0;
+  const scalar_t* out = output.data_ptr<scalar_t>();
+  const scalar_t* grad = grad_output.data_ptr<scalar_t>();
+  scalar_t* dz = grad_z.data_ptr<scalar_t>();
+  std::vector<acc_t> column_sums(bias_grad ? cols : 0, acc_t(0));
+
+  for (int64_t i = 0; i < rows; ++i) {
+    for (int64_t j = 0; j < cols; ++j) {
+      const int64_t index = i * cols + j;
+      const acc_t y = static_cast<acc_t>(out[index]);
+      const acc_t g = static_cast<acc_t>(grad[index]);
+      acc_t value = g;
+      switch (activation) {
+        case Activation::ReLU:
+          value = y > 0 ? g : acc_t(0);
+          break;
+        case Activation::Sigmoid:
+          value = g * y * (1 - y);
+          break;
+        case Activation::Tanh:
+          value = g * (1 - y * y);
+          break;
+        default:
+          break;
+      }
+      dz[index] = static_cast<scalar_t>(value);
+      if (bias_grad) {
+        column_sums[j] += value;
+      }
+    }
+  }
+  if (bias_grad) {
+    scalar_t* db = bias_grad->data_ptr<scalar_t>();
+    for (int64_t j = 0; j < cols; ++j) {
+      db[j] = static_cast<scalar_t>(column_sums[j]);
+    }
+  }
+}
+
+// float32 version: the vectorized backward kernel writes a row of grad_z and
+// the row is added to its block's bias partial sums while still in cache.
+// Blocks run in parallel and their partials are summed in a fixed order
+void activation_backward_float(const tensor::Tensor& output, const tensor::Tensor& grad_output,
+                               Activation activation, tensor::Tensor& grad_z,
+                               tensor::Tensor* bias_grad) {
+  const tensor::ElementwiseKernels& kernels = tensor::elementwise_kernels();
+  auto backward = activation == Activation::ReLU      ? kernels.relu_backward
+                  : activation == Activation::Sigmoid ? kernels.sigmoid_backward
+                                                      : kernels.tanh_backward;
+  const int64_t cols = output.shape()[output.dim() - 1];
+  const int64_t rows = cols > 0 ? output.numel() / cols : 0;
+  const int64_t blocks = (rows + kBiasBlockRows - 1) / kBiasBlockRows;
+  const float* out = output.data_ptr<float>();
+  const float* grad = grad_output.data_ptr<float>();
+  float* dz = grad_z.data_ptr<float>();
+  std::vector<float> partials(bias_grad ? blocks * cols : 0, 0.0f);
+
+  const int64_t grain = std::max<int64_t>(1, (int64_t{1} << 14) / std::max<int64_t>(
+                                                 kBiasBlockRows * cols, 1));
+  tensor::parallel_for(0, blocks, grain, [&](int64_t begin, int64_t end) {
+    for (int64_t block = begin; block < end; ++block) {
+      const int64_t row_end = std::min(rows, (block + 1) * kBiasBlockRows);
+      float* partial = bias_grad ? partials.data() + block * cols : nullptr;
+      for (int64_t i = block * kBiasBlockRows; i < row_end; ++i) {
+        // relu_backward tests x > 0, which holds for relu(x) exactly when it does for x
+        backward(cols, out + i * cols, grad + i * cols, dz + i * cols);
+        if (partial) {
+          kernels.add(cols, partial, dz + i * cols, partial);
+        }
+      }
+    }
+  });
+
+  if (bias_grad) {
+    float* db = bias_grad->data_ptr<float>();
+    for (int64_t j = 0; j < cols; ++j) {
+      double total = 0.0;
+      for (int64_t block = 0; block < blocks; ++block) {
+        total += partials[block * cols + j];
+      }
+      db[j] = static_cast<float>(total);
+    }
+  }
+}
+
+// Backward of linear_act. The next edges are input, weight and, when present,
+// bias, matching the order of the returned gradients
+class LinearActFunction : public autograd::Function {
+public:
+  LinearActFunction(Activation activation, bool has_bias)
+      : activation_(activation), has_bias_(has_bias) {}
+
+  std::vector<tensor::Tensor> forward(const std::vector<tensor::Tensor>& inputs) override {
+    tensor::Tensor output = tensor::linear_act(
+        inputs[0], inputs[1], has_bias_ ? inputs[2] : tensor::Tensor(), activation_);
+    // Activation gradients are computed from the output; the bias is not needed
+    save_for_backward({inputs[0], inputs[1], output});
+    return {output};
+  }
+
+  std::vector<tensor::Tensor> backward(const std::vector<tensor::Tensor>& grad_output) override {
+    const tensor::Tensor& input = saved_tensors()[0];
+    const tensor::Tensor& weight = saved_tensors()[1];
+    const tensor::Tensor& output = saved_tensors()[2];
+    const int64_t in_features = weight.shape()[1];
+    const int64_t out_features = weight.shape()[0];
+    const int64_t rows = output.numel() / std::max<int64_t>(out_features, 1);
+
+    const tensor::Tensor grad = grad_output[0].contiguous();
+    const bool bias_grad_needed = has_bias_ && needs_input_grad(2);
+    tensor::Tensor bias_grad;
+    tensor::Tensor grad_z;
+    if (activation_ == Activation::None) {
+      // grad_z is grad itself; the bias gradient is its column sums
+      grad_z = grad.reshape({rows, out_features});
+      if (bias_grad_needed) {
+        bias_grad = tensor::sum(grad_z, {0});
+      }
+    } else {
+      grad_z = tensor::Tensor({rows, out_features}, output.dtype());
+      grad_z.allocate();
+      if (bias_grad_needed) {
+        bias_grad = tensor::Tensor({out_features}, output.dtype());
+        bias_grad.allocate();
+      }
+      tensor::Tensor* bias_out = bias_grad_needed ? &bias_grad : nullptr;
+      if (output.dtype() == tensor::DType::Float32) {
+        activation_backward_float(output, grad, activation_, grad_z, bias_out);
+      } else {
+        TS_DISPATCH_FLOATING_TYPES(output.dtype(), "linear_act_backward", [&] {
+          activation_backward<scalar_t>(output, grad, activation_, grad_z, bias_out);
+        });
+      }
+    }
+
+    // d/dinput = grad_z @ weight, d/dweight = grad_z.T @ input
+    const tensor::Tensor x = input.dim() == 2 ? input : input.reshape({rows, in_features});
+    std::vector<tensor::Tensor> grad_inputs(has_bias_ ? 3 : 2);
+    if (needs_input_grad(0)) {
+      grad_inputs[0] = tensor::matmul(grad_z, weight).reshape(input.shape());
+    }
+    if (needs_input_grad(1)) {
+      grad_inputs[1] = tensor::matmul(grad_z, x, /*trans_a=*/true, /*trans_b=*/false);
+    }
+    if (bias_grad_needed) {
+      grad_inputs[2] = bias_grad;
+    }
+    return grad_inputs;
+  }
+
+  std::string name() const override { return "LinearActFunction"; }
+
+private:
+  Activation activation_;
+  bool has_bias_;
+};
+
+autograd::Variable linear_act_impl(const autograd::Variable& input,
+                                   const autograd::Variable& weight,
+                                   const autograd::Variable* bias, Activation activation) {
+  std::vector<autograd::Variable> inputs = {input, weight};
+  if (bias) {
+    inputs.push_back(*bias);
+  }
+  return autograd::apply_function<LinearActFunction>(inputs, activation, bias != nullptr);
+}
+
+}  // namespace
+
+autograd::Variable linear_act(const autograd::Variable& input, const autograd::Variable& weight,
+                              const autograd::Variable& bias, Activation activation) {
+  return linear_act_impl(input, weight, &bias, activation);
+}
+
+autograd::Variable linear_act(const autograd::Variable& input, const autograd::Variable& weight,
+                              Activation activation) {
+  return linear_act_impl(input, weight, nullptr, activation);
+}
+
 Linear::Linear(int64_t in_features, int64_t out_features, bool bias)
     : has_bias_(bias), in_features_(in_features), out_features_(out_features) {
   // Create weight tensor and allocate
@@ -34,52 +234,10 @@ autograd::Variable Linear::forward(const autograd::Variable& input) {
   // input: [batch_size, in_features]
   // weight: [out_features, in_features]
   // output: [batch_size, out_features]
-
-  // Debug: Print shapes
-  std::cout << "Linear::forward - input shape: [";
-  for (size_t i = 0; i < input.data().shape().size(); ++i) {
-    std::cout << input.data().shape()[i];
-    if (i < input.data().shape().size() - 1)
-      std::cout << ", ";
-  }
-  std::cout << "], dim=" << input.data().dim() << std::endl;
-
-  // Compute input @ weight.T
-  tensor::Tensor weight_t = tensor::transpose(weight_->data());
-  std::cout << "Linear::forward - weight_t shape: [";
-  for (size_t i = 0; i < weight_t.shape().size(); ++i) {
-    std::cout << weight_t.shape()[i];
-    if (i < weight_t.shape().size() - 1)
-      std::cout << ", ";
-  }
-  std::cout << "], dim=" << weight_t.dim() << std::endl;
-
-  tensor::Tensor output_tensor = tensor::matmul(input.data(), weight_t);
-  std::cout << "Linear::forward - matmul result shape: [";
-  for (size_t i = 0; i < output_tensor.shape().size(); ++i) {
-    std::cout << output_tensor.shape()[i];
-    if (i < output_tensor.shape().size() - 1)
-      std::cout << ", ";
-  }
-  std::cout << "], dim=" << output_tensor.dim() << std::endl;
-
-  autograd::Variable output(output_tensor, input.requires_grad() || weight_->requires_grad());
-
   if (has_bias_) {
-    std::cout << "Linear::forward - bias shape: [";
-    for (size_t i = 0; i < bias_->data().shape().size(); ++i) {
-      std::cout << bias_->data().shape()[i];
-      if (i < bias_->data().shape().size() - 1)
-        std::cout << ", ";
-    }
-    std::cout << "], dim=" << bias_->data().dim() << std::endl;
-
-    // Add bias (broadcasting)
-    tensor::Tensor result_tensor = tensor::add(output.data(), bias_->data());
-    output = autograd::Variable(result_tensor, output.requires_grad() || bias_->requires_grad());
+    return linear_act(input, *weight_, *bias_);
   }
-
-  return output;
+  return linear_act(input, *weight_);
 }
 
 std::vector<autograd::Variable*> Linear::parameters() {
@@ -1,101 +1,269 @@
 #include "core/nn/loss.h"
 
+#include <algorithm>
 #include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 #include "core/autograd/function.h"
 #include "core/tensor/ops.h"
+#include "core/tensor/parallel.h"
+#include "core/tensor/vectorized.h"
 
 namespace torchscratch {
 namespace core {
 namespace nn {
 
+const char* reduction_name(Reduction reduction) {
+  switch (reduction) {
+    case Reduction::None:
+      return "none";
+    case Reduction::Sum:
+      return "sum";
+    case Reduction::Mean:
+      return "mean";
+  }
+  return "unknown";
+}
+
+Reduction parse_reduction(const std::string& name) {
+  for (Reduction reduction : {Reduction::None, Reduction::Sum, Reduction::Mean}) {
+    if (name == reduction_name(reduction)) {
+      return reduction;
+    }
+  }
+  throw std::runtime_error("Unknown reduction '" + name + "', expected none, sum or mean");
+}
+
+namespace {
+
+// Fixed chunking keeps the partial sums, and so the result, independent of
+// the number of threads
+constexpr int64_t kMseChunk = int64_t{1} << 15;
+constexpr int64_t kMseBlock = 256;
+
+// Sum of (p - t)^2 over n contiguous elements: the difference a block at a
+// time through the vectorized kernel, its squares accumulated in 8 lanes
+double squared_error_sum(int64_t n, const float* p, const float* t) {
+  const auto& kernels = tensor::elementwise_kernels();
+  float diff[kMseBlock];
+  double total = 0.0;
+  for (int64_t start = 0; start < n; start += kMseBlock) {
+    const int64_t len = std::min(kMseBlock, n - start);
+    kernels.sub(len, p + start, t + start, diff);
+    float lanes[8] = {};
+    int64_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+      for (int k = 0; k < 8; ++k) {
+        lanes[k] += diff[i + k] * diff[i + k];
+      }
+    }
+    for (; i < len; ++i) {
+      lanes[0] += diff[i] * diff[i];
+    }
+    total += ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) +
+             ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+  }
+  return total;
+}
+
+}  // namespace
+
 // MSE Loss Function
 class MSELossFunction : public autograd::Function {
 public:
+  explicit MSELossFunction(Reduction reduction) : reduction_(reduction) {}
+
   std::vector<tensor::Tensor> forward(const std::vector<tensor::Tensor>& inputs) override {
-    const tensor::Tensor& predicted = inputs[0];
-    const tensor::Tensor& target = inputs[1];
+    save_for_backward({inputs[0], inputs[1]});
+    if (!fused(inputs[0], inputs[1])) {
+      // Broadcasting or non-float32 inputs go through the generic ops
+      tensor::Tensor diff = tensor::sub(inputs[0], inputs[1]);
+      tensor::Tensor squared_diff = tensor::mul(diff, diff);
+      if (reduction_ == Reduction::None) {
+        return {squared_diff};
+      }
+      tensor::Tensor total = reduction_ == Reduction::Sum ? tensor::sum(squared_diff)
+                                                          : tensor::mean(squared_diff);
+      return {total.reshape({1})};
+    }
 
-    // Compute (predicted - target)^2
-    tensor::Tensor diff = tensor::sub(predicted, target);
-    tensor::Tensor squared_diff = tensor::mul(diff, diff);
+    // One streaming pass over predicted and target, with no temporaries
+    const tensor::Tensor predicted = inputs[0].contiguous();
+    const tensor::Tensor target = inputs[1].contiguous();
+    const float* pred_data = predicted.data_ptr<float>();
+    const float* target_data = target.data_ptr<float>();
+    const int64_t n = predicted.numel();
+    const int64_t chunks = (n + kMseChunk - 1) / kMseChunk;
+
+    if (reduction_ == Reduction::None) {
+      tensor::Tensor squared_diff(predicted.shape());
+      squared_diff.allocate();
+      float* out = squared_diff.data_ptr<float>();
+      const auto& kernels = tensor::elementwise_kernels();
+      tensor::parallel_for(0, chunks, 1, [&](int64_t begin, int64_t end) {
+        for (int64_t c = begin; c < end; ++c) {
+          const int64_t offset = c * kMseChunk;
+          const int64_t len = std::min(kMseChunk, n - offset);
+          kernels.sub(len, pred_data + offset, target_data + offset, out + offset);
+          kernels.mul(len, out + offset, out + offset, out + offset);
+        }
+      });
+      return {squared_diff};
+    }
 
-    // Mean over all elements
-    float sum = 0.0f;
-    const float* data = squared_diff.data_ptr<float>();
-    for (int64_t i = 0; i < squared_diff.numel(); ++i) {
-      sum += data[i];
+    std::vector<double> partial(chunks);
+    tensor::parallel_for(0, chunks, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t c = begin; c < end; ++c) {
+        const int64_t offset = c * kMseChunk;
+        partial[c] = squared_error_sum(std::min(kMseChunk, n - offset), pred_data + offset,
+                                       target_data + offset);
+      }
+    });
+    double total = 0.0;
+    for (double value : partial) {
+      total += value;
+    }
+    if (reduction_ == Reduction::Mean) {
+      total /= static_cast<double>(n);
     }
 
     tensor::Tensor loss({1});
     loss.allocate();
-    float* loss_data = loss.data_ptr<float>();
-    loss_data[0] = sum / static_cast<float>(squared_diff.numel());
-
+    loss.data_ptr<float>()[0] = static_cast<float>(total);
     return {loss};
   }
 
   std::vector<tensor::Tensor> backward(const std::vector<tensor::Tensor>& grad_output) override {
-    const auto& saved_vars = get_saved_variables();
-    const tensor::Tensor& predicted = saved_vars[0]->data();
-    const tensor::Tensor& target = saved_vars[1]->data();
+    const tensor::Tensor& predicted = saved_tensors()[0];
+    const tensor::Tensor& target = saved_tensors()[1];
     const tensor::Tensor& grad_out = grad_output[0];
-
-    // Gradient w.r.t predicted: 2 * (predicted - target) / N
-    tensor::Tensor grad_predicted = tensor::sub(predicted, target);
-
-    float scale = 2.0f / static_cast<float>(predicted.numel());
-    float* grad_data = grad_predicted.data_ptr<float>();
-    for (int64_t i = 0; i < grad_predicted.numel(); ++i) {
-      grad_data[i] *= scale;
+    const bool need_predicted = needs_input_grad(0);
+    const bool need_target = needs_input_grad(1);
+
+    // d/dpredicted = 2 * (predicted - target) * grad_out [/ N]; d/dtarget is its negation
+    const double scale =
+        reduction_ == Reduction::Mean ? 2.0 / static_cast<double>(predicted.numel()) : 2.0;
+
+    if (!fused(predicted, target) || grad_out.dtype() != tensor::DType::Float32) {
+      tensor::Tensor grad = tensor::sub(predicted, target);
+      tensor::mul_(grad, grad_out);
+      tensor::scale_(grad, scale);
+      tensor::Tensor grad_predicted;
+      tensor::Tensor grad_target;
+      if (need_target) {
+        grad_target = grad.clone();
+        tensor::scale_(grad_target, -1.0);
+        grad_target = tensor::sum_to(grad_target, target.shape());
+      }
+      if (need_predicted) {
+        grad_predicted = tensor::sum_to(grad, predicted.shape());
+      }
+      return {grad_predicted, grad_target};
     }
 
-    // Gradient w.r.t target: -2 * (predicted - target) / N
-    tensor::Tensor grad_target(target.shape());
-    grad_target.allocate();
-    float* grad_target_data = grad_target.data_ptr<float>();
-    for (int64_t i = 0; i < grad_target.numel(); ++i) {
-      grad_target_data[i] = -grad_data[i];
+    const tensor::Tensor pred_c = predicted.contiguous();
+    const tensor::Tensor target_c = target.contiguous();
+    const tensor::Tensor grad_out_c = grad_out.contiguous();
+    const float* pred_data = pred_c.data_ptr<float>();
+    const float* target_data = target_c.data_ptr<float>();
+    const float* grad_out_data = grad_out_c.data_ptr<float>();
+    const int64_t n = pred_c.numel();
+    const int64_t chunks = (n + kMseChunk - 1) / kMseChunk;
+
+    // The first gradient needed is written in one pass; the target's is the
+    // negation of the predicted one when both are needed
+    const float sign = need_predicted ? 1.0f : -1.0f;
+    const bool elementwise = reduction_ == Reduction::None;
+    const float factor = static_cast<float>(elementwise ? scale : scale * grad_out_data[0]) * sign;
+    tensor::Tensor grad(pred_c.shape());
+    grad.allocate();
+    tensor::Tensor negated;
+    if (need_predicted && need_target) {
+      negated = tensor::Tensor(pred_c.shape());
+      negated.allocate();
     }
-
-    return {grad_predicted, grad_target};
+    float* grad_data = grad.data_ptr<float>();
+    float* negated_data = negated.data_ptr() ? negated.data_ptr<float>() : nullptr;
+    const auto& kernels = tensor::elementwise_kernels();
+    tensor::parallel_for(0, chunks, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t c = begin; c < end; ++c) {
+        const int64_t offset = c * kMseChunk;
+        const int64_t len = std::min(kMseChunk, n - offset);
+        float* out = grad_data + offset;
+        kernels.sub(len, pred_data + offset, target_data + offset, out);
+        if (elementwise) {
+          kernels.mul(len, out, grad_out_data + offset, out);
+        }
+        kernels.mul_scalar(len, out, factor, out);
+        if (negated_data) {
+          kernels.mul_scalar(len, out, -1.0f, negated_data + offset);
+        }
+      }
+    });
+
+    if (!need_predicted) {
+      return {tensor::Tensor(), grad};
+    }
+    return {grad, negated};
   }
 
   std::string name() const override { return "MSELossFunction"; }
+
+private:
+  // Same-shape float32 operands take the single-pass kernels
+  static bool fused(const tensor::Tensor& predicted, const tensor::Tensor& target) {
+    return predicted.dtype() == tensor::DType::Float32 &&
+           target.dtype() == tensor::DType::Float32 && predicted.shape() == target.shape();
+  }
+
+  Reduction reduction_;
 };
 
 // Binary Cross Entropy Loss Function
 class BCELossFunction : public autograd::Function {
 public:
   std::vector<tensor::Tensor> forward(const std::vector<tensor::Tensor>& inputs) override {
-    const tensor::Tensor& predicted = inputs[0];
-    const tensor::Tensor& target = inputs[1];
+    // The loops below index the data densely
+    const tensor::Tensor predicted = inputs[0].contiguous();
+    const tensor::Tensor target = inputs[1].contiguous();
+    save_for_backward({predicted, target});
 
     // BCE = -[target * log(predicted) + (1 - target) * log(1 - predicted)]
-    float sum = 0.0f;
+    tensor::Tensor terms(predicted.shape());
+    terms.allocate();
+    float* term_data = terms.data_ptr<float>();
     const float* pred_data = predicted.data_ptr<float>();
     const float* target_data = target.data_ptr<float>();
 
     const float eps = 1e-8f;  // For numerical stability
 
-    for (int64_t i = 0; i < predicted.numel(); ++i) {
-      float p = std::max(eps, std::min(1.0f - eps, pred_data[i]));
-      float t = target_data[i];
-      sum += -(t * std::log(p) + (1.0f - t) * std::log(1.0f - p));
+    // log(p) and log(1 - p) a block at a time through the vectorized kernel
+    constexpr int64_t kBlock = 256;
+    float log_p[kBlock];
+    float log_q[kBlock];
+    const auto& kernels = tensor::elementwise_kernels();
+    for (int64_t start = 0; start < predicted.numel(); start += kBlock) {
+      const int64_t len = std::min(kBlock, predicted.numel() - start);
+      for (int64_t i = 0; i < len; ++i) {
+        log_p[i] = std::max(eps, std::min(1.0f - eps, pred_data[start + i]));
+        log_q[i] = 1.0f - log_p[i];
+      }
+      kernels.log(len, log_p, log_p);
+      kernels.log(len, log_q, log_q);
+      for (int64_t i = 0; i < len; ++i) {
+        float t = target_data[start + i];
+        term_data[start + i] = -(t * log_p[i] + (1.0f - t) * log_q[i]);
+      }
     }
 
-    tensor::Tensor loss({1});
-    loss.allocate();
-    float* loss_data = loss.data_ptr<float>();
-    loss_data[0] = sum / static_cast<float>(predicted.numel());
-
-    return {loss};
+    return {tensor::mean(terms).reshape({1})};
   }
 
   std::vector<tensor::Tensor> backward(const std::vector<tensor::Tensor>& grad_output) override {
-    const auto& saved_vars = get_saved_variables();
-    const tensor::Tensor& predicted = saved_vars[0]->data();
-    const tensor::Tensor& target = saved_vars[1]->data();
+    const tensor::Tensor& predicted = saved_tensors()[0];
+    const tensor::Tensor& target = saved_tensors()[1];
     const tensor::Tensor& grad_out = grad_output[0];
 
     // Gradient w.r.t predicted: -(target/predicted - (1-target)/(1-predicted)) / N
@@ -126,52 +294,179 @@ public:
   std::string name() const override { return "BCELossFunction"; }
 };
 
-autograd::Variable mse_loss(const autograd::Variable& predicted, const autograd::Variable& target) {
-  auto func = std::make_shared<MSELossFunction>();
-
-  // Forward pass
-  std::vector<tensor::Tensor> result_tensors = func->forward({predicted.data(), target.data()});
-  tensor::Tensor result_tensor = result_tensors[0];
+// Cross Entropy Loss Function: log-softmax and NLL fused over [batch, classes]
+// logits, one row at a time
+class CrossEntropyLossFunction : public autograd::Function {
+public:
+  CrossEntropyLossFunction(float label_smoothing, int64_t ignore_index)
+      : label_smoothing_(label_smoothing), ignore_index_(ignore_index) {}
 
-  bool requires_grad = predicted.requires_grad() || target.requires_grad();
-  autograd::Variable result(result_tensor, requires_grad);
+  std::vector<tensor::Tensor> forward(const std::vector<tensor::Tensor>& inputs) override {
+    const tensor::Tensor logits = inputs[0].contiguous();
+    const tensor::Tensor target = class_targets(inputs[1], logits);
+    const int64_t batch = logits.shape()[0];
+    const int64_t classes = logits.shape()[1];
+    const float* logit_data = logits.data_ptr<float>();
+    const int32_t* target_data = target.data_ptr<int32_t>();
+
+    count_ = 0;
+    for (int64_t r = 0; r < batch; ++r) {
+      if (target_data[r] == ignore_index_) {
+        continue;
+      }
+      if (target_data[r] < 0 || target_data[r] >= classes) {
+        throw std::runtime_error("cross_entropy_loss: target " + std::to_string(target_data[r]) +
+                                 " is out of range for " + std::to_string(classes) + " classes");
+      }
+      ++count_;
+    }
 
-  if (requires_grad) {
-    result.set_grad_fn(func);
-    auto pred_var = const_cast<autograd::Variable*>(&predicted);
-    auto target_var = const_cast<autograd::Variable*>(&target);
-    func->save_for_backward({pred_var, target_var});
+    // Per row: lse = max + log(sum(exp(x - max))), loss = lse - x[target],
+    // blended with the mean of lse - x[j] over all classes when smoothing. Only
+    // lse is kept for the backward pass, besides the inputs.
+    tensor::Tensor lse({batch});
+    lse.allocate();
+    tensor::Tensor row_loss({batch});
+    row_loss.allocate();
+    float* lse_data = lse.data_ptr<float>();
+    float* loss_data = row_loss.data_ptr<float>();
+    const float smoothing = label_smoothing_;
+    const int64_t ignore_index = ignore_index_;
+    const auto& kernels = tensor::elementwise_kernels();
+
+    const int64_t grain = std::max<int64_t>(1, (int64_t{1} << 15) / std::max<int64_t>(1, classes));
+    tensor::parallel_for(0, batch, grain, [&](int64_t begin, int64_t end) {
+      constexpr int64_t kBlock = 256;
+      float shifted[kBlock];
+      for (int64_t r = begin; r < end; ++r) {
+        const float* x = logit_data + r * classes;
+        if (target_data[r] == ignore_index) {
+          lse_data[r] = 0.0f;
+          loss_data[r] = 0.0f;
+          continue;
+        }
+
+        float row_max = -INFINITY;
+        double row_sum = 0.0;
+        for (int64_t j = 0; j < classes; ++j) {
+          row_max = std::max(row_max, x[j]);
+          row_sum += x[j];
+        }
+        double exp_sum = 0.0;
+        for (int64_t start = 0; start < classes; start += kBlock) {
+          const int64_t len = std::min(kBlock, classes - start);
+          kernels.add_scalar(len, x + start, -row_max, shifted);
+          kernels.exp(len, shifted, shifted);
+          float block_sum = 0.0f;
+          for (int64_t i = 0; i < len; ++i) {
+            block_sum += shifted[i];
+          }
+          exp_sum += block_sum;
+        }
+
+        const double row_lse = row_max + std::log(exp_sum);
+        lse_data[r] = static_cast<float>(row_lse);
+        double loss = row_lse - x[target_data[r]];
+        if (smoothing > 0.0f) {
+          loss = (1.0 - smoothing) * loss + smoothing * (row_lse - row_sum / classes);
+        }
+        loss_data[r] = static_cast<float>(loss);
+      }
+    });
+
+    save_for_backward({logits, target, lse});
+
+    // Mean over the rows that were not ignored (NaN when all were, like 0 / 0)
+    tensor::Tensor loss = tensor::sum(row_loss).reshape({1});
+    loss.data_ptr<float>()[0] /= static_cast<float>(count_);
+    return {loss};
   }
 
-  return result;
-}
+  std::vector<tensor::Tensor> backward(const std::vector<tensor::Tensor>& grad_output) override {
+    const tensor::Tensor& logits = saved_tensors()[0];
+    const tensor::Tensor& target = saved_tensors()[1];
+    const int64_t batch = logits.shape()[0];
+    const int64_t classes = logits.shape()[1];
+
+    // d/dx[j] = (softmax(x)[j] - (1 - smoothing) * onehot[j] - smoothing / classes) * g / count,
+    // with the softmax written straight into the gradient buffer as exp(x - lse)
+    tensor::Tensor grad_logits(logits.shape());
+    grad_logits.allocate();
+    const float* logit_data = logits.data_ptr<float>();
+    const int32_t* target_data = target.data_ptr<int32_t>();
+    const float* lse_data = saved_tensors()[2].data_ptr<float>();
+    float* grad_data = grad_logits.data_ptr<float>();
+    const float scale =
+        grad_output[0].contiguous().data_ptr<float>()[0] / static_cast<float>(count_);
+    const float uniform = label_smoothing_ / static_cast<float>(classes);
+    const float hit = (1.0f - label_smoothing_) * scale;
+    const int64_t ignore_index = ignore_index_;
+    const auto& kernels = tensor::elementwise_kernels();
+
+    const int64_t grain = std::max<int64_t>(1, (int64_t{1} << 15) / std::max<int64_t>(1, classes));
+    tensor::parallel_for(0, batch, grain, [&](int64_t begin, int64_t end) {
+      for (int64_t r = begin; r < end; ++r) {
+        float* out = grad_data + r * classes;
+        if (target_data[r] == ignore_index) {
+          std::fill(out, out + classes, 0.0f);
+          continue;
+        }
+        kernels.add_scalar(classes, logit_data + r * classes, -lse_data[r], out);
+        kernels.exp(classes, out, out);
+        if (uniform != 0.0f) {
+          kernels.add_scalar(classes, out, -uniform, out);
+        }
+        kernels.mul_scalar(classes, out, scale, out);
+        out[target_data[r]] -= hit;
+      }
+    });
+
+    // Class indices are not differentiable
+    return {grad_logits};
+  }
 
-autograd::Variable binary_cross_entropy_loss(const autograd::Variable& predicted,
-                                             const autograd::Variable& target) {
-  auto func = std::make_shared<BCELossFunction>();
+  std::string name() const override { return "CrossEntropyLossFunction"; }
 
-  // Forward pass
-  std::vector<tensor::Tensor> result_tensors = func->forward({predicted.data(), target.data()});
-  tensor::Tensor result_tensor = result_tensors[0];
+private:
+  // Validate the shapes and return the targets as contiguous Int32 indices
+  static tensor::Tensor class_targets(const tensor::Tensor& target, const tensor::Tensor& logits) {
+    if (logits.dim() != 2 || logits.dtype() != tensor::DType::Float32) {
+      throw std::runtime_error("cross_entropy_loss expects [batch, classes] float32 logits");
+    }
+    if (target.dim() != 1 || target.shape()[0] != logits.shape()[0]) {
+      throw std::runtime_error("cross_entropy_loss expects one class index per row of logits");
+    }
+    if (target.dtype() == tensor::DType::Int32) {
+      return target.contiguous();
+    }
+    return target.to(tensor::DType::Int32);
+  }
 
-  bool requires_grad = predicted.requires_grad() || target.requires_grad();
-  autograd::Variable result(result_tensor, requires_grad);
+  float label_smoothing_;
+  int64_t ignore_index_;
+  int64_t count_ = 0;
+};
 
-  if (requires_grad) {
-    result.set_grad_fn(func);
-    auto pred_var = const_cast<autograd::Variable*>(&predicted);
-    auto target_var = const_cast<autograd::Variable*>(&target);
-    func->save_for_backward({pred_var, target_var});
-  }
+autograd::Variable mse_loss(const autograd::Variable& predicted, const autograd::Variable& target,
+                            Reduction reduction) {
+  return autograd::apply_function<MSELossFunction>({predicted, target}, reduction);
+}
 
-  return result;
+autograd::Variable binary_cross_entropy_loss(const autograd::Variable& predicted,
+                                             const autograd::Variable& target) {
+  return autograd::apply_function<BCELossFunction>({predicted, target});
 }
 
 autograd::Variable cross_entropy_loss(const autograd::Variable& predicted,
-                                      const autograd::Variable& target) {
-  // For now, implement as a placeholder
-  // Full cross-entropy would require softmax + log-likelihood
-  return binary_cross_entropy_loss(predicted, target);
+                                      const autograd::Variable& target, float label_smoothing,
+                                      int64_t ignore_index) {
+  if (label_smoothing < 0.0f || label_smoothing > 1.0f) {
+    throw std::runtime_error("cross_entropy_loss: label_smoothing must be in [0, 1]");
+  }
+  // Only the logits are differentiable; class indices get no gradient, even if
+  // they require one
+  return autograd::apply_function<CrossEntropyLossFunction>({predicted, target.detach()},
+                                                            label_smoothing, ignore_index);
 }
 
 }  // namespace nn
@@ -2,6 +2,8 @@
 
 #include <cstring>
 
+#include "core/tensor/ops.h"
+
 namespace torchscratch {
 namespace core {
 namespace optim {
@@ -17,11 +19,10 @@ SGD::SGD(std::vector<autograd::Variable*> parameters, double learning_rate, doub
   if (momentum_ > 0.0) {
     velocity_.reserve(parameters_.size());
     for (auto* param : parameters_) {
-      tensor::Tensor vel(param->data().shape());
+      tensor::Tensor vel(param->data().shape(), param->data().dtype());
       vel.allocate();
       // Initialize to zero
-      float* vel_data = vel.data_ptr<float>();
-      std::memset(vel_data, 0, sizeof(float) * vel.numel());
+      std::memset(vel.data_ptr(), 0, vel.nbytes());
       velocity_.push_back(std::move(vel));
     }
   }
@@ -32,46 +33,32 @@ void SGD::step() {
     autograd::Variable* param = parameters_[i];
 
     // Skip if no gradient
-    if (param->grad().data_ptr<float>() == nullptr) {
+    if (param->grad().data_ptr() == nullptr) {
       continue;
     }
 
-    const float* grad_data = param->grad().data_ptr<float>();
-    float* param_data = param->data().data_ptr<float>();
+    // Views of the parameter and gradient buffers; the in-place ops write through them
+    tensor::Tensor grad = param->grad();
+    tensor::Tensor data = param->data();
 
-    // Apply weight decay if specified
+    // Apply weight decay if specified: grad = grad + weight_decay * param
     if (weight_decay_ > 0.0) {
-      for (int64_t j = 0; j < param->data().numel(); ++j) {
-        // grad = grad + weight_decay * param
-        const_cast<float*>(grad_data)[j] += static_cast<float>(weight_decay_) * param_data[j];
-      }
+      tensor::axpy_(grad, weight_decay_, data);
     }
 
     if (momentum_ > 0.0) {
-      // Momentum update: v = momentum * v + grad
-      float* vel_data = velocity_[i].data_ptr<float>();
-
-      if (first_step_) {
-        // First step: velocity = grad
-        for (int64_t j = 0; j < param->data().numel(); ++j) {
-          vel_data[j] = grad_data[j];
-        }
-      } else {
-        // Subsequent steps: velocity = momentum * velocity + grad
-        for (int64_t j = 0; j < param->data().numel(); ++j) {
-          vel_data[j] = static_cast<float>(momentum_) * vel_data[j] + grad_data[j];
-        }
+      // Momentum update: v = momentum * v + grad (v starts at zero, so the first step is v = grad)
+      tensor::Tensor& vel = velocity_[i];
+      if (!first_step_) {
+        tensor::scale_(vel, momentum_);
       }
+      tensor::add_(vel, grad);
 
       // Update parameters: param = param - lr * velocity
-      for (int64_t j = 0; j < param->data().numel(); ++j) {
-        param_data[j] -= static_cast<float>(learning_rate_) * vel_data[j];
-      }
+      tensor::axpy_(data, -learning_rate_, vel);
     } else {
       // Standard SGD update: param = param - lr * grad
-      for (int64_t j = 0; j < param->data().numel(); ++j) {
-        param_data[j] -= static_cast<float>(learning_rate_) * grad_data[j];
-      }
+      tensor::axpy_(data, -learning_rate_, grad);
     }
   }
 
@@ -80,9 +67,8 @@ void SGD::step() {
 
 void SGD::zero_grad() {
   for (auto* param : parameters_) {
-    if (param->grad().data_ptr<float>() != nullptr) {
-      float* grad_data = param->grad().data_ptr<float>();
-      std::memset(grad_data, 0, sizeof(float) * param->grad().numel());
+    if (param->grad().data_ptr() != nullptr) {
+      std::memset(param->grad().data_ptr(), 0, param->grad().nbytes());
     }
   }
 }
@@ -0,0 +1,156 @@
+#include "core/tensor/allocator.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace torchscratch {
+namespace core {
+namespace tensor {
+
+namespace {
+
+constexpr std::size_t kMinBlockSize = 64;
+
+void* aligned_alloc_bytes(std::size_t size) {
+  void* ptr = nullptr;
+#ifdef _WIN32
+  ptr = _aligned_malloc(size, CachingAllocator::kAlignment);
+#else
+  if (posix_memalign(&ptr, CachingAllocator::kAlignment, size) != 0) {
+    ptr = nullptr;
+  }
+#endif
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void aligned_free_bytes(void* ptr) {
+#ifdef _WIN32
+  _aligned_free(ptr);
+#else
+  std::free(ptr);
+#endif
+}
+
+}  // namespace
+
+constexpr std::size_t CachingAllocator::kAlignment;
+
+CachingAllocator& CachingAllocator::instance() {
+  // Intentionally leaked: tensors with static lifetime may free into it during exit
+  static CachingAllocator* allocator = new CachingAllocator();
+  return *allocator;
+}
+
+CachingAllocator::~CachingAllocator() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  release_all_locked();
+}
+
+std::size_t CachingAllocator::round_size(std::size_t nbytes) {
+  if (nbytes <= kMinBlockSize) {
+    return kMinBlockSize;
+  }
+  // Four classes per power of two keeps the worst-case waste at 25%
+  std::size_t power = kMinBlockSize;
+  while (power * 2 < nbytes) {
+    power *= 2;
+  }
+  std::size_t step = power / 4;
+  return (nbytes + step - 1) / step * step;
+}
+
+void* CachingAllocator::allocate(std::size_t nbytes) {
+  std::size_t size = round_size(nbytes);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.bytes_in_use += size;
+    stats_.peak_bytes_in_use = std::max(stats_.peak_bytes_in_use, stats_.bytes_in_use);
+
+    auto it = free_blocks_.find(size);
+    if (it != free_blocks_.end() && !it->second.empty()) {
+      void* ptr = it->second.back();
+      it->second.pop_back();
+      stats_.bytes_cached -= size;
+      ++stats_.hits;
+      return ptr;
+    }
+    ++stats_.misses;
+  }
+
+  try {
+    return aligned_alloc_bytes(size);
+  } catch (const std::bad_alloc&) {
+    // Give the cached blocks back to the system and retry once
+    std::lock_guard<std::mutex> lock(mutex_);
+    release_all_locked();
+  }
+  try {
+    return aligned_alloc_bytes(size);
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.bytes_in_use -= size;
+    throw;
+  }
+}
+
+void CachingAllocator::deallocate(void* ptr, std::size_t nbytes) {
+  if (!ptr) {
+    return;
+  }
+  std::size_t size = round_size(nbytes);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.bytes_in_use -= size;
+    if (stats_.bytes_cached + size <= max_cached_bytes_) {
+      free_blocks_[size].push_back(ptr);
+      stats_.bytes_cached += size;
+      return;
+    }
+  }
+  aligned_free_bytes(ptr);
+}
+
+void CachingAllocator::empty_cache() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  release_all_locked();
+}
+
+void CachingAllocator::set_max_cached_bytes(std::size_t max_bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  max_cached_bytes_ = max_bytes;
+  if (stats_.bytes_cached > max_cached_bytes_) {
+    release_all_locked();
+  }
+}
+
+AllocatorStats CachingAllocator::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void CachingAllocator::reset_peak_stats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.peak_bytes_in_use = stats_.bytes_in_use;
+}
+
+void CachingAllocator::release_all_locked() {
+  for (auto& entry : free_blocks_) {
+    for (void* ptr : entry.second) {
+      aligned_free_bytes(ptr);
+    }
+  }
+  free_blocks_.clear();
+  stats_.bytes_cached = 0;
+}
+
+}  // namespace tensor
+}  // namespace core
+}  // namespace torchscratch
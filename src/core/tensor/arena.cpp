@@ -0,0 +1,107 @@
+#include "core/tensor/arena.h"
+
+#include <algorithm>
+
+#include "core/tensor/allocator.h"
+
+namespace torchscratch {
+namespace core {
+namespace tensor {
+
+namespace {
+
+thread_local StepArena* current_arena = nullptr;
+
+std::size_t align_up(std::size_t value, std::size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace
+
+// One contiguous block; storages carved out of it hold a reference to it
+struct StepArena::Chunk {
+  explicit Chunk(std::size_t size)
+      : data(static_cast<char*>(CachingAllocator::instance().allocate(size))), size(size) {}
+
+  Chunk(const Chunk&) = delete;
+  Chunk& operator=(const Chunk&) = delete;
+
+  ~Chunk() { CachingAllocator::instance().deallocate(data, size); }
+
+  char* data;
+  std::size_t size;
+  std::size_t offset = 0;
+};
+
+StepArena::StepArena(std::size_t chunk_size) : chunk_size_(chunk_size) {}
+
+StepArena::~StepArena() {
+  if (current_arena == this) {
+    current_arena = nullptr;
+  }
+}
+
+std::shared_ptr<Storage> StepArena::allocate(std::size_t nbytes) {
+  std::size_t size = align_up(std::max<std::size_t>(nbytes, 1), CachingAllocator::kAlignment);
+
+  // Bump within the active chunk, moving on to the next reusable one when it is full
+  while (active_chunk_ < chunks_.size() &&
+         chunks_[active_chunk_]->offset + size > chunks_[active_chunk_]->size) {
+    ++active_chunk_;
+  }
+  if (active_chunk_ == chunks_.size()) {
+    chunks_.push_back(std::make_shared<Chunk>(std::max(size, chunk_size_)));
+  }
+
+  std::shared_ptr<Chunk> chunk = chunks_[active_chunk_];
+  char* data = chunk->data + chunk->offset;
+  chunk->offset += size;
+  bytes_used_ += size;
+
+  // Freeing an arena tensor is a no-op apart from releasing its hold on the chunk
+  auto storage = std::make_shared<Storage>(data, nbytes, [chunk](void*) {});
+  storage->from_arena_ = true;
+  return storage;
+}
+
+void StepArena::reset() {
+  std::vector<std::shared_ptr<Chunk>> kept;
+  kept.reserve(chunks_.size());
+  for (auto& chunk : chunks_) {
+    // Only the arena references the chunk: every tensor in it is dead
+    if (chunk.use_count() == 1) {
+      chunk->offset = 0;
+      kept.push_back(std::move(chunk));
+    }
+  }
+  chunks_ = std::move(kept);
+  active_chunk_ = 0;
+  bytes_used_ = 0;
+}
+
+StepArena* StepArena::current() { return current_arena; }
+
+std::size_t StepArena::capacity() const {
+  std::size_t total = 0;
+  for (const auto& chunk : chunks_) {
+    total += chunk->size;
+  }
+  return total;
+}
+
+StepArenaGuard::StepArenaGuard(StepArena& arena) : arena_(arena), previous_(current_arena) {
+  current_arena = &arena;
+}
+
+StepArenaGuard::~StepArenaGuard() {
+  current_arena = previous_;
+  arena_.reset();
+}
+
+NoStepArenaGuard::NoStepArenaGuard() : previous_(current_arena) { current_arena = nullptr; }
+
+NoStepArenaGuard::~NoStepArenaGuard() { current_arena = previous_; }
+
+}  // namespace tensor
+}  // namespace core
+}  // namespace torchscratch
@@ -0,0 +1,54 @@
+#include "core/tensor/dtype.h"
+
+namespace torchscratch {
+namespace core {
+namespace tensor {
+
+constexpr DType dtype_of<float>::value;
+constexpr DType dtype_of<double>::value;
+constexpr DType dtype_of<int32_t>::value;
+constexpr DType dtype_of<int8_t>::value;
+constexpr DType dtype_of<BFloat16>::value;
+constexpr DType dtype_of<Half>::value;
+
+std::size_t element_size(DType dtype) {
+  switch (dtype) {
+    case DType::Float32:
+      return sizeof(float);
+    case DType::Float64:
+      return sizeof(double);
+    case DType::Int32:
+      return sizeof(int32_t);
+    case DType::Int8:
+      return sizeof(int8_t);
+    case DType::BFloat16:
+      return sizeof(BFloat16);
+    case DType::Float16:
+      return sizeof(Half);
+  }
+  throw std::runtime_error("Unknown dtype");
+}
+
+const char* dtype_name(DType dtype) {
+  switch (dtype) {
+    case DType::Float32:
+      return "float32";
+    case DType::Float64:
+      return "float64";
+    case DType::Int32:
+      return "int32";
+    case DType::Int8:
+      return "int8";
+    case DType::BFloat16:
+      return "bfloat16";
+    case DType::Float16:
+      return "float16";
+  }
+  return "unknown";
+}
+
+bool is_floating_point(DType dtype) { return dtype != DType::Int32 && dtype != DType::Int8; }
+
+}  // namespace tensor
+}  // namespace core
+}  // namespace torchscratch
@@ -0,0 +1,620 @@
+#include "core/tensor/gemm.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "core/tensor/allocator.h"
+#include "core/tensor/dtype.h"
+#include "core/tensor/parallel.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define TS_GEMM_X86 1
+#include <immintrin.h>
+#else
+#define TS_GEMM_X86 0
+#endif
+
+namespace torchscratch {
+namespace core {
+namespace tensor {
+
+namespace {
+
+// Cache blocking, in elements. A KC-deep micro-panel of A and B stays in L1
+// while the micro-kernel runs, an MC x KC block of packed A in L2, and a
+// KC x NC block of packed B in L3. MC and NC are multiples of every MR and NR.
+constexpr int64_t kKC = 256;
+constexpr int64_t kMC = 96;
+constexpr int64_t kNC = 2048;
+
+// Products with fewer multiply-adds than this (about 100^3) stay on one thread
+constexpr int64_t kMinParallelWork = int64_t(1) << 20;
+
+// tile[MR x NR] = sum over p of a[p * MR + i] * b[p * NR + j]
+template <typename T>
+using MicroKernel = void (*)(int64_t k, const T* a, const T* b, T* tile);
+
+template <typename T>
+struct KernelInfo {
+  int64_t mr;
+  int64_t nr;
+  MicroKernel<T> fn;
+};
+
+template <typename T, int MR, int NR>
+void micro_kernel_scalar(int64_t k, const T* a, const T* b, T* tile) {
+  T acc[MR][NR] = {};
+  for (int64_t p = 0; p < k; ++p) {
+    for (int i = 0; i < MR; ++i) {
+      const T a_i = a[i];
+      for (int j = 0; j < NR; ++j) {
+        acc[i][j] += a_i * b[j];
+      }
+    }
+    a += MR;
+    b += NR;
+  }
+  for (int i = 0; i < MR; ++i) {
+    for (int j = 0; j < NR; ++j) {
+      tile[i * NR + j] = acc[i][j];
+    }
+  }
+}
+
+#if TS_GEMM_X86
+
+// 6 x 16 tile held in 12 ymm accumulators
+__attribute__((target("avx2,fma"))) void micro_kernel_avx2(int64_t k, const float* a,
+                                                          const float* b, float* tile) {
+  __m256 c0[6];
+  __m256 c1[6];
+  for (int i = 0; i < 6; ++i) {
+    c0[i] = _mm256_setzero_ps();
+    c1[i] = _mm256_setzero_ps();
+  }
+  for (int64_t p = 0; p < k; ++p) {
+    // Packed B panels are 64-byte aligned and 16 floats wide
+    const __m256 b0 = _mm256_load_ps(b);
+    const __m256 b1 = _mm256_load_ps(b + 8);
+    for (int i = 0; i < 6; ++i) {
+      const __m256 a_i = _mm256_broadcast_ss(a + i);
+      c0[i] = _mm256_fmadd_ps(a_i, b0, c0[i]);
+      c1[i] = _mm256_fmadd_ps(a_i, b1, c1[i]);
+    }
+    a += 6;
+    b += 16;
+  }
+  for (int i = 0; i < 6; ++i) {
+    _mm256_storeu_ps(tile + i * 16, c0[i]);
+    _mm256_storeu_ps(tile + i * 16 + 8, c1[i]);
+  }
+}
+
+// 6 x 32 tile held in 12 zmm accumulators
+__attribute__((target("avx512f"))) void micro_kernel_avx512(int64_t k, const float* a,
+                                                           const float* b, float* tile) {
+  __m512 c0[6];
+  __m512 c1[6];
+  for (int i = 0; i < 6; ++i) {
+    c0[i] = _mm512_setzero_ps();
+    c1[i] = _mm512_setzero_ps();
+  }
+  for (int64_t p = 0; p < k; ++p) {
+    const __m512 b0 = _mm512_load_ps(b);
+    const __m512 b1 = _mm512_load_ps(b + 16);
+    for (int i = 0; i < 6; ++i) {
+      const __m512 a_i = _mm512_set1_ps(a[i]);
+      c0[i] = _mm512_fmadd_ps(a_i, b0, c0[i]);
+      c1[i] = _mm512_fmadd_ps(a_i, b1, c1[i]);
+    }
+    a += 6;
+    b += 32;
+  }
+  for (int i = 0; i < 6; ++i) {
+    _mm512_storeu_ps(tile + i * 32, c0[i]);
+    _mm512_storeu_ps(tile + i * 32 + 16, c1[i]);
+  }
+}
+
+#endif  // TS_GEMM_X86
+
+GemmIsa detect_isa() {
+#if TS_GEMM_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return GemmIsa::AVX512;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return GemmIsa::AVX2;
+  }
+#endif
+  return GemmIsa::Scalar;
+}
+
+std::atomic<GemmIsa>& active_isa() {
+  static std::atomic<GemmIsa> isa(gemm_max_isa());
+  return isa;
+}
+
+template <typename T>
+KernelInfo<T> select_kernel();
+
+template <>
+KernelInfo<float> select_kernel<float>() {
+  switch (gemm_isa()) {
+#if TS_GEMM_X86
+    case GemmIsa::AVX512:
+      return {6, 32, micro_kernel_avx512};
+    case GemmIsa::AVX2:
+      return {6, 16, micro_kernel_avx2};
+#endif
+    default:
+      return {4, 8, micro_kernel_scalar<float, 4, 8>};
+  }
+}
+
+template <>
+KernelInfo<double> select_kernel<double>() {
+  return {4, 8, micro_kernel_scalar<double, 4, 8>};
+}
+
+// Scratch space for packed panels, recycled through the caching allocator
+class PackBuffer {
+public:
+  explicit PackBuffer(std::size_t nbytes)
+      : nbytes_(nbytes), data_(CachingAllocator::instance().allocate(nbytes)) {}
+
+  PackBuffer(const PackBuffer&) = delete;
+  PackBuffer& operator=(const PackBuffer&) = delete;
+
+  ~PackBuffer() { CachingAllocator::instance().deallocate(data_, nbytes_); }
+
+  template <typename T>
+  T* as() const {
+    return static_cast<T*>(data_);
+  }
+
+private:
+  std::size_t nbytes_;
+  void* data_;
+};
+
+template <typename T, typename scalar_t>
+T widen(const scalar_t& value) {
+  return static_cast<T>(static_cast<typename acc_type<scalar_t>::type>(value));
+}
+
+// Pack B[kc, nc] into NR-wide column panels, each laid out p-major and
+// zero-padded to a full NR
+template <typename T, typename scalar_t>
+void pack_b(int64_t kc, int64_t nc, int64_t nr, const scalar_t* b, int64_t row_stride,
+            int64_t col_stride, T* out) {
+  for (int64_t jp = 0; jp < nc; jp += nr) {
+    const int64_t cols = std::min(nr, nc - jp);
+    if (row_stride == 1 && col_stride != 1) {
+      // B used transposed (NT): each column is contiguous in k, so read it
+      // sequentially and scatter into the panel, which stays in L1
+      int64_t j = 0;
+      for (; j < cols; ++j) {
+        const scalar_t* column = b + (jp + j) * col_stride;
+        for (int64_t p = 0; p < kc; ++p) {
+          out[p * nr + j] = widen<T>(column[p]);
+        }
+      }
+      for (; j < nr; ++j) {
+        for (int64_t p = 0; p < kc; ++p) {
+          out[p * nr + j] = T(0);
+        }
+      }
+      out += kc * nr;
+      continue;
+    }
+    for (int64_t p = 0; p < kc; ++p) {
+      const scalar_t* row = b + p * row_stride + jp * col_stride;
+      int64_t j = 0;
+      for (; j < cols; ++j) {
+        out[j] = widen<T>(row[j * col_stride]);
+      }
+      for (; j < nr; ++j) {
+        out[j] = T(0);
+      }
+      out += nr;
+    }
+  }
+}
+
+// Pack A[mc, kc] into MR-tall row panels, each laid out p-major and
+// zero-padded to a full MR
+template <typename T, typename scalar_t>
+void pack_a(int64_t mc, int64_t kc, int64_t mr, const scalar_t* a, int64_t row_stride,
+            int64_t col_stride, T* out) {
+  for (int64_t ip = 0; ip < mc; ip += mr) {
+    const int64_t rows = std::min(mr, mc - ip);
+    for (int64_t p = 0; p < kc; ++p) {
+      const scalar_t* col = a + ip * row_stride + p * col_stride;
+      int64_t i = 0;
+      for (; i < rows; ++i) {
+        out[i] = widen<T>(col[i * row_stride]);
+      }
+      for (; i < mr; ++i) {
+        out[i] = T(0);
+      }
+      out += mr;
+    }
+  }
+}
+
+template <typename T>
+inline T activate(T x, Activation activation) {
+  switch (activation) {
+    case Activation::ReLU:
+      return x > T(0) ? x : T(0);
+    case Activation::Sigmoid:
+      return T(1) / (T(1) + std::exp(-x));
+    case Activation::Tanh:
+      return std::tanh(x);
+    default:
+      return x;
+  }
+}
+
+// Running sums of a 16-bit C block, kept in the compute type while K spans
+// several k-blocks so C is rounded once, after the last one
+template <typename T>
+struct PartialSums {
+  T* data;         // [mc, nc], row-major
+  int64_t stride;  // Row stride of data
+  bool load;       // Add the sums of the previous k-blocks instead of reading C
+  bool store;      // Not the last k-block: update the sums and leave C alone
+};
+
+// C[mc, nc] = packed A[mc, kc] @ packed B[kc, nc], or C += when add_to_c is
+// set, one MR x NR register tile at a time. epilogue is only passed for the
+// last k-block; col0 is the column of C's first column within the full matrix
+template <typename scalar_t, typename T>
+void macro_kernel(const KernelInfo<T>& kernel, int64_t mc, int64_t nc, int64_t kc,
+                  const T* a_packed, const T* b_packed, scalar_t* c, int64_t c_row_stride,
+                  int64_t c_col_stride, bool add_to_c,
+                  const GemmEpilogue<scalar_t>* epilogue = nullptr, int64_t col0 = 0,
+                  const PartialSums<T>* partial = nullptr) {
+  const int64_t mr = kernel.mr;
+  const int64_t nr = kernel.nr;
+  T tile[32 * 32];  // Large enough for every MR x NR
+  T bias[32];
+
+  for (int64_t jr = 0; jr < nc; jr += nr) {
+    const int64_t cols = std::min(nr, nc - jr);
+    const T* b_panel = b_packed + jr * kc;
+    if (epilogue) {
+      for (int64_t j = 0; j < cols; ++j) {
+        bias[j] = epilogue->bias ? widen<T>(epilogue->bias[(col0 + jr + j) * epilogue->bias_stride])
+                                 : T(0);
+      }
+    }
+
+    for (int64_t ir = 0; ir < mc; ir += mr) {
+      const int64_t rows = std::min(mr, mc - ir);
+      kernel.fn(kc, a_packed + ir * kc, b_panel, tile);
+
+      // Write back the valid part of the tile through C's strides
+      scalar_t* c_tile = c + ir * c_row_stride + jr * c_col_stride;
+      for (int64_t i = 0; i < rows; ++i) {
+        for (int64_t j = 0; j < cols; ++j) {
+          scalar_t& dst = c_tile[i * c_row_stride + j * c_col_stride];
+          T value = tile[i * nr + j];
+          T* sum = partial ? partial->data + (ir + i) * partial->stride + jr + j : nullptr;
+          if (partial && partial->load) {
+            value += *sum;
+          } else if (add_to_c) {
+            value += widen<T>(dst);
+          }
+          if (partial && partial->store) {
+            *sum = value;
+            continue;
+          }
+          if (epilogue) {
+            value = activate(value + bias[j], epilogue->activation);
+          }
+          dst = static_cast<scalar_t>(value);
+        }
+      }
+    }
+  }
+}
+
+// C = 0, for products with an empty inner dimension
+template <typename scalar_t>
+void fill_zero(int64_t m, int64_t n, scalar_t* c, int64_t c_row_stride, int64_t c_col_stride) {
+  for (int64_t i = 0; i < m; ++i) {
+    for (int64_t j = 0; j < n; ++j) {
+      c[i * c_row_stride + j * c_col_stride] = static_cast<scalar_t>(0.0f);
+    }
+  }
+}
+
+}  // namespace
+
+const char* gemm_isa_name(GemmIsa isa) {
+  switch (isa) {
+    case GemmIsa::Scalar:
+      return "scalar";
+    case GemmIsa::AVX2:
+      return "avx2";
+    case GemmIsa::AVX512:
+      return "avx512";
+  }
+  return "unknown";
+}
+
+GemmIsa gemm_max_isa() {
+  static const GemmIsa isa = detect_isa();
+  return isa;
+}
+
+GemmIsa gemm_isa() { return active_isa().load(std::memory_order_relaxed); }
+
+void set_gemm_isa(GemmIsa isa) {
+  if (static_cast<int>(isa) > static_cast<int>(gemm_max_isa())) {
+    throw std::runtime_error(std::string("GEMM instruction set ") + gemm_isa_name(isa) +
+                             " is not supported on this CPU");
+  }
+  active_isa().store(isa, std::memory_order_relaxed);
+}
+
+template <typename scalar_t>
+void gemm(int64_t m, int64_t n, int64_t k, const scalar_t* a, int64_t a_row_stride,
+          int64_t a_col_stride, const scalar_t* b, int64_t b_row_stride, int64_t b_col_stride,
+          scalar_t* c, int64_t c_row_stride, int64_t c_col_stride, bool accumulate,
+          const GemmEpilogue<scalar_t>* epilogue) {
+  // Half and BFloat16 are computed in float, like every other kernel
+  using compute_t =
+      typename std::conditional<std::is_same<scalar_t, double>::value, double, float>::type;
+
+  if (m <= 0 || n <= 0) {
+    return;
+  }
+  if (k <= 0) {
+    if (!accumulate) {
+      fill_zero(m, n, c, c_row_stride, c_col_stride);
+    }
+    if (epilogue) {
+      for (int64_t i = 0; i < m; ++i) {
+        for (int64_t j = 0; j < n; ++j) {
+          scalar_t& dst = c[i * c_row_stride + j * c_col_stride];
+          const compute_t bias =
+              epilogue->bias ? widen<compute_t>(epilogue->bias[j * epilogue->bias_stride]) : 0;
+          const compute_t value = widen<compute_t>(dst) + bias;
+          dst = static_cast<scalar_t>(activate(value, epilogue->activation));
+        }
+      }
+    }
+    return;
+  }
+
+  const KernelInfo<compute_t> kernel = select_kernel<compute_t>();
+  const int64_t mr = kernel.mr;
+  const int64_t nr = kernel.nr;
+
+  // Small products finish before the pool would even wake up
+  const int64_t num_threads = get_num_threads();
+  const bool use_threads = num_threads > 1 && m * n * k >= kMinParallelWork;
+
+  const int64_t kc_max = std::min(k, kKC);
+  const int64_t nc_max = (std::min(n, kNC) + nr - 1) / nr * nr;
+  const int64_t mc_max = (std::min(m, kMC) + mr - 1) / mr * mr;
+  PackBuffer packed_b(static_cast<std::size_t>(kc_max * nc_max) * sizeof(compute_t));
+  const int64_t m_blocks = (m + kMC - 1) / kMC;
+
+  // 16-bit C would round the partial sums after every k-block, so they are
+  // kept in compute_t for one NC-wide column block of C at a time
+  const bool split_sums = sizeof(scalar_t) < sizeof(compute_t) && k > kKC;
+  std::unique_ptr<PackBuffer> sums;
+  if (split_sums) {
+    sums = std::make_unique<PackBuffer>(static_cast<std::size_t>(m * nc_max) * sizeof(compute_t));
+  }
+
+  for (int64_t jc = 0; jc < n; jc += kNC) {
+    const int64_t nc = std::min(kNC, n - jc);
+    const int64_t n_panels = (nc + nr - 1) / nr;
+
+    // C is split into m_blocks x n_splits independent blocks: MC rows by a
+    // group of NR-wide panels. Splitting N as well keeps every thread busy
+    // when M is a single block (small batches).
+    const int64_t n_splits =
+        use_threads ? std::max<int64_t>(1, std::min(n_panels, num_threads / m_blocks)) : 1;
+    const int64_t panels_per_split = (n_panels + n_splits - 1) / n_splits;
+
+    for (int64_t pc = 0; pc < k; pc += kKC) {
+      const int64_t kc = std::min(kKC, k - pc);
+      // Later k-blocks add onto the partial sums already written to C
+      const bool add_to_c = accumulate || pc > 0;
+      // The epilogue needs the final sums, so it rides on the last k-block
+      const bool last_k_block = pc + kc >= k;
+
+      // Every block reads all of packed B, so it is packed once and shared
+      const scalar_t* b_block = b + pc * b_row_stride + jc * b_col_stride;
+      compute_t* b_packed = packed_b.as<compute_t>();
+      auto pack_b_panels = [&](int64_t panel_begin, int64_t panel_end) {
+        const int64_t j0 = panel_begin * nr;
+        const int64_t j1 = std::min(nc, panel_end * nr);
+        pack_b(kc, j1 - j0, nr, b_block + j0 * b_col_stride, b_row_stride, b_col_stride,
+               b_packed + j0 * kc);
+      };
+
+      auto compute_blocks = [&](int64_t block_begin, int64_t block_end) {
+        // A is packed per thread; neighbouring blocks of a chunk share it
+        PackBuffer packed_a(static_cast<std::size_t>(kc_max * mc_max) * sizeof(compute_t));
+        int64_t packed_ic = -1;
+
+        for (int64_t block = block_begin; block < block_end; ++block) {
+          const int64_t ic = block / n_splits * kMC;
+          const int64_t mc = std::min(kMC, m - ic);
+          const int64_t j0 = block % n_splits * panels_per_split * nr;
+          const int64_t j1 = std::min(nc, j0 + panels_per_split * nr);
+          if (j0 >= j1) {
+            continue;
+          }
+          if (ic != packed_ic) {
+            pack_a(mc, kc, mr, a + ic * a_row_stride + pc * a_col_stride, a_row_stride,
+                   a_col_stride, packed_a.as<compute_t>());
+            packed_ic = ic;
+          }
+          PartialSums<compute_t> partial = {nullptr, nc_max, pc > 0, !last_k_block};
+          if (split_sums) {
+            partial.data = sums->as<compute_t>() + ic * nc_max + j0;
+          }
+          macro_kernel(kernel, mc, j1 - j0, kc, packed_a.as<compute_t>(), b_packed + j0 * kc,
+                       c + ic * c_row_stride + (jc + j0) * c_col_stride, c_row_stride,
+                       c_col_stride, add_to_c, last_k_block ? epilogue : nullptr, jc + j0,
+                       split_sums ? &partial : nullptr);
+        }
+      };
+
+      if (use_threads) {
+        parallel_for(0, n_panels, 1, pack_b_panels);
+        parallel_for(0, m_blocks * n_splits, 1, compute_blocks);
+      } else {
+        pack_b_panels(0, n_panels);
+        compute_blocks(0, m_blocks);
+      }
+    }
+  }
+}
+
+template <typename scalar_t>
+void gemm_batched(int64_t batch, int64_t m, int64_t n, int64_t k, const scalar_t* a,
+                  const int64_t* a_offsets, int64_t a_row_stride, int64_t a_col_stride,
+                  const scalar_t* b, const int64_t* b_offsets, int64_t b_row_stride,
+                  int64_t b_col_stride, scalar_t* c, const int64_t* c_offsets,
+                  int64_t c_row_stride, int64_t c_col_stride, bool accumulate) {
+  using compute_t =
+      typename std::conditional<std::is_same<scalar_t, double>::value, double, float>::type;
+
+  if (batch <= 0 || m <= 0 || n <= 0) {
+    return;
+  }
+  if (batch == 1 || k <= 0) {
+    // A single matrix is better served by sharing packed B between threads
+    for (int64_t bi = 0; bi < batch; ++bi) {
+      gemm(m, n, k, a + a_offsets[bi], a_row_stride, a_col_stride, b + b_offsets[bi],
+           b_row_stride, b_col_stride, c + c_offsets[bi], c_row_stride, c_col_stride,
+           accumulate);
+    }
+    return;
+  }
+
+  const KernelInfo<compute_t> kernel = select_kernel<compute_t>();
+  const int64_t mr = kernel.mr;
+  const int64_t nr = kernel.nr;
+
+  const int64_t num_threads = get_num_threads();
+  const bool use_threads = num_threads > 1 && batch * m * n * k >= kMinParallelWork;
+
+  // Work units are MC-row by panel-group blocks of every matrix, scheduled as
+  // one flat range so a few large matrices and many small ones both fill the
+  // pool. N is only split when there are fewer blocks than threads.
+  const int64_t m_blocks = (m + kMC - 1) / kMC;
+  const int64_t n_panels = (n + nr - 1) / nr;
+  const int64_t blocks = batch * m_blocks;
+  const int64_t n_splits =
+      use_threads ? std::max<int64_t>(1, std::min(n_panels, (num_threads + blocks - 1) / blocks))
+                  : 1;
+  const int64_t panels_per_split = (n_panels + n_splits - 1) / n_splits;
+
+  const int64_t kc_max = std::min(k, kKC);
+  const int64_t nc_max = std::min(panels_per_split * nr, kNC);
+  const int64_t mc_max = (std::min(m, kMC) + mr - 1) / mr * mr;
+
+  // 16-bit C keeps the partial sums of a unit in compute_t, as in gemm()
+  const bool split_sums = sizeof(scalar_t) < sizeof(compute_t) && k > kKC;
+  const int64_t sums_stride = panels_per_split * nr;
+
+  auto compute_units = [&](int64_t unit_begin, int64_t unit_end) {
+    // Each unit packs its own slices of A and B, so units never wait on each other
+    PackBuffer packed_a(static_cast<std::size_t>(kc_max * mc_max) * sizeof(compute_t));
+    PackBuffer packed_b(static_cast<std::size_t>(kc_max * nc_max) * sizeof(compute_t));
+    std::unique_ptr<PackBuffer> sums;
+    if (split_sums) {
+      sums = std::make_unique<PackBuffer>(static_cast<std::size_t>(mc_max * sums_stride) *
+                                          sizeof(compute_t));
+    }
+
+    for (int64_t unit = unit_begin; unit < unit_end; ++unit) {
+      const int64_t bi = unit / (m_blocks * n_splits);
+      const int64_t ic = unit / n_splits % m_blocks * kMC;
+      const int64_t mc = std::min(kMC, m - ic);
+      const int64_t j0 = unit % n_splits * panels_per_split * nr;
+      const int64_t j1 = std::min(n, j0 + panels_per_split * nr);
+      if (j0 >= j1) {
+        continue;
+      }
+      const scalar_t* a_matrix = a + a_offsets[bi];
+      const scalar_t* b_matrix = b + b_offsets[bi];
+      scalar_t* c_matrix = c + c_offsets[bi];
+
+      for (int64_t pc = 0; pc < k; pc += kKC) {
+        const int64_t kc = std::min(kKC, k - pc);
+        const bool add_to_c = accumulate || pc > 0;
+        pack_a(mc, kc, mr, a_matrix + ic * a_row_stride + pc * a_col_stride, a_row_stride,
+               a_col_stride, packed_a.as<compute_t>());
+
+        for (int64_t jc = j0; jc < j1; jc += kNC) {
+          const int64_t nc = std::min(kNC, j1 - jc);
+          pack_b(kc, nc, nr, b_matrix + pc * b_row_stride + jc * b_col_stride, b_row_stride,
+                 b_col_stride, packed_b.as<compute_t>());
+          PartialSums<compute_t> partial = {nullptr, sums_stride, pc > 0, pc + kc < k};
+          if (split_sums) {
+            partial.data = sums->as<compute_t>() + (jc - j0);
+          }
+          macro_kernel(kernel, mc, nc, kc, packed_a.as<compute_t>(), packed_b.as<compute_t>(),
+                       c_matrix + ic * c_row_stride + jc * c_col_stride, c_row_stride,
+                       c_col_stride, add_to_c, static_cast<const GemmEpilogue<scalar_t>*>(nullptr),
+                       jc, split_sums ? &partial : nullptr);
+        }
+      }
+    }
+  };
+
+  if (use_threads) {
+    parallel_for(0, blocks * n_splits, 1, compute_units);
+  } else {
+    compute_units(0, blocks);
+  }
+}
+
+template void gemm<float>(int64_t, int64_t, int64_t, const float*, int64_t, int64_t,
+                          const float*, int64_t, int64_t, float*, int64_t, int64_t, bool,
+                          const GemmEpilogue<float>*);
+template void gemm<double>(int64_t, int64_t, int64_t, const double*, int64_t, int64_t,
+                           const double*, int64_t, int64_t, double*, int64_t, int64_t, bool,
+                           const GemmEpilogue<double>*);
+template void gemm<Half>(int64_t, int64_t, int64_t, const Half*, int64_t, int64_t, const Half*,
+                         int64_t, int64_t, Half*, int64_t, int64_t, bool,
+                         const GemmEpilogue<Half>*);
+template void gemm<BFloat16>(int64_t, int64_t, int64_t, const BFloat16*, int64_t, int64_t,
+                             const BFloat16*, int64_t, int64_t, BFloat16*, int64_t, int64_t,
+                             bool, const GemmEpilogue<BFloat16>*);
+template void gemm_batched<float>(int64_t, int64_t, int64_t, int64_t, const float*,
+                                  const int64_t*, int64_t, int64_t, const float*, const int64_t*,
+                                  int64_t, int64_t, float*, const int64_t*, int64_t, int64_t,
+                                  bool);
+template void gemm_batched<double>(int64_t, int64_t, int64_t, int64_t, const double*,
+                                   const int64_t*, int64_t, int64_t, const double*,
+                                   const int64_t*, int64_t, int64_t, double*, const int64_t*,
+                                   int64_t, int64_t, bool);
+template void gemm_batched<Half>(int64_t, int64_t, int64_t, int64_t, const Half*, const int64_t*,
+                                 int64_t, int64_t, const Half*, const int64_t*, int64_t, int64_t,
+                                 Half*, const int64_t*, int64_t, int64_t, bool);
+template void gemm_batched<BFloat16>(int64_t, int64_t, int64_t, int64_t, const BFloat16*,
+                                     const int64_t*, int64_t, int64_t, const BFloat16*,
+                                     const int64_t*, int64_t, int64_t, BFloat16*, const int64_t*,
+                                     int64_t, int64_t, bool);
+
+}  // namespace tensor
+}  // namespace core
+}  // namespace torchscratch
@@ -0,0 +1,108 @@
+#include "core/tensor/iterator.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace torchscratch {
+namespace core {
+namespace tensor {
+
+namespace {
+
+std::string shape_to_string(const DimVector& shape) {
+  std::string result = "[";
+  for (std::size_t i = 0; i < shape.size(); ++i) {
+    result += std::to_string(shape[i]);
+    if (i + 1 < shape.size()) {
+      result += ", ";
+    }
+  }
+  return result + "]";
+}
+
+}  // namespace
+
+DimVector broadcast_shapes(const DimVector& a, const DimVector& b) {
+  const std::size_t ndim = std::max(a.size(), b.size());
+  DimVector result(ndim, 1);
+  for (std::size_t i = 0; i < ndim; ++i) {
+    // Align from the trailing dimension; missing leading dimensions count as 1
+    int64_t size_a = i < a.size() ? a[a.size() - 1 - i] : 1;
+    int64_t size_b = i < b.size() ? b[b.size() - 1 - i] : 1;
+    if (size_a != size_b && size_a != 1 && size_b != 1) {
+      throw std::runtime_error("Shapes " + shape_to_string(a) + " and " + shape_to_string(b) +
+                               " cannot be broadcast together");
+    }
+    result[ndim - 1 - i] = size_a == 1 ? size_b : size_a;
+  }
+  return result;
+}
+
+TensorIterator::TensorIterator(const DimVector& shape,
+                               std::initializer_list<const Tensor*> operands)
+    : shape_(shape), numel_(TensorImpl::compute_numel(shape)) {
+  if (operands.size() > static_cast<std::size_t>(kMaxOperands)) {
+    throw std::runtime_error("TensorIterator supports at most " +
+                             std::to_string(kMaxOperands) + " operands");
+  }
+
+  // Byte strides of every operand over the full shape, innermost dimension first
+  const std::size_t ndim = shape.size();
+  for (const Tensor* operand : operands) {
+    const DimVector& op_shape = operand->shape();
+    const DimVector& op_strides = operand->strides();
+    if (op_shape.size() > ndim) {
+      throw std::runtime_error("Cannot broadcast shape " + shape_to_string(op_shape) + " to " +
+                               shape_to_string(shape));
+    }
+
+    DimVector strides(ndim, 0);
+    for (std::size_t i = 0; i < op_shape.size(); ++i) {
+      int64_t size = op_shape[op_shape.size() - 1 - i];
+      if (size == shape[ndim - 1 - i]) {
+        strides[i] = op_strides[op_shape.size() - 1 - i] * operand->itemsize();
+      } else if (size != 1) {
+        throw std::runtime_error("Cannot broadcast shape " + shape_to_string(op_shape) + " to " +
+                                 shape_to_string(shape));
+      }
+    }
+
+    data_[num_operands_] = static_cast<char*>(operand->data_ptr());
+    strides_[num_operands_] = strides;
+    ++num_operands_;
+  }
+
+  // Drop size-1 dimensions and merge each dimension into the previous (inner)
+  // one when every operand steps through both as a single run
+  DimVector full_strides[kMaxOperands];
+  for (int op = 0; op < num_operands_; ++op) {
+    full_strides[op] = std::move(strides_[op]);
+    strides_[op].clear();
+  }
+  for (std::size_t i = 0; i < ndim; ++i) {
+    int64_t size = shape[ndim - 1 - i];
+    if (size == 1) {
+      continue;
+    }
+
+    bool can_merge = !sizes_.empty();
+    for (int op = 0; op < num_operands_ && can_merge; ++op) {
+      can_merge = full_strides[op][i] == strides_[op].back() * sizes_.back();
+    }
+
+    if (can_merge) {
+      sizes_.back() *= size;
+    } else {
+      sizes_.push_back(size);
+      for (int op = 0; op < num_operands_; ++op) {
+        strides_[op].push_back(full_strides[op][i]);
+      }
+    }
+  }
+}
+
+}  // namespace tensor
+}  // namespace core
+}  // namespace torchscratch
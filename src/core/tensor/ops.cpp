@@ -1,198 +1,595 @@
 #include "core/tensor/ops.h"
 
 #include <algorithm>
+#include <cmath>
+#include <functional>
 #include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "core/tensor/gemm.h"
+#include "core/tensor/iterator.h"
+#include "core/tensor/vectorized.h"
 
 namespace torchscratch::core::tensor {
 
-Tensor add(const Tensor& a, const Tensor& b) {
-  // Basic element-wise addition
-  if (!a.data_ptr() || !b.data_ptr()) {
-    throw std::runtime_error("Input tensors must have allocated data");
+namespace {
+
+void check_same_dtype(const Tensor& a, const Tensor& b, const char* op) {
+  if (a.dtype() != b.dtype()) {
+    throw std::runtime_error(std::string(op) + ": dtype mismatch (" + dtype_name(a.dtype()) +
+                             " vs " + dtype_name(b.dtype()) + ")");
   }
+}
 
-  // Handle broadcasting for scalar case
-  if (b.numel() == 1) {
-    Tensor result(a.shape());
-    result.allocate();
-    float scalar = *b.data_ptr<float>();
-    float* a_data = a.data_ptr<float>();
-    float* result_data = result.data_ptr<float>();
+// SIMD loop for a contiguous run, if the op has one for this dtype. b is read
+// as a single value when broadcast_b is set. Returns false to fall back.
+template <typename scalar_t, typename Op>
+bool vectorized_binary(Op, int64_t, const scalar_t*, const scalar_t*, bool, scalar_t*) {
+  return false;
+}
 
-    for (int i = 0; i < a.numel(); ++i) {
-      result_data[i] = a_data[i] + scalar;
-    }
-    return result;
-  }
+bool vectorized_binary(std::plus<>, int64_t n, const float* a, const float* b, bool broadcast_b,
+                       float* out) {
+  const ElementwiseKernels& k = elementwise_kernels();
+  broadcast_b ? k.add_scalar(n, a, *b, out) : k.add(n, a, b, out);
+  return true;
+}
 
-  // Handle broadcasting for bias addition (2D + 1D case)
-  // a: [batch_size, features], b: [features]
-  if (a.dim() == 2 && b.dim() == 1 && a.shape()[1] == b.shape()[0]) {
-    Tensor result(a.shape());
-    result.allocate();
+bool vectorized_binary(std::minus<>, int64_t n, const float* a, const float* b, bool broadcast_b,
+                       float* out) {
+  const ElementwiseKernels& k = elementwise_kernels();
+  broadcast_b ? k.add_scalar(n, a, -*b, out) : k.sub(n, a, b, out);
+  return true;
+}
 
-    float* a_data = a.data_ptr<float>();
-    float* b_data = b.data_ptr<float>();
-    float* result_data = result.data_ptr<float>();
+bool vectorized_binary(std::multiplies<>, int64_t n, const float* a, const float* b,
+                       bool broadcast_b, float* out) {
+  const ElementwiseKernels& k = elementwise_kernels();
+  broadcast_b ? k.mul_scalar(n, a, *b, out) : k.mul(n, a, b, out);
+  return true;
+}
 
-    int64_t batch_size = a.shape()[0];
-    int64_t features = a.shape()[1];
+// out = op(a, b) over the iterator's broadcast shape; operands are (out, a, b)
+template <typename scalar_t, typename Op>
+void binary_kernel(const TensorIterator& iter, Op op) {
+  using acc_t = typename acc_type<scalar_t>::type;
+  constexpr int64_t kItem = sizeof(scalar_t);
 
-    for (int64_t i = 0; i < batch_size; ++i) {
-      for (int64_t j = 0; j < features; ++j) {
-        result_data[i * features + j] = a_data[i * features + j] + b_data[j];
+  iter.for_each([&](char** data, const int64_t* strides, int64_t n) {
+    scalar_t* out = reinterpret_cast<scalar_t*>(data[0]);
+    const scalar_t* a = reinterpret_cast<const scalar_t*>(data[1]);
+    const scalar_t* b = reinterpret_cast<const scalar_t*>(data[2]);
+
+    if (strides[0] == kItem && strides[1] == kItem && strides[2] == kItem) {
+      if (vectorized_binary(op, n, a, b, false, out)) {
+        return;
+      }
+      for (int64_t i = 0; i < n; ++i) {
+        out[i] = static_cast<scalar_t>(op(static_cast<acc_t>(a[i]), static_cast<acc_t>(b[i])));
       }
+    } else if (strides[0] == kItem && strides[1] == kItem && strides[2] == 0) {
+      // Broadcast b (scalar, or a bias row seen from the inner loop)
+      if (vectorized_binary(op, n, a, b, true, out)) {
+        return;
+      }
+      const acc_t scalar = static_cast<acc_t>(*b);
+      for (int64_t i = 0; i < n; ++i) {
+        out[i] = static_cast<scalar_t>(op(static_cast<acc_t>(a[i]), scalar));
+      }
+    } else {
+      for (int64_t i = 0; i < n; ++i) {
+        const scalar_t& a_i = *reinterpret_cast<const scalar_t*>(data[1] + i * strides[1]);
+        const scalar_t& b_i = *reinterpret_cast<const scalar_t*>(data[2] + i * strides[2]);
+        *reinterpret_cast<scalar_t*>(data[0] + i * strides[0]) =
+            static_cast<scalar_t>(op(static_cast<acc_t>(a_i), static_cast<acc_t>(b_i)));
+      }
+    }
+  });
+}
+
+// Operands of a (possibly batched) matmul: matrix i of each operand starts at
+// its offsets[i], in elements. Row and column strides come from the last two
+// dimensions, swapped for an operand used transposed
+struct MatmulOperands {
+  int64_t batch = 1;
+  int64_t m = 0;
+  int64_t k = 0;
+  int64_t n = 0;
+  int64_t a_row_stride = 0;
+  int64_t a_col_stride = 0;
+  int64_t b_row_stride = 0;
+  int64_t b_col_stride = 0;
+  int64_t out_row_stride = 0;
+  int64_t out_col_stride = 0;
+  std::vector<int64_t> a_offsets;
+  std::vector<int64_t> b_offsets;
+  std::vector<int64_t> out_offsets;
+};
+
+// Offset of every matrix of t when its leading dimensions are broadcast to
+// batch_shape; broadcast dimensions advance by 0
+std::vector<int64_t> batch_offsets(const Tensor& t, const DimVector& batch_shape) {
+  const int64_t batch_dims = static_cast<int64_t>(batch_shape.size());
+  const int64_t skipped = batch_dims - (t.dim() - 2);  // Leading dims t does not have
+  DimVector strides(batch_dims, 0);
+  int64_t count = 1;
+  for (int64_t dim = 0; dim < batch_dims; ++dim) {
+    const int64_t t_dim = dim - skipped;
+    if (t_dim >= 0 && t.shape()[t_dim] != 1) {
+      strides[dim] = t.strides()[t_dim];
     }
-    return result;
+    count *= batch_shape[dim];
   }
 
-  // Regular element-wise addition
-  if (a.shape() != b.shape()) {
-    throw std::runtime_error("Tensor shapes must match for addition");
+  std::vector<int64_t> offsets(count);
+  DimVector index(batch_dims, 0);
+  int64_t offset = 0;
+  for (int64_t i = 0; i < count; ++i) {
+    offsets[i] = offset;
+    for (int64_t dim = batch_dims - 1; dim >= 0; --dim) {
+      if (++index[dim] < batch_shape[dim]) {
+        offset += strides[dim];
+        break;
+      }
+      offset -= strides[dim] * (batch_shape[dim] - 1);
+      index[dim] = 0;
+    }
   }
+  return offsets;
+}
 
-  Tensor result(a.shape());
-  result.allocate();
+// Integer matmul: a plain strided triple loop per matrix, accumulating in int64
+template <typename scalar_t>
+void matmul_kernel(const Tensor& a, const Tensor& b, Tensor& result, const MatmulOperands& ops,
+                   std::true_type /*is_integral*/) {
+  using acc_t = typename acc_type<scalar_t>::type;
+
+  // Any operand may be a strided view (e.g. a transpose)
+  const int64_t a_row = ops.a_row_stride;
+  const int64_t a_col = ops.a_col_stride;
+  const int64_t b_row = ops.b_row_stride;
+  const int64_t b_col = ops.b_col_stride;
+  const int64_t out_row = ops.out_row_stride;
+  const int64_t out_col = ops.out_col_stride;
+
+  for (int64_t batch = 0; batch < ops.batch; ++batch) {
+    const scalar_t* a_data = a.data_ptr<scalar_t>() + ops.a_offsets[batch];
+    const scalar_t* b_data = b.data_ptr<scalar_t>() + ops.b_offsets[batch];
+    scalar_t* result_data = result.data_ptr<scalar_t>() + ops.out_offsets[batch];
+    for (int64_t i = 0; i < ops.m; ++i) {
+      for (int64_t j = 0; j < ops.n; ++j) {
+        acc_t sum = 0;
+        for (int64_t p = 0; p < ops.k; ++p) {
+          sum += static_cast<acc_t>(a_data[i * a_row + p * a_col]) *
+                 static_cast<acc_t>(b_data[p * b_row + j * b_col]);
+        }
+        result_data[i * out_row + j * out_col] = static_cast<scalar_t>(sum);
+      }
+    }
+  }
+}
 
-  float* a_data = a.data_ptr<float>();
-  float* b_data = b.data_ptr<float>();
-  float* result_data = result.data_ptr<float>();
+// Floating-point matmul goes through the packed, register-tiled GEMM
+template <typename scalar_t>
+void matmul_kernel(const Tensor& a, const Tensor& b, Tensor& result, const MatmulOperands& ops,
+                   std::false_type /*is_integral*/) {
+  gemm_batched<scalar_t>(ops.batch, ops.m, ops.n, ops.k, a.data_ptr<scalar_t>(),
+                         ops.a_offsets.data(), ops.a_row_stride, ops.a_col_stride,
+                         b.data_ptr<scalar_t>(), ops.b_offsets.data(), ops.b_row_stride,
+                         ops.b_col_stride, result.data_ptr<scalar_t>(), ops.out_offsets.data(),
+                         ops.out_row_stride, ops.out_col_stride);
+}
 
-  for (int i = 0; i < a.numel(); ++i) {
-    result_data[i] = a_data[i] + b_data[i];
+// Make out ready to receive a result of the given shape and dtype
+// Writing to PROT_READ pages would fault, so refuse before touching them
+void check_writable(const Tensor& t, const char* op) {
+  if (t.storage() && t.storage()->read_only()) {
+    throw std::runtime_error(std::string(op) + ": tensor is backed by a read-only mapping");
   }
+}
 
-  return result;
+void prepare_out(Tensor& out, const DimVector& shape, DType dtype, const char* op) {
+  if (!out.data_ptr()) {
+    out = Tensor(shape, dtype);
+    out.allocate();
+    return;
+  }
+  if (out.shape() != shape) {
+    throw std::runtime_error(std::string(op) + ": output tensor has the wrong shape");
+  }
+  if (out.dtype() != dtype) {
+    throw std::runtime_error(std::string(op) + ": output tensor has the wrong dtype");
+  }
+  check_writable(out, op);
+  // Strided outputs are fine, but not ones where several elements share an address
+  for (int64_t dim = 0; dim < out.dim(); ++dim) {
+    if (out.strides()[dim] == 0 && out.shape()[dim] > 1) {
+      throw std::runtime_error(std::string(op) + ": output tensor must not be an expanded view");
+    }
+  }
 }
 
-Tensor mul(const Tensor& a, const Tensor& b) {
+// Element offsets [lo, hi] of the storage a non-empty tensor touches
+void storage_extent(const Tensor& t, int64_t& lo, int64_t& hi) {
+  lo = hi = t.storage_offset();
+  for (int64_t dim = 0; dim < t.dim(); ++dim) {
+    const int64_t span = (t.shape()[dim] - 1) * t.strides()[dim];
+    (span < 0 ? lo : hi) += span;
+  }
+}
+
+// Element-wise kernels write each output element right after reading the
+// inputs at the same index, so out may be the very same view as an input.
+// Any other overlap (a transpose or shifted view of out) would read elements
+// that were already overwritten, in an order that depends on the chunking
+void check_no_partial_overlap(const Tensor& out, const Tensor& input, const char* op) {
+  if (!out.storage() || out.storage() != input.storage() || out.numel() == 0 ||
+      input.numel() == 0) {
+    return;
+  }
+  if (out.storage_offset() == input.storage_offset() && out.shape() == input.shape() &&
+      out.strides() == input.strides()) {
+    return;
+  }
+  int64_t out_lo, out_hi, in_lo, in_hi;
+  storage_extent(out, out_lo, out_hi);
+  storage_extent(input, in_lo, in_hi);
+  if (out_hi < in_lo || in_hi < out_lo) {
+    return;  // Disjoint parts of one buffer
+  }
+  throw std::runtime_error(std::string(op) +
+                           ": output partially overlaps an input; use a copy of the input");
+}
+
+template <typename Op>
+Tensor& binary_out(Tensor& out, const Tensor& a, const Tensor& b, const char* name, Op op) {
   if (!a.data_ptr() || !b.data_ptr()) {
     throw std::runtime_error("Input tensors must have allocated data");
   }
+  check_same_dtype(a, b, name);
+
+  // NumPy-style broadcasting; expanded operands are walked with stride 0, never copied
+  DimVector shape = broadcast_shapes(a.shape(), b.shape());
+  prepare_out(out, shape, a.dtype(), name);
+  check_no_partial_overlap(out, a, name);
+  check_no_partial_overlap(out, b, name);
+  TensorIterator iter(shape, {&out, &a, &b});
+  TS_DISPATCH_ALL_TYPES(a.dtype(), name, [&] { binary_kernel<scalar_t>(iter, op); });
+
+  out.bump_version();
+  return out;
+}
 
-  if (a.shape() != b.shape()) {
-    throw std::runtime_error("Tensor shapes must match for element-wise multiplication");
+// Shared by matmul and bmm: out[..., m, n] = op(a)[..., m, k] @ op(b)[..., k, n],
+// where op transposes the last two dimensions when the operand's flag is set
+Tensor& batched_matmul_out(Tensor& out, const Tensor& a, const Tensor& b, bool trans_a,
+                           bool trans_b, const char* name) {
+  if (!a.data_ptr() || !b.data_ptr()) {
+    throw std::runtime_error("Input tensors must have allocated data");
   }
+  check_same_dtype(a, b, name);
 
-  Tensor result(a.shape());
-  result.allocate();
+  if (a.dim() < 2 || b.dim() < 2) {
+    throw std::runtime_error(std::string(name) + ": both tensors must have at least 2 dimensions");
+  }
 
-  float* a_data = a.data_ptr<float>();
-  float* b_data = b.data_ptr<float>();
-  float* result_data = result.data_ptr<float>();
+  // A transposed operand just swaps which of its last two dimensions is the
+  // row; packing reads it through the swapped strides, so nothing is copied
+  const int64_t a_rows = a.dim() - (trans_a ? 1 : 2);
+  const int64_t a_cols = a.dim() - (trans_a ? 2 : 1);
+  const int64_t b_rows = b.dim() - (trans_b ? 1 : 2);
+  const int64_t b_cols = b.dim() - (trans_b ? 2 : 1);
+  if (a.shape()[a_cols] != b.shape()[b_rows]) {
+    throw std::runtime_error("Inner dimensions must match for matrix multiplication");
+  }
 
-  for (int i = 0; i < a.numel(); ++i) {
-    result_data[i] = a_data[i] * b_data[i];
+  MatmulOperands ops;
+  ops.m = a.shape()[a_rows];
+  ops.k = a.shape()[a_cols];
+  ops.n = b.shape()[b_cols];
+  ops.a_row_stride = a.strides()[a_rows];
+  ops.a_col_stride = a.strides()[a_cols];
+  ops.b_row_stride = b.strides()[b_rows];
+  ops.b_col_stride = b.strides()[b_cols];
+
+  // Leading dimensions are batch dimensions and broadcast NumPy-style
+  const DimVector batch_shape = broadcast_shapes(DimVector(a.shape().begin(), a.shape().end() - 2),
+                                                 DimVector(b.shape().begin(), b.shape().end() - 2));
+  DimVector out_shape = batch_shape;
+  out_shape.push_back(ops.m);
+  out_shape.push_back(ops.n);
+
+  // Every output element reads a whole row and column, so writing in place would
+  // corrupt inputs that are still being read
+  if (out.storage() && (out.storage() == a.storage() || out.storage() == b.storage())) {
+    throw std::runtime_error(std::string(name) +
+                             "_out: output must not share storage with an input");
   }
+  prepare_out(out, out_shape, a.dtype(), name);
+  ops.out_row_stride = out.strides()[out.dim() - 2];
+  ops.out_col_stride = out.strides()[out.dim() - 1];
+
+  ops.a_offsets = batch_offsets(a, batch_shape);
+  ops.b_offsets = batch_offsets(b, batch_shape);
+  ops.out_offsets = batch_offsets(out, batch_shape);
+  ops.batch = static_cast<int64_t>(ops.out_offsets.size());
+  TS_DISPATCH_ALL_TYPES(a.dtype(), name, [&] {
+    matmul_kernel<scalar_t>(a, b, out, ops, std::is_integral<scalar_t>());
+  });
+
+  out.bump_version();
+  return out;
+}
+
+}  // namespace
 
+Tensor& add_out(Tensor& out, const Tensor& a, const Tensor& b) {
+  return binary_out(out, a, b, "add", std::plus<>());
+}
+
+Tensor& sub_out(Tensor& out, const Tensor& a, const Tensor& b) {
+  return binary_out(out, a, b, "sub", std::minus<>());
+}
+
+Tensor& mul_out(Tensor& out, const Tensor& a, const Tensor& b) {
+  return binary_out(out, a, b, "mul", std::multiplies<>());
+}
+
+Tensor add(const Tensor& a, const Tensor& b) {
+  Tensor result;
+  add_out(result, a, b);
   return result;
 }
 
-Tensor matmul(const Tensor& a, const Tensor& b) {
-  if (!a.data_ptr() || !b.data_ptr()) {
-    throw std::runtime_error("Input tensors must have allocated data");
-  }
+Tensor sub(const Tensor& a, const Tensor& b) {
+  Tensor result;
+  sub_out(result, a, b);
+  return result;
+}
 
-  if (a.dim() != 2 || b.dim() != 2) {
-    throw std::runtime_error("Both tensors must be 2D for matrix multiplication");
-  }
+Tensor mul(const Tensor& a, const Tensor& b) {
+  Tensor result;
+  mul_out(result, a, b);
+  return result;
+}
 
-  auto a_shape = a.shape();
-  auto b_shape = b.shape();
+Tensor& add_(Tensor& self, const Tensor& other) { return add_out(self, self, other); }
 
-  if (a_shape[1] != b_shape[0]) {
-    throw std::runtime_error("Inner dimensions must match for matrix multiplication");
-  }
+Tensor& sub_(Tensor& self, const Tensor& other) { return sub_out(self, self, other); }
 
-  int m = a_shape[0];
-  int k = a_shape[1];
-  int n = b_shape[1];
+Tensor& mul_(Tensor& self, const Tensor& other) { return mul_out(self, self, other); }
 
-  Tensor result({m, n});
-  result.allocate();
+namespace {
 
-  float* a_data = a.data_ptr<float>();
-  float* b_data = b.data_ptr<float>();
-  float* result_data = result.data_ptr<float>();
+// x *= alpha over a strided run. Integer tensors are scaled in double and
+// rounded to nearest, so a fractional alpha is not truncated first
+template <typename scalar_t>
+void scale_run(char* data, int64_t stride, int64_t n, double alpha,
+               std::true_type /*is_integral*/) {
+  for (int64_t i = 0; i < n; ++i) {
+    scalar_t* x = reinterpret_cast<scalar_t*>(data + i * stride);
+    *x = static_cast<scalar_t>(std::llround(static_cast<double>(*x) * alpha));
+  }
+}
 
-  // Simple matrix multiplication (this can be optimized)
-  for (int i = 0; i < m; ++i) {
-    for (int j = 0; j < n; ++j) {
-      float sum = 0.0f;
-      for (int p = 0; p < k; ++p) {
-        sum += a_data[i * k + p] * b_data[p * n + j];
-      }
-      result_data[i * n + j] = sum;
-    }
+template <typename scalar_t>
+void scale_run(char* data, int64_t stride, int64_t n, double alpha,
+               std::false_type /*is_integral*/) {
+  using acc_t = typename acc_type<scalar_t>::type;
+  const acc_t a = static_cast<acc_t>(alpha);
+  if (std::is_same<scalar_t, float>::value && stride == sizeof(float)) {
+    float* x = reinterpret_cast<float*>(data);
+    elementwise_kernels().mul_scalar(n, x, static_cast<float>(alpha), x);
+    return;
+  }
+  for (int64_t i = 0; i < n; ++i) {
+    scalar_t* x = reinterpret_cast<scalar_t*>(data + i * stride);
+    *x = static_cast<scalar_t>(static_cast<acc_t>(*x) * a);
   }
+}
 
-  return result;
+// y += alpha * x over strided runs, rounding like scale_run for integers
+template <typename scalar_t>
+void axpy_run(char** data, const int64_t* strides, int64_t n, double alpha,
+              std::true_type /*is_integral*/) {
+  for (int64_t i = 0; i < n; ++i) {
+    scalar_t* y = reinterpret_cast<scalar_t*>(data[0] + i * strides[0]);
+    const scalar_t* x = reinterpret_cast<const scalar_t*>(data[1] + i * strides[1]);
+    *y = static_cast<scalar_t>(
+        std::llround(static_cast<double>(*y) + alpha * static_cast<double>(*x)));
+  }
 }
 
-// Transpose implementation - creates a non-contiguous view
-Tensor transpose(const Tensor& a, int dim0, int dim1) {
-  if (a.dim() < 2) {
-    throw std::runtime_error("Cannot transpose tensor with less than 2 dimensions");
+template <typename scalar_t>
+void axpy_run(char** data, const int64_t* strides, int64_t n, double alpha,
+              std::false_type /*is_integral*/) {
+  using acc_t = typename acc_type<scalar_t>::type;
+  const acc_t a = static_cast<acc_t>(alpha);
+  if (std::is_same<scalar_t, float>::value && strides[0] == sizeof(float) &&
+      strides[1] == sizeof(float)) {
+    elementwise_kernels().axpy(n, static_cast<float>(alpha),
+                               reinterpret_cast<const float*>(data[1]),
+                               reinterpret_cast<float*>(data[0]));
+    return;
   }
+  for (int64_t i = 0; i < n; ++i) {
+    scalar_t* y = reinterpret_cast<scalar_t*>(data[0] + i * strides[0]);
+    const scalar_t* x_i = reinterpret_cast<const scalar_t*>(data[1] + i * strides[1]);
+    *y = static_cast<scalar_t>(static_cast<acc_t>(*y) + a * static_cast<acc_t>(*x_i));
+  }
+}
 
-  if (dim0 < 0 || dim0 >= a.dim() || dim1 < 0 || dim1 >= a.dim()) {
-    throw std::runtime_error("Transpose dimensions out of range");
+}  // namespace
+
+Tensor& scale_(Tensor& self, double alpha) {
+  if (!self.data_ptr()) {
+    throw std::runtime_error("Input tensors must have allocated data");
   }
 
-  // Create a view with swapped shape
-  std::vector<int64_t> out_shape = a.shape();
-  std::swap(out_shape[dim0], out_shape[dim1]);
+  check_writable(self, "scale_");
 
-  // Create a new tensor that shares the same data
-  Tensor result(a.data_ptr(), out_shape);
+  TensorIterator iter(self.shape(), {&self});
+  TS_DISPATCH_ALL_TYPES(self.dtype(), "scale_", [&] {
+    iter.for_each([&](char** data, const int64_t* strides, int64_t n) {
+      scale_run<scalar_t>(data[0], strides[0], n, alpha, std::is_integral<scalar_t>());
+    });
+  });
 
-  // Compute the transposed strides
-  std::vector<int64_t> transposed_strides = a.strides();
-  std::swap(transposed_strides[dim0], transposed_strides[dim1]);
+  self.bump_version();
+  return self;
+}
+
+Tensor& axpy_(Tensor& self, double alpha, const Tensor& x) {
+  if (!self.data_ptr() || !x.data_ptr()) {
+    throw std::runtime_error("Input tensors must have allocated data");
+  }
+  check_same_dtype(self, x, "axpy_");
+  if (self.shape() != x.shape()) {
+    throw std::runtime_error("Tensor shapes must match for axpy_");
+  }
+  check_no_partial_overlap(self, x, "axpy_");
+  check_writable(self, "axpy_");
+
+  TensorIterator iter(self.shape(), {&self, &x});
+  TS_DISPATCH_ALL_TYPES(self.dtype(), "axpy_", [&] {
+    iter.for_each([&](char** data, const int64_t* strides, int64_t n) {
+      axpy_run<scalar_t>(data, strides, n, alpha, std::is_integral<scalar_t>());
+    });
+  });
+
+  self.bump_version();
+  return self;
+}
 
-  // Set the custom strides and mark as non-contiguous
-  result.set_strides(transposed_strides);
-  result.set_contiguous(false);
+Tensor& matmul_out(Tensor& out, const Tensor& a, const Tensor& b, bool trans_a, bool trans_b) {
+  return batched_matmul_out(out, a, b, trans_a, trans_b, "matmul");
+}
 
+Tensor matmul(const Tensor& a, const Tensor& b, bool trans_a, bool trans_b) {
+  Tensor result;
+  matmul_out(result, a, b, trans_a, trans_b);
   return result;
 }
 
-Tensor sub(const Tensor& a, const Tensor& b) {
-  // Basic element-wise subtraction
-  if (!a.data_ptr() || !b.data_ptr()) {
-    throw std::runtime_error("Input tensors must have allocated data");
+Tensor& bmm_out(Tensor& out, const Tensor& a, const Tensor& b) {
+  if (a.dim() != 3 || b.dim() != 3) {
+    throw std::runtime_error("bmm: both tensors must be 3D");
   }
+  return batched_matmul_out(out, a, b, false, false, "bmm");
+}
 
-  // Handle broadcasting for scalar case
-  if (b.numel() == 1) {
-    Tensor result(a.shape());
-    result.allocate();
-    float scalar = *b.data_ptr<float>();
-    float* a_data = a.data_ptr<float>();
-    float* result_data = result.data_ptr<float>();
+Tensor bmm(const Tensor& a, const Tensor& b) {
+  Tensor result;
+  bmm_out(result, a, b);
+  return result;
+}
 
-    for (int i = 0; i < a.numel(); ++i) {
-      result_data[i] = a_data[i] - scalar;
+Tensor linear_act(const Tensor& input, const Tensor& weight, const Tensor& bias,
+                  Activation activation) {
+  if (!input.data_ptr() || !weight.data_ptr()) {
+    throw std::runtime_error("Input tensors must have allocated data");
+  }
+  check_same_dtype(input, weight, "linear_act");
+  if (input.dim() < 1 || weight.dim() != 2) {
+    throw std::runtime_error("linear_act: expected input [..., in] and weight [out, in]");
+  }
+  const int64_t in_features = weight.shape()[1];
+  const int64_t out_features = weight.shape()[0];
+  if (input.shape()[input.dim() - 1] != in_features) {
+    throw std::runtime_error("linear_act: input features do not match the weight");
+  }
+  const bool has_bias = bias.data_ptr() != nullptr;
+  if (has_bias) {
+    check_same_dtype(input, bias, "linear_act");
+    if (bias.dim() != 1 || bias.shape()[0] != out_features) {
+      throw std::runtime_error("linear_act: bias must have shape [out]");
     }
-    return result;
   }
 
-  // Regular element-wise subtraction
-  if (a.shape() != b.shape()) {
-    throw std::runtime_error("Tensor shapes must match for subtraction");
+  // Leading dimensions are flattened into rows; a view unless input is strided
+  const int64_t rows = in_features > 0 ? input.numel() / in_features : 0;
+  const Tensor x = input.dim() == 2 ? input : input.reshape({rows, in_features});
+  DimVector out_shape = input.shape();
+  out_shape[out_shape.size() - 1] = out_features;
+  Tensor result({rows, out_features}, input.dtype());
+  result.allocate();
+
+  TS_DISPATCH_FLOATING_TYPES(input.dtype(), "linear_act", [&] {
+    GemmEpilogue<scalar_t> epilogue;
+    epilogue.bias = has_bias ? bias.data_ptr<scalar_t>() : nullptr;
+    epilogue.bias_stride = has_bias ? bias.strides()[0] : 0;
+    epilogue.activation = activation;
+    // weight is read transposed through its strides
+    gemm<scalar_t>(rows, out_features, in_features, x.data_ptr<scalar_t>(), x.strides()[0],
+                   x.strides()[1], weight.data_ptr<scalar_t>(), weight.strides()[1],
+                   weight.strides()[0], result.data_ptr<scalar_t>(), out_features, 1,
+                   /*accumulate=*/false, &epilogue);
+  });
+
+  return input.dim() == 2 ? result : result.reshape(out_shape);
+}
+
+Tensor sum_to(const Tensor& a, const DimVector& shape) {
+  if (a.shape() == shape) {
+    return a;
+  }
+  if (!a.data_ptr()) {
+    throw std::runtime_error("Input tensors must have allocated data");
+  }
+  // Validates that shape broadcasts to a.shape()
+  if (broadcast_shapes(shape, a.shape()) != a.shape()) {
+    throw std::runtime_error("sum_to: shape does not broadcast to the input shape");
+  }
+
+  // Leading dimensions that shape lacks, and those it has as 1
+  const int64_t leading = a.dim() - static_cast<int64_t>(shape.size());
+  DimVector dims;
+  for (int64_t d = 0; d < a.dim(); ++d) {
+    if (d < leading || (shape[d - leading] == 1 && a.shape()[d] != 1)) {
+      dims.push_back(d);
+    }
+  }
+  if (dims.empty()) {
+    return a.reshape(shape);
   }
+  return sum(a, dims, /*keepdim=*/true).reshape(shape);
+}
 
-  Tensor result(a.shape());
-  result.allocate();
+Tensor expand(const Tensor& a, const DimVector& shape) {
+  if (broadcast_shapes(a.shape(), shape) != shape) {
+    throw std::runtime_error("expand: shape is not a broadcast of the input shape");
+  }
+  // Broadcast dimensions, leading ones included, get stride 0
+  const int64_t leading = static_cast<int64_t>(shape.size()) - a.dim();
+  DimVector strides(shape.size(), 0);
+  for (int64_t d = 0; d < a.dim(); ++d) {
+    strides[leading + d] = a.shape()[d] == shape[leading + d] ? a.strides()[d] : 0;
+  }
+  return a.as_strided(shape, strides, a.storage_offset());
+}
 
-  float* a_data = a.data_ptr<float>();
-  float* b_data = b.data_ptr<float>();
-  float* result_data = result.data_ptr<float>();
+// Transpose implementation - creates a non-contiguous view
+Tensor transpose(const Tensor& a, int dim0, int dim1) {
+  if (a.dim() < 2) {
+    throw std::runtime_error("Cannot transpose tensor with less than 2 dimensions");
+  }
 
-  for (int i = 0; i < a.numel(); ++i) {
-    result_data[i] = a_data[i] - b_data[i];
+  if (dim0 < 0 || dim0 >= a.dim() || dim1 < 0 || dim1 >= a.dim()) {
+    throw std::runtime_error("Transpose dimensions out of range");
   }
 
-  return result;
+  // Create a view with swapped shape
+  DimVector out_shape = a.shape();
+  std::swap(out_shape[dim0], out_shape[dim1]);
+
+  // Compute the transposed strides
+  DimVector transposed_strides = a.strides();
+  std::swap(transposed_strides[dim0], transposed_strides[dim1]);
+
+  // The view shares (and keeps alive) the storage of the input
+  return a.as_strided(out_shape, transposed_strides, a.storage_offset());
 }
-}  // namespace torchscratch::core::tensor
\ No newline at end of file
+
+}  // namespace torchscratch::core::tensor
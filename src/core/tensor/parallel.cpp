@@ -0,0 +1,93 @@
+#include "core/tensor/parallel.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include "core/tensor/thread_pool.h"
+
+namespace torchscratch {
+namespace core {
+namespace tensor {
+
+namespace {
+
+thread_local bool in_parallel = false;
+
+class ParallelRegionGuard {
+public:
+  ParallelRegionGuard() : previous_(in_parallel) { in_parallel = true; }
+  ~ParallelRegionGuard() { in_parallel = previous_; }
+
+private:
+  bool previous_;
+};
+
+std::mutex pool_mutex;
+int num_threads = std::max(1u, std::thread::hardware_concurrency());
+std::shared_ptr<ThreadPool> pool;  // Created on first use with num_threads - 1 workers
+
+std::shared_ptr<ThreadPool> get_pool() {
+  std::lock_guard<std::mutex> lock(pool_mutex);
+  if (!pool) {
+    pool = std::make_shared<ThreadPool>(num_threads - 1);
+  }
+  return pool;
+}
+
+}  // namespace
+
+int get_num_threads() {
+  std::lock_guard<std::mutex> lock(pool_mutex);
+  return num_threads;
+}
+
+void set_num_threads(int threads) {
+  if (threads < 1) {
+    throw std::runtime_error("Number of threads must be at least 1");
+  }
+  std::shared_ptr<ThreadPool> old_pool;
+  {
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    if (threads == num_threads) {
+      return;
+    }
+    num_threads = threads;
+    old_pool = std::move(pool);
+  }
+  // Joined outside the lock; a parallel_for still using it keeps it alive until done
+  old_pool.reset();
+}
+
+bool in_parallel_region() { return in_parallel; }
+
+void parallel_for(int64_t begin, int64_t end, int64_t grain_size,
+                  const std::function<void(int64_t, int64_t)>& fn) {
+  if (end <= begin) {
+    return;
+  }
+  const int64_t range = end - begin;
+  const int64_t grain = std::max<int64_t>(grain_size, 1);
+  const int64_t threads = get_num_threads();
+  if (threads <= 1 || range <= grain || in_parallel_region()) {
+    fn(begin, end);
+    return;
+  }
+
+  const int64_t num_tasks = std::min(threads, (range + grain - 1) / grain);
+  const int64_t chunk = (range + num_tasks - 1) / num_tasks;
+  get_pool()->run(num_tasks, [&](int64_t task) {
+    ParallelRegionGuard guard;
+    const int64_t chunk_begin = begin + task * chunk;
+    const int64_t chunk_end = std::min(end, chunk_begin + chunk);
+    if (chunk_begin < chunk_end) {
+      fn(chunk_begin, chunk_end);
+    }
+  });
+}
+
+}  // namespace tensor
+}  // namespace core
+}  // namespace torchscratch
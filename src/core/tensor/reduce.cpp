@@ -0,0 +1,500 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "core/tensor/ops.h"
+#include "core/tensor/parallel.h"
+
+namespace torchscratch {
+namespace core {
+namespace tensor {
+
+namespace {
+
+// Runs of at most this many elements are summed with kLanes independent
+// accumulators; longer runs are halved recursively (pairwise summation), so the
+// rounding error grows with log(n) rather than n
+constexpr int64_t kPairwiseBlock = 256;
+constexpr int kLanes = 8;
+
+// Rows accumulated one after another before the row range is halved, and the
+// width of the column tiles a row reduction works on
+constexpr int64_t kRowBlock = 16;
+constexpr int64_t kColTile = 256;
+
+// A reduced dimension is cut into chunks of about this many elements when there
+// are too few outputs to keep the pool busy. The chunking depends only on the
+// shape, never on the thread count, so results are reproducible
+constexpr int64_t kChunkElems = int64_t(1) << 15;
+constexpr int64_t kMinUnits = 64;
+
+// Reductions with less work than this stay on the calling thread
+constexpr int64_t kMinParallelElems = int64_t(1) << 15;
+
+// A reducer maps each input element to the accumulator type, combines two
+// accumulators, and turns the final accumulator over n elements into the result
+template <typename acc_t>
+struct SumReducer {
+  acc_t identity() const { return acc_t(0); }
+  template <typename T>
+  acc_t map(T x) const {
+    return static_cast<acc_t>(x);
+  }
+  acc_t combine(acc_t a, acc_t b) const { return a + b; }
+  acc_t finalize(acc_t acc, int64_t) const { return acc; }
+};
+
+template <typename acc_t>
+struct MeanReducer : SumReducer<acc_t> {
+  acc_t finalize(acc_t acc, int64_t n) const { return acc / static_cast<acc_t>(n); }
+};
+
+// NaN wins over any number, as in NumPy
+template <typename acc_t, bool kLargest>
+struct ExtremumReducer {
+  acc_t identity() const {
+    return kLargest ? (std::numeric_limits<acc_t>::has_infinity
+                           ? -std::numeric_limits<acc_t>::infinity()
+                           : std::numeric_limits<acc_t>::lowest())
+                    : (std::numeric_limits<acc_t>::has_infinity
+                           ? std::numeric_limits<acc_t>::infinity()
+                           : std::numeric_limits<acc_t>::max());
+  }
+  template <typename T>
+  acc_t map(T x) const {
+    return static_cast<acc_t>(x);
+  }
+  acc_t combine(acc_t a, acc_t b) const {
+    // a != a only holds for NaN
+    return (kLargest ? a > b : a < b) || a != a ? a : b;
+  }
+  acc_t finalize(acc_t acc, int64_t) const { return acc; }
+};
+
+// (sum |x|^p)^(1/p), with p = 1 and 2 spelled out
+template <typename acc_t>
+struct NormReducer {
+  acc_t p;
+
+  acc_t identity() const { return acc_t(0); }
+  template <typename T>
+  acc_t map(T x) const {
+    const acc_t v = std::abs(static_cast<acc_t>(x));
+    return p == 2 ? v * v : p == 1 ? v : std::pow(v, p);
+  }
+  acc_t combine(acc_t a, acc_t b) const { return a + b; }
+  acc_t finalize(acc_t acc, int64_t) const {
+    return p == 2 ? std::sqrt(acc) : p == 1 ? acc : std::pow(acc, 1 / p);
+  }
+};
+
+// max |x|, the p = infinity norm
+template <typename acc_t>
+struct MaxAbsReducer : ExtremumReducer<acc_t, true> {
+  acc_t identity() const { return acc_t(0); }
+  template <typename T>
+  acc_t map(T x) const {
+    return std::abs(static_cast<acc_t>(x));
+  }
+};
+
+// Combines partial accumulators of another reducer
+template <typename Reducer>
+struct PartialReducer {
+  const Reducer& inner;
+
+  template <typename acc_t>
+  acc_t map(acc_t x) const {
+    return x;
+  }
+  template <typename acc_t>
+  acc_t combine(acc_t a, acc_t b) const {
+    return inner.combine(a, b);
+  }
+  auto identity() const { return inner.identity(); }
+};
+
+// Partials of partials are combined the same way, which also bounds the
+// template recursion in reduce_kernel
+template <typename Reducer>
+PartialReducer<Reducer> partial_of(const Reducer& red) {
+  return {red};
+}
+template <typename Reducer>
+PartialReducer<Reducer> partial_of(const PartialReducer<Reducer>& red) {
+  return red;
+}
+
+// Reduction of the contiguous run x[0, n)
+template <typename acc_t, typename scalar_t, typename Reducer>
+acc_t reduce_run(const scalar_t* x, int64_t n, const Reducer& red) {
+  if (n > kPairwiseBlock) {
+    const int64_t half = (n / 2 + kLanes - 1) / kLanes * kLanes;
+    return red.combine(reduce_run<acc_t>(x, half, red), reduce_run<acc_t>(x + half, n - half, red));
+  }
+
+  // Independent lanes let the compiler keep the accumulators in one vector
+  acc_t lanes[kLanes];
+  std::fill(lanes, lanes + kLanes, red.identity());
+  int64_t i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    for (int j = 0; j < kLanes; ++j) {
+      lanes[j] = red.combine(lanes[j], red.map(x[i + j]));
+    }
+  }
+  for (int width = kLanes / 2; width > 0; width /= 2) {
+    for (int j = 0; j < width; ++j) {
+      lanes[j] = red.combine(lanes[j], lanes[j + width]);
+    }
+  }
+  acc_t acc = lanes[0];
+  for (; i < n; ++i) {
+    acc = red.combine(acc, red.map(x[i]));
+  }
+  return acc;
+}
+
+// out[c] = reduction over r of x[r * row_stride + c] for c in [0, width), width
+// at most kColTile. Rows are split pairwise like reduce_run; the column loops
+// are unit-stride and vectorize
+template <typename acc_t, typename scalar_t, typename Reducer>
+void reduce_rows(const scalar_t* x, int64_t rows, int64_t row_stride, int64_t width, acc_t* out,
+                 const Reducer& red) {
+  if (rows > kRowBlock) {
+    const int64_t half = rows / 2;
+    reduce_rows(x, half, row_stride, width, out, red);
+    acc_t rest[kColTile];
+    reduce_rows(x + half * row_stride, rows - half, row_stride, width, rest, red);
+    for (int64_t c = 0; c < width; ++c) {
+      out[c] = red.combine(out[c], rest[c]);
+    }
+    return;
+  }
+
+  for (int64_t c = 0; c < width; ++c) {
+    out[c] = red.map(x[c]);
+  }
+  for (int64_t r = 1; r < rows; ++r) {
+    const scalar_t* row = x + r * row_stride;
+    for (int64_t c = 0; c < width; ++c) {
+      out[c] = red.combine(out[c], red.map(row[c]));
+    }
+  }
+}
+
+// out[o, i] = reduction over r of x[o, r, i] for contiguous x of shape
+// [outer, reduced, inner], reduced >= 1. out holds accumulators
+template <typename acc_t, typename scalar_t, typename Reducer>
+void reduce_kernel(const scalar_t* x, int64_t outer, int64_t reduced, int64_t inner, acc_t* out,
+                   const Reducer& red) {
+  const int64_t width = std::min(inner, kColTile);
+  const int64_t tiles = (inner + kColTile - 1) / kColTile;
+  const int64_t units = outer * tiles;
+
+  // Too few outputs to share out: reduce fixed-size chunks of the reduced
+  // dimension in parallel, then combine the per-chunk partials
+  const int64_t chunk_rows = std::max<int64_t>(1, kChunkElems / width);
+  if (units < kMinUnits && reduced >= 2 * chunk_rows) {
+    const int64_t chunks = (reduced + chunk_rows - 1) / chunk_rows;
+    std::vector<acc_t> partial(static_cast<size_t>(outer * chunks * inner));
+    parallel_for(0, outer * chunks, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t unit = begin; unit < end; ++unit) {
+        const int64_t o = unit / chunks;
+        const int64_t chunk = unit % chunks;
+        const int64_t rows = std::min(chunk_rows, reduced - chunk * chunk_rows);
+        reduce_kernel(x + (o * reduced + chunk * chunk_rows) * inner, 1, rows, inner,
+                      partial.data() + unit * inner, red);
+      }
+    });
+    reduce_kernel(partial.data(), outer, chunks, inner, out, partial_of(red));
+    return;
+  }
+
+  const int64_t grain = std::max<int64_t>(1, kMinParallelElems / std::max<int64_t>(reduced * width, 1));
+  parallel_for(0, units, grain, [&](int64_t begin, int64_t end) {
+    for (int64_t unit = begin; unit < end; ++unit) {
+      const int64_t o = unit / tiles;
+      if (inner == 1) {
+        out[o] = reduce_run<acc_t>(x + o * reduced, reduced, red);
+        continue;
+      }
+      const int64_t c0 = (unit % tiles) * kColTile;
+      reduce_rows(x + o * reduced * inner + c0, reduced, inner, std::min(kColTile, inner - c0),
+                  out + o * inner + c0, red);
+    }
+  });
+}
+
+// Which dimensions of a tensor with `ndim` dimensions are reduced; empty dims
+// means all of them
+std::vector<bool> reduced_dims(int64_t ndim, const DimVector& dims, const char* name) {
+  std::vector<bool> reduced(static_cast<size_t>(ndim), dims.empty());
+  for (int64_t dim : dims) {
+    const int64_t d = dim < 0 ? dim + ndim : dim;
+    if (d < 0 || d >= ndim) {
+      throw std::runtime_error(std::string(name) + ": dimension " + std::to_string(dim) +
+                               " out of range for a " + std::to_string(ndim) + "-D tensor");
+    }
+    if (reduced[d]) {
+      throw std::runtime_error(std::string(name) + ": dimension " + std::to_string(dim) +
+                               " repeated");
+    }
+    reduced[d] = true;
+  }
+  return reduced;
+}
+
+// A contiguous tensor with the reduced elements of each output laid out as
+// [outer, reduced, inner]. That is the input itself when the reduced dimensions
+// are adjacent; otherwise they are permuted to the back and copied
+struct ReduceLayout {
+  Tensor input;
+  int64_t outer = 1;
+  int64_t reduced = 1;
+  int64_t inner = 1;
+};
+
+ReduceLayout reduce_layout(const Tensor& a, const std::vector<bool>& reduced) {
+  const int64_t ndim = a.dim();
+  const DimVector& shape = a.shape();
+  ReduceLayout layout;
+
+  // Size-1 dimensions do not affect the memory order, so skip them
+  int64_t first = -1;
+  int64_t last = -1;
+  bool adjacent = true;
+  for (int64_t d = 0; d < ndim; ++d) {
+    if (!reduced[d] || shape[d] == 1) {
+      continue;
+    }
+    if (last >= 0) {
+      for (int64_t k = last + 1; k < d; ++k) {
+        adjacent = adjacent && (shape[k] == 1 || reduced[k]);
+      }
+    }
+    first = first < 0 ? d : first;
+    last = d;
+  }
+
+  if (adjacent) {
+    layout.input = a.contiguous();
+    for (int64_t d = 0; d < ndim; ++d) {
+      if (first >= 0 && d >= first && d <= last) {
+        layout.reduced *= shape[d];
+      } else if (first >= 0 && d > last) {
+        layout.inner *= shape[d];
+      } else {
+        layout.outer *= shape[d];
+      }
+    }
+    return layout;
+  }
+
+  DimVector perm_shape;
+  DimVector perm_strides;
+  for (int pass = 0; pass < 2; ++pass) {
+    for (int64_t d = 0; d < ndim; ++d) {
+      if (reduced[d] == (pass == 1)) {
+        perm_shape.push_back(shape[d]);
+        perm_strides.push_back(a.strides()[d]);
+        (pass == 1 ? layout.reduced : layout.outer) *= shape[d];
+      }
+    }
+  }
+  layout.input = a.as_strided(perm_shape, perm_strides, a.storage_offset()).contiguous();
+  return layout;
+}
+
+DimVector reduced_shape(const DimVector& shape, const std::vector<bool>& reduced, bool keepdim) {
+  DimVector out;
+  for (size_t d = 0; d < shape.size(); ++d) {
+    if (!reduced[d]) {
+      out.push_back(shape[d]);
+    } else if (keepdim) {
+      out.push_back(1);
+    }
+  }
+  return out;
+}
+
+// Integer results are accumulated in int64_t; one that does not fit the output
+// dtype throws rather than wrapping around
+template <typename scalar_t, typename acc_t>
+scalar_t narrow_result(acc_t value, const char*, std::false_type) {
+  return static_cast<scalar_t>(value);
+}
+
+template <typename scalar_t, typename acc_t>
+scalar_t narrow_result(acc_t value, const char* name, std::true_type) {
+  if (value < static_cast<acc_t>(std::numeric_limits<scalar_t>::lowest()) ||
+      value > static_cast<acc_t>(std::numeric_limits<scalar_t>::max())) {
+    throw std::runtime_error(std::string(name) + ": result " + std::to_string(value) +
+                             " overflows the input dtype");
+  }
+  return static_cast<scalar_t>(value);
+}
+
+template <typename scalar_t, typename Reducer>
+void run_reduction(const ReduceLayout& layout, const Reducer& red, Tensor& result,
+                   const char* name) {
+  using acc_t = decltype(red.identity());
+  const int64_t outputs = layout.outer * layout.inner;
+  scalar_t* out = result.data_ptr<scalar_t>();
+  if (layout.reduced == 0) {
+    for (int64_t i = 0; i < outputs; ++i) {
+      out[i] = static_cast<scalar_t>(red.finalize(red.identity(), 0));
+    }
+    return;
+  }
+
+  std::vector<acc_t> acc(static_cast<size_t>(outputs));
+  reduce_kernel(layout.input.template data_ptr<scalar_t>(), layout.outer, layout.reduced,
+                layout.inner, acc.data(), red);
+  for (int64_t i = 0; i < outputs; ++i) {
+    out[i] = narrow_result<scalar_t>(red.finalize(acc[i], layout.reduced), name,
+                                     std::is_integral<scalar_t>());
+  }
+}
+
+void check_input(const Tensor& a, const char* name) {
+  if (!a.data_ptr() && a.numel() > 0) {
+    throw std::runtime_error(std::string(name) + ": input tensor must have allocated data");
+  }
+}
+
+// Shared driver: validates dims, lays the input out and dispatches on dtype
+template <typename MakeReducer>
+Tensor reduce(const Tensor& a, const DimVector& dims, bool keepdim, const char* name,
+              bool floating_only, bool needs_elements, MakeReducer make_reducer) {
+  check_input(a, name);
+  const std::vector<bool> reduced = reduced_dims(a.dim(), dims, name);
+  Tensor result(reduced_shape(a.shape(), reduced, keepdim), a.dtype());
+  result.allocate();
+  if (result.numel() == 0) {
+    return result;
+  }
+  const ReduceLayout layout = reduce_layout(a, reduced);
+  if (needs_elements && layout.reduced == 0) {
+    throw std::runtime_error(std::string(name) + ": cannot reduce over a zero-size dimension");
+  }
+
+  auto run = [&](auto tag) {
+    using scalar_t = decltype(tag);
+    run_reduction<scalar_t>(layout, make_reducer(tag), result, name);
+  };
+  if (floating_only) {
+    TS_DISPATCH_FLOATING_TYPES(a.dtype(), name, [&] { run(scalar_t()); });
+  } else {
+    TS_DISPATCH_ALL_TYPES(a.dtype(), name, [&] { run(scalar_t()); });
+  }
+  return result;
+}
+
+template <typename scalar_t>
+using acc_of = typename acc_type<scalar_t>::type;
+
+// Index of the first maximum of each [outer, reduced, inner] slice; NaN counts
+// as the maximum
+template <typename scalar_t>
+void argmax_kernel(const scalar_t* x, int64_t outer, int64_t reduced, int64_t inner,
+                   int32_t* out) {
+  using acc_t = acc_of<scalar_t>;
+  auto better = [](acc_t v, acc_t best) { return v > best || (v != v && best == best); };
+  const int64_t grain = std::max<int64_t>(1, kMinParallelElems / (reduced * inner));
+  parallel_for(0, outer, grain, [&](int64_t begin, int64_t end) {
+    std::vector<acc_t> best(static_cast<size_t>(inner));
+    for (int64_t o = begin; o < end; ++o) {
+      const scalar_t* slice = x + o * reduced * inner;
+      int32_t* index = out + o * inner;
+      for (int64_t c = 0; c < inner; ++c) {
+        best[c] = static_cast<acc_t>(slice[c]);
+        index[c] = 0;
+      }
+      for (int64_t r = 1; r < reduced; ++r) {
+        const scalar_t* row = slice + r * inner;
+        for (int64_t c = 0; c < inner; ++c) {
+          const acc_t v = static_cast<acc_t>(row[c]);
+          if (better(v, best[c])) {
+            best[c] = v;
+            index[c] = static_cast<int32_t>(r);
+          }
+        }
+      }
+    }
+  });
+}
+
+}  // namespace
+
+Tensor sum(const Tensor& a, const DimVector& dims, bool keepdim) {
+  return reduce(a, dims, keepdim, "sum", false, false, [](auto tag) {
+    return SumReducer<acc_of<decltype(tag)>>();
+  });
+}
+
+Tensor mean(const Tensor& a, const DimVector& dims, bool keepdim) {
+  return reduce(a, dims, keepdim, "mean", true, false, [](auto tag) {
+    return MeanReducer<acc_of<decltype(tag)>>();
+  });
+}
+
+Tensor max(const Tensor& a, const DimVector& dims, bool keepdim) {
+  return reduce(a, dims, keepdim, "max", false, true, [](auto tag) {
+    return ExtremumReducer<acc_of<decltype(tag)>, true>();
+  });
+}
+
+Tensor min(const Tensor& a, const DimVector& dims, bool keepdim) {
+  return reduce(a, dims, keepdim, "min", false, true, [](auto tag) {
+    return ExtremumReducer<acc_of<decltype(tag)>, false>();
+  });
+}
+
+Tensor norm(const Tensor& a, double p, const DimVector& dims, bool keepdim) {
+  if (!(p > 0)) {
+    throw std::runtime_error("norm: p must be positive");
+  }
+  if (std::isinf(p)) {
+    return reduce(a, dims, keepdim, "norm", true, false, [](auto tag) {
+      return MaxAbsReducer<acc_of<decltype(tag)>>();
+    });
+  }
+  return reduce(a, dims, keepdim, "norm", true, false, [p](auto tag) {
+    using acc_t = acc_of<decltype(tag)>;
+    return NormReducer<acc_t>{static_cast<acc_t>(p)};
+  });
+}
+
+Tensor argmax(const Tensor& a, int64_t dim, bool keepdim) {
+  check_input(a, "argmax");
+  const std::vector<bool> reduced = reduced_dims(a.dim(), {dim}, "argmax");
+  const int64_t d = dim < 0 ? dim + a.dim() : dim;
+  if (a.shape()[d] == 0) {
+    throw std::runtime_error("argmax: cannot reduce over a zero-size dimension");
+  }
+  if (a.shape()[d] > std::numeric_limits<int32_t>::max()) {
+    throw std::runtime_error("argmax: dimension too large for Int32 indices");
+  }
+  Tensor result(reduced_shape(a.shape(), reduced, keepdim), DType::Int32);
+  result.allocate();
+  if (result.numel() == 0) {
+    return result;
+  }
+  const ReduceLayout layout = reduce_layout(a, reduced);
+  TS_DISPATCH_ALL_TYPES(a.dtype(), "argmax", [&] {
+    argmax_kernel(layout.input.data_ptr<scalar_t>(), layout.outer, layout.reduced, layout.inner,
+                  result.data_ptr<int32_t>());
+  });
+  return result;
+}
+
+Tensor argmax(const Tensor& a) { return argmax(a.contiguous().reshape({a.numel()}), 0, false); }
+
+}  // namespace tensor
+}  // namespace core
+}  // namespace torchscratch
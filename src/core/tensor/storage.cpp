@@ -0,0 +1,87 @@
+#include "core/tensor/storage.h"
+
+#include <stdexcept>
+#include <utility>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "core/tensor/allocator.h"
+#include "core/tensor/arena.h"
+
+namespace torchscratch {
+namespace core {
+namespace tensor {
+
+Storage::Storage(void* data, std::size_t nbytes, Deleter deleter)
+    : data_(data), nbytes_(nbytes), deleter_(std::move(deleter)) {}
+
+Storage::~Storage() {
+  if (deleter_ && data_) {
+    deleter_(data_);
+  }
+}
+
+std::shared_ptr<Storage> Storage::allocate(std::size_t nbytes) {
+  // Inside a StepArenaGuard, per-step tensors come from the bump allocator
+  if (StepArena* arena = StepArena::current()) {
+    return arena->allocate(nbytes);
+  }
+
+  // Blocks go back to the caching allocator's free lists, not to the system
+  void* data = CachingAllocator::instance().allocate(nbytes);
+  return std::make_shared<Storage>(
+      data, nbytes, [nbytes](void* ptr) { CachingAllocator::instance().deallocate(ptr, nbytes); });
+}
+
+std::shared_ptr<Storage> Storage::borrow(void* data, std::size_t nbytes) {
+  return std::make_shared<Storage>(data, nbytes);
+}
+
+std::shared_ptr<Storage> Storage::map_file(const std::string& path, std::size_t offset,
+                                           std::size_t nbytes, MmapMode mode) {
+#ifdef _WIN32
+  throw std::runtime_error("Memory-mapped tensors are not supported on this platform");
+#else
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("Cannot open " + path + " for mapping");
+  }
+
+  struct stat st;
+  if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < offset + nbytes) {
+    ::close(fd);
+    throw std::runtime_error("File " + path + " is too small for the requested tensor");
+  }
+
+  // mmap offsets must be page aligned; map from the enclosing page and skip ahead
+  std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+  std::size_t aligned_offset = offset / page * page;
+  std::size_t delta = offset - aligned_offset;
+  std::size_t length = nbytes + delta;
+
+  int prot = mode == MmapMode::ReadOnly ? PROT_READ : PROT_READ | PROT_WRITE;
+  int flags = mode == MmapMode::ReadOnly ? MAP_SHARED : MAP_PRIVATE;
+  void* base = length > 0 ? ::mmap(nullptr, length, prot, flags, fd, aligned_offset) : nullptr;
+  ::close(fd);  // The mapping holds its own reference to the file
+  if (base == MAP_FAILED) {
+    throw std::runtime_error("Failed to map " + path);
+  }
+  if (!base) {
+    return std::make_shared<Storage>(nullptr, 0);
+  }
+
+  auto storage = std::make_shared<Storage>(static_cast<char*>(base) + delta, nbytes,
+                                           [base, length](void*) { ::munmap(base, length); });
+  storage->read_only_ = mode == MmapMode::ReadOnly;
+  return storage;
+#endif
+}
+
+}  // namespace tensor
+}  // namespace core
+}  // namespace torchscratch
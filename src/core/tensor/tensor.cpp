@@ -4,20 +4,115 @@
 #include <cstring>
 #include <numeric>
 #include <stdexcept>
+#include <string>
 
+#include "core/tensor/allocator.h"
 #include "core/tensor/tensor_impl.h"
 
 namespace torchscratch::core::tensor {
 
+constexpr std::size_t Tensor::kAlignment;
+static_assert(Tensor::kAlignment == CachingAllocator::kAlignment,
+              "Tensor alignment must match the allocator's");
+
+namespace {
+
+// Copy a strided [rows, cols] plane into a dense one. Transposed sources are
+// copied in square tiles so that both the rows being read and the rows being
+// written stay in L1 while a tile is processed.
+template <typename T>
+void copy_plane(const T* src, int64_t row_stride, int64_t col_stride, T* dst, int64_t rows,
+                int64_t cols) {
+  if (col_stride == 1) {
+    for (int64_t r = 0; r < rows; ++r) {
+      std::copy(src + r * row_stride, src + r * row_stride + cols, dst + r * cols);
+    }
+    return;
+  }
+
+  constexpr int64_t kBlock = 32;  // 32x32 tile of 8-byte elements is 8 KiB
+  for (int64_t rb = 0; rb < rows; rb += kBlock) {
+    const int64_t r_end = std::min(rb + kBlock, rows);
+    for (int64_t cb = 0; cb < cols; cb += kBlock) {
+      const int64_t c_end = std::min(cb + kBlock, cols);
+      for (int64_t r = rb; r < r_end; ++r) {
+        for (int64_t c = cb; c < c_end; ++c) {
+          dst[r * cols + c] = src[r * row_stride + c * col_stride];
+        }
+      }
+    }
+  }
+}
+
+// Copy a strided view into a dense row-major buffer. T is an unsigned integer of
+// the element's width: copying bits needs no dtype dispatch.
+template <typename T>
+void copy_to_contiguous(const T* src, T* dst, const DimVector& shape, const DimVector& strides) {
+  const std::size_t ndim = shape.size();
+  if (ndim == 0) {
+    *dst = *src;
+    return;
+  }
+
+  const int64_t cols = shape[ndim - 1];
+  const int64_t rows = ndim >= 2 ? shape[ndim - 2] : 1;
+  const int64_t row_stride = ndim >= 2 ? strides[ndim - 2] : 0;
+  const int64_t plane = rows * cols;
+  const int64_t numel = TensorImpl::compute_numel(shape);
+  if (plane == 0 || numel == 0) {
+    return;
+  }
+
+  // Odometer over the leading dimensions, one plane at a time
+  DimVector counter(ndim, 0);
+  int64_t offset = 0;
+  for (int64_t done = 0; done < numel; done += plane) {
+    copy_plane(src + offset, row_stride, strides[ndim - 1], dst + done, rows, cols);
+    for (int64_t dim = static_cast<int64_t>(ndim) - 3; dim >= 0; --dim) {
+      offset += strides[dim];
+      if (++counter[dim] < shape[dim]) {
+        break;
+      }
+      offset -= strides[dim] * shape[dim];
+      counter[dim] = 0;
+    }
+  }
+}
+
+void copy_to_contiguous(const Tensor& src, void* dst) {
+  switch (src.itemsize()) {
+    case 1:
+      copy_to_contiguous(static_cast<const uint8_t*>(src.data_ptr()), static_cast<uint8_t*>(dst),
+                         src.shape(), src.strides());
+      break;
+    case 2:
+      copy_to_contiguous(static_cast<const uint16_t*>(src.data_ptr()),
+                         static_cast<uint16_t*>(dst), src.shape(), src.strides());
+      break;
+    case 4:
+      copy_to_contiguous(static_cast<const uint32_t*>(src.data_ptr()),
+                         static_cast<uint32_t*>(dst), src.shape(), src.strides());
+      break;
+    case 8:
+      copy_to_contiguous(static_cast<const uint64_t*>(src.data_ptr()),
+                         static_cast<uint64_t*>(dst), src.shape(), src.strides());
+      break;
+    default:
+      throw std::runtime_error("Unsupported element size for copy");
+  }
+}
+
+}  // namespace
+
 // Tensor methods
 void Tensor::set_data_ptr(void* data) {
   if (impl_) {
-    impl_->data_ = data;
-    impl_->owns_data_ = false;  // When setting data externally, mark as non-owning
+    impl_->storage_ = Storage::borrow(data);  // When setting data externally, borrow it
+    impl_->storage_offset_ = 0;
   }
 }
 
-void Tensor::set_strides(const std::vector<int64_t>& strides) {
+void Tensor::set_strides(const DimVector& strides) {
   if (impl_) {
     impl_->strides_ = strides;
   }
@@ -29,17 +124,27 @@ void Tensor::set_contiguous(bool is_contiguous) {
   }
 }
 // Tensor constructors
-Tensor::Tensor(const std::vector<int64_t>& shape, DType* dtype) {
+Tensor::Tensor(const DimVector& shape, DType dtype) {
   impl_ = std::make_unique<TensorImpl>(shape, dtype);
 }
 
-Tensor::Tensor(void* data, const std::vector<int64_t>& shape, DType* dtype) {
+Tensor::Tensor(void* data, const DimVector& shape, DType dtype) {
   impl_ = std::make_unique<TensorImpl>(shape, dtype);
-  impl_->data_ = data;
-  impl_->owns_data_ = false;     // External data ownership
+  impl_->storage_ = Storage::borrow(data, impl_->nbytes());  // External data
   impl_->is_contiguous_ = true;  // Assume contiguous for externally provided data
 }
 
+Tensor Tensor::from_mmap(const std::string& path, int64_t offset,
+                         const DimVector& shape, DType dtype, MmapMode mode) {
+  if (offset < 0) {
+    throw std::runtime_error("Mapping offset must be non-negative");
+  }
+  Tensor result(shape, dtype);
+  result.impl_->storage_ = Storage::map_file(path, static_cast<std::size_t>(offset),
+                                             result.impl_->nbytes(), mode);
+  return result;
+}
+
 // Copy constructor
 Tensor::Tensor(const Tensor& other) {
   if (other.impl_) {
@@ -75,67 +180,90 @@ Tensor& Tensor::operator=(Tensor&& other) noexcept {
 Tensor::~Tensor() = default;
 
 // Shape and stride accessors
-const std::vector<int64_t>& Tensor::shape() const {
-  static const std::vector<int64_t> empty;
+const DimVector& Tensor::shape() const {
+  static const DimVector empty;
   return impl_ ? impl_->shape_ : empty;
 }
 
-const std::vector<int64_t>& Tensor::strides() const {
-  static const std::vector<int64_t> empty;
+const DimVector& Tensor::strides() const {
+  static const DimVector empty;
   return impl_ ? impl_->strides_ : empty;
 }
 
 int64_t Tensor::dim() const { return impl_ ? static_cast<int64_t>(impl_->shape_.size()) : 0; }
 
-int64_t Tensor::numel() const {
-  if (!impl_)
-    return 0;
-  return std::accumulate(impl_->shape_.begin(), impl_->shape_.end(), int64_t(1),
-                         std::multiplies<int64_t>());
-}
+int64_t Tensor::numel() const { return impl_ ? impl_->numel_ : 0; }
+
+DType Tensor::dtype() const { return impl_ ? impl_->dtype_ : DType::Float32; }
+
+int64_t Tensor::itemsize() const { return impl_ ? static_cast<int64_t>(impl_->itemsize_) : 0; }
+
+int64_t Tensor::nbytes() const { return impl_ ? static_cast<int64_t>(impl_->nbytes()) : 0; }
 
 // Data access
-void* Tensor::data_ptr() const { return impl_ ? impl_->data_ : nullptr; }
+void* Tensor::data_ptr() const { return impl_ ? impl_->data() : nullptr; }
 
 template <typename T>
 T* Tensor::data_ptr() const {
-  return impl_ ? static_cast<T*>(impl_->data_) : nullptr;
+  if (!impl_) {
+    return nullptr;
+  }
+  if (impl_->dtype_ != dtype_of<T>::value) {
+    throw std::runtime_error(std::string("Expected tensor of dtype ") + dtype_name(dtype_of<T>::value) +
+                             " but got " + dtype_name(impl_->dtype_));
+  }
+  return static_cast<T*>(impl_->data());
 }
 
 // Memory management
 void Tensor::allocate() {
-  if (!impl_ || impl_->data_) {
+  if (!impl_ || impl_->storage_) {
     return;  // Already allocated or invalid
   }
-  size_t size = numel() * 1;            // Placeholder: 1 byte per element (dtype TBD)
-  impl_->data_ = ::operator new(size);  // Raw allocation (replace with allocator in future)
+  // Sized from the element type; aligned to kAlignment by the caching allocator
+  impl_->storage_ = Storage::allocate(impl_->nbytes());
+  impl_->storage_offset_ = 0;
+  impl_->strides_ = TensorImpl::compute_strides(impl_->shape_);
   impl_->is_contiguous_ = true;
 }
 
 void Tensor::deallocate() {
-  if (impl_ && impl_->data_) {
-    ::operator delete(impl_->data_);
-    impl_->data_ = nullptr;
+  if (impl_ && impl_->storage_) {
+    // Drop this tensor's reference; other views keep the buffer alive
+    impl_->storage_.reset();
+    impl_->storage_offset_ = 0;
     impl_->is_contiguous_ = false;
   }
 }
 
 // Utility methods
-Tensor Tensor::reshape(const std::vector<int64_t>& new_shape) const {
+Tensor Tensor::reshape(const DimVector& new_shape) const {
   if (!impl_) {
     throw std::runtime_error("Cannot reshape uninitialized tensor");
   }
-  int64_t new_numel =
-      std::accumulate(new_shape.begin(), new_shape.end(), int64_t(1), std::multiplies<int64_t>());
-  if (new_numel != numel()) {
+  if (TensorImpl::compute_numel(new_shape) != numel()) {
     throw std::runtime_error("Total elements must remain the same for reshape");
   }
-  Tensor result(new_shape);
-  result.set_data_ptr(data_ptr());  // Shallow copy of data
-  result.set_strides(
-      TensorImpl::compute_strides(new_shape));  // Reshaped tensor may not be contiguous
-  result.impl_->owns_data_ = false;             // No ownership transfer
-  result.set_contiguous(false);
+  if (!is_contiguous() && impl_->storage_) {
+    // The elements are not laid out row-major, so no view can express the new shape
+    return contiguous().reshape(new_shape);
+  }
+  // Row-major reshape of dense data is a pure view over the same storage
+  return as_strided(new_shape, TensorImpl::compute_strides(new_shape), impl_->storage_offset_);
+}
+
+Tensor Tensor::as_strided(const DimVector& shape, const DimVector& strides,
+                          int64_t storage_offset) const {
+  if (!impl_) {
+    throw std::runtime_error("Cannot create a view of uninitialized tensor");
+  }
+  if (shape.size() != strides.size()) {
+    throw std::runtime_error("View shape and strides must have the same length");
+  }
+  Tensor result;
+  result.impl_ = std::make_unique<TensorImpl>(*impl_);  // Shares storage
+  result.impl_->set_sizes_and_strides(shape, strides);
+  result.impl_->storage_offset_ = storage_offset;
   return result;
 }
 
@@ -143,17 +271,78 @@ Tensor Tensor::clone() const {
   if (!impl_) {
     return Tensor();
   }
-  Tensor result(shape());
+  Tensor result(shape(), dtype());
   result.allocate();
-  std::memcpy(result.data_ptr(), data_ptr(), numel() * sizeof(float));
+  if (!data_ptr()) {
+    return result;
+  }
+  if (is_contiguous()) {
+    std::memcpy(result.data_ptr(), data_ptr(), nbytes());
+  } else {
+    copy_to_contiguous(*this, result.data_ptr());
+  }
+  return result;
+}
+
+Tensor Tensor::contiguous() const {
+  if (!impl_ || !impl_->storage_ || is_contiguous()) {
+    return *this;
+  }
+  return clone();
+}
+
+Tensor Tensor::to(DType dtype) const {
+  if (!impl_) {
+    return Tensor();
+  }
+  if (!is_contiguous() && data_ptr()) {
+    return contiguous().to(dtype);
+  }
+  Tensor result(shape(), dtype);
+  result.allocate();
+  if (!data_ptr()) {
+    return result;
+  }
+  int64_t n = numel();
+  TS_DISPATCH_ALL_TYPES(this->dtype(), "to", [&] {
+    using src_t = scalar_t;
+    const src_t* src = static_cast<const src_t*>(data_ptr());
+    TS_DISPATCH_ALL_TYPES(dtype, "to", [&] {
+      scalar_t* dst = static_cast<scalar_t*>(result.data_ptr());
+      for (int64_t i = 0; i < n; ++i) {
+        // Route through the source's compute type so Half/BFloat16 convert via float
+        dst[i] = static_cast<scalar_t>(static_cast<typename acc_type<src_t>::type>(src[i]));
+      }
+    });
+  });
   return result;
 }
 
 bool Tensor::is_contiguous() const { return impl_ ? impl_->is_contiguous_ : false; }
 
-// Explicit template instantiations (for common types, to be expanded)
+const std::shared_ptr<Storage>& Tensor::storage() const {
+  static const std::shared_ptr<Storage> empty;
+  return impl_ ? impl_->storage_ : empty;
+}
+
+int64_t Tensor::storage_offset() const { return impl_ ? impl_->storage_offset_ : 0; }
+
+uint64_t Tensor::version() const {
+  return impl_ && impl_->storage_ ? impl_->storage_->version() : 0;
+}
+
+void Tensor::bump_version() const {
+  if (impl_ && impl_->storage_) {
+    impl_->storage_->bump_version();
+  }
+}
+
+// Explicit template instantiations, one per DType
 template float* Tensor::data_ptr<float>() const;
 template double* Tensor::data_ptr<double>() const;
 template int32_t* Tensor::data_ptr<int32_t>() const;
+template int8_t* Tensor::data_ptr<int8_t>() const;
+template BFloat16* Tensor::data_ptr<BFloat16>() const;
+template Half* Tensor::data_ptr<Half>() const;
 
 }  // namespace torchscratch::core::tensor
@@ -4,79 +4,34 @@ namespace torchscratch {
 namespace core {
 namespace tensor {
 
-TensorImpl::TensorImpl(const std::vector<int64_t>& shape, DType* dtype)
-    : data_(nullptr),
+TensorImpl::TensorImpl(const DimVector& shape, DType dtype)
+    : storage_(nullptr),
+      storage_offset_(0),
       shape_(shape),
       strides_(compute_strides(shape)),
+      numel_(compute_numel(shape)),
       dtype_(dtype),
-      is_contiguous_(true),
-      owns_data_(true) {}
-
-TensorImpl::TensorImpl(const TensorImpl& other)
-    : data_(other.data_),  // Share data pointer (shallow copy)
-      shape_(other.shape_),
-      strides_(other.strides_),
-      dtype_(other.dtype_),
-      is_contiguous_(other.is_contiguous_),
-      owns_data_(false) {  // Mark as non-owning
-  // No deep copy of data
-}
-
-TensorImpl::TensorImpl(TensorImpl&& other) noexcept
-    : data_(other.data_),
-      shape_(std::move(other.shape_)),
-      strides_(std::move(other.strides_)),
-      dtype_(other.dtype_),
-      is_contiguous_(other.is_contiguous_),
-      owns_data_(other.owns_data_) {
-  other.data_ = nullptr;
-  other.owns_data_ = false;
+      itemsize_(element_size(dtype)),
+      is_contiguous_(true) {}
+
+void TensorImpl::set_sizes_and_strides(const DimVector& shape, const DimVector& strides) {
+  shape_ = shape;
+  strides_ = strides;
+  numel_ = compute_numel(shape);
+  is_contiguous_ = compute_contiguous(shape, strides);
 }
 
-TensorImpl& TensorImpl::operator=(const TensorImpl& other) {
-  if (this != &other) {
-    if (owns_data_ && data_) {
-      ::operator delete(data_);
-    }
-
-    data_ = other.data_;
-    shape_ = other.shape_;
-    strides_ = other.strides_;
-    dtype_ = other.dtype_;
-    is_contiguous_ = other.is_contiguous_;
-    owns_data_ = false;  // Mark as non-owning for assignment
+int64_t TensorImpl::compute_numel(const DimVector& shape) {
+  int64_t numel = 1;
+  for (int64_t dim : shape) {
+    numel *= dim;
   }
-  return *this;
+  return numel;
 }
 
-TensorImpl& TensorImpl::operator=(TensorImpl&& other) noexcept {
-  if (this != &other) {
-    if (owns_data_ && data_) {
-      ::operator delete(data_);
-    }
-
-    data_ = other.data_;
-    shape_ = std::move(other.shape_);
-    strides_ = std::move(other.strides_);
-    dtype_ = other.dtype_;
-    is_contiguous_ = other.is_contiguous_;
-    owns_data_ = other.owns_data_;
-
-    other.data_ = nullptr;
-    other.owns_data_ = false;
-  }
-  return *this;
-}
-
-TensorImpl::~TensorImpl() {
-  if (owns_data_ && data_) {
-    ::operator delete(data_);
-  }
-}
-
-std::vector<int64_t> TensorImpl::compute_strides(const std::vector<int64_t>& shape) {
-  std::vector<int64_t> strides(shape.size(), 0);
-  int64_t stride = 1;  // Assuming element size of 1 byte for now (dtype placeholder)
+DimVector TensorImpl::compute_strides(const DimVector& shape) {
+  DimVector strides(shape.size(), 0);
+  int64_t stride = 1;  // Strides are counted in elements, not bytes
   for (int i = shape.size() - 1; i >= 0; --i) {
     strides[i] = stride;
     stride *= shape[i];
@@ -84,6 +39,18 @@ std::vector<int64_t> TensorImpl::compute_strides(const std::vector<int64_t>& sha
   return strides;
 }
 
+bool TensorImpl::compute_contiguous(const DimVector& shape, const DimVector& strides) {
+  int64_t expected = 1;
+  for (int i = shape.size() - 1; i >= 0; --i) {
+    // Size-1 dimensions never move the pointer, so their stride is irrelevant
+    if (shape[i] != 1 && strides[i] != expected) {
+      return false;
+    }
+    expected *= shape[i];
+  }
+  return true;
+}
+
 }  // namespace tensor
 }  // namespace core
 }  // namespace torchscratch
\ No newline at end of file
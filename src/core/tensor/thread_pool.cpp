@@ -0,0 +1,89 @@
+#include "core/tensor/thread_pool.h"
+
+namespace torchscratch {
+namespace core {
+namespace tensor {
+
+ThreadPool::ThreadPool(int num_workers) {
+  workers_.reserve(num_workers);
+  for (int i = 0; i < num_workers; ++i) {
+    workers_.emplace_back([this] { worker_loop(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  work_cv_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+void ThreadPool::run(int64_t num_tasks, const std::function<void(int64_t)>& task) {
+  // One batch at a time; a second concurrent caller just runs its tasks itself
+  std::unique_lock<std::mutex> batch_lock(batch_mutex_, std::try_to_lock);
+  if (!batch_lock.owns_lock()) {
+    for (int64_t i = 0; i < num_tasks; ++i) {
+      task(i);
+    }
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  task_ = &task;
+  num_tasks_ = num_tasks;
+  next_task_ = 0;
+  remaining_ = num_tasks;
+  error_ = nullptr;
+  work_cv_.notify_all();
+
+  // The caller works too instead of sleeping
+  while (next_task_ < num_tasks_) {
+    execute_one(lock);
+  }
+  done_cv_.wait(lock, [this] { return remaining_ == 0; });
+
+  task_ = nullptr;
+  std::exception_ptr error = error_;
+  lock.unlock();
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+void ThreadPool::worker_loop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    work_cv_.wait(lock, [this] { return stop_ || (task_ && next_task_ < num_tasks_); });
+    if (stop_) {
+      return;
+    }
+    execute_one(lock);
+  }
+}
+
+void ThreadPool::execute_one(std::unique_lock<std::mutex>& lock) {
+  const int64_t index = next_task_++;
+  const std::function<void(int64_t)>* task = task_;
+  lock.unlock();
+  std::exception_ptr error;
+  try {
+    (*task)(index);
+  } catch (...) {
+    error = std::current_exception();
+  }
+  lock.lock();
+  if (error && !error_) {
+    error_ = error;
+  }
+  if (--remaining_ == 0) {
+    done_cv_.notify_all();
+  }
+}
+
+}  // namespace tensor
+}  // namespace core
+}  // namespace torchscratch
@@ -0,0 +1,763 @@
+#include "core/tensor/vectorized.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define TS_VEC_X86 1
+#include <immintrin.h>
+#else
+#define TS_VEC_X86 0
+#endif
+
+namespace torchscratch {
+namespace core {
+namespace tensor {
+
+namespace {
+
+// Portable reference loops; also the tails of the SIMD loops
+void add_scalar_isa(int64_t n, const float* a, const float* b, float* out) {
+  for (int64_t i = 0; i < n; ++i) {
+    out[i] = a[i] + b[i];
+  }
+}
+
+void sub_scalar_isa(int64_t n, const float* a, const float* b, float* out) {
+  for (int64_t i = 0; i < n; ++i) {
+    out[i] = a[i] - b[i];
+  }
+}
+
+void mul_scalar_isa(int64_t n, const float* a, const float* b, float* out) {
+  for (int64_t i = 0; i < n; ++i) {
+    out[i] = a[i] * b[i];
+  }
+}
+
+void add_scalar_scalar_isa(int64_t n, const float* a, float s, float* out) {
+  for (int64_t i = 0; i < n; ++i) {
+    out[i] = a[i] + s;
+  }
+}
+
+void mul_scalar_scalar_isa(int64_t n, const float* a, float s, float* out) {
+  for (int64_t i = 0; i < n; ++i) {
+    out[i] = a[i] * s;
+  }
+}
+
+void axpy_scalar_isa(int64_t n, float alpha, const float* x, float* y) {
+  for (int64_t i = 0; i < n; ++i) {
+    y[i] += alpha * x[i];
+  }
+}
+
+void relu_scalar_isa(int64_t n, const float* x, float* out) {
+  for (int64_t i = 0; i < n; ++i) {
+    out[i] = x[i] > 0.0f ? x[i] : 0.0f;
+  }
+}
+
+void relu_backward_scalar_isa(int64_t n, const float* x, const float* grad, float* out) {
+  for (int64_t i = 0; i < n; ++i) {
+    out[i] = x[i] > 0.0f ? grad[i] : 0.0f;
+  }
+}
+
+#if TS_VEC_X86
+
+// One set of kernels per instruction set. Each function carries its own target
+// attribute, so the library builds without -m flags and the intrinsics inline.
+// Main loops run WIDTH lanes at a time; the remainder falls back to scalar code.
+#define TS_DEFINE_ELEMENTWISE_KERNELS(ISA, TARGET, WIDTH, LOADU, STOREU, SET1, ADD, SUB, MUL, \
+                                      FMADD, MAX, ZERO, SELECT_GT0)                          \
+  TARGET void add_##ISA(int64_t n, const float* a, const float* b, float* out) {              \
+    int64_t i = 0;                                                                            \
+    for (; i + WIDTH <= n; i += WIDTH) {                                                      \
+      STOREU(out + i, ADD(LOADU(a + i), LOADU(b + i)));                                       \
+    }                                                                                         \
+    for (; i < n; ++i) {                                                                      \
+      out[i] = a[i] + b[i];                                                                   \
+    }                                                                                         \
+  }                                                                                           \
+  TARGET void sub_##ISA(int64_t n, const float* a, const float* b, float* out) {              \
+    int64_t i = 0;                                                                            \
+    for (; i + WIDTH <= n; i += WIDTH) {                                                      \
+      STOREU(out + i, SUB(LOADU(a + i), LOADU(b + i)));                                       \
+    }                                                                                         \
+    for (; i < n; ++i) {                                                                      \
+      out[i] = a[i] - b[i];                                                                   \
+    }                                                                                         \
+  }                                                                                           \
+  TARGET void mul_##ISA(int64_t n, const float* a, const float* b, float* out) {              \
+    int64_t i = 0;                                                                            \
+    for (; i + WIDTH <= n; i += WIDTH) {                                                      \
+      STOREU(out + i, MUL(LOADU(a + i), LOADU(b + i)));                                       \
+    }                                                                                         \
+    for (; i < n; ++i) {                                                                      \
+      out[i] = a[i] * b[i];                                                                   \
+    }                                                                                         \
+  }                                                                                           \
+  TARGET void add_scalar_##ISA(int64_t n, const float* a, float s, float* out) {              \
+    const auto vs = SET1(s);                                                                  \
+    int64_t i = 0;                                                                            \
+    for (; i + WIDTH <= n; i += WIDTH) {                                                      \
+      STOREU(out + i, ADD(LOADU(a + i), vs));                                                 \
+    }                                                                                         \
+    for (; i < n; ++i) {                                                                      \
+      out[i] = a[i] + s;                                                                      \
+    }                                                                                         \
+  }                                                                                           \
+  TARGET void mul_scalar_##ISA(int64_t n, const float* a, float s, float* out) {              \
+    const auto vs = SET1(s);                                                                  \
+    int64_t i = 0;                                                                            \
+    for (; i + WIDTH <= n; i += WIDTH) {                                                      \
+      STOREU(out + i, MUL(LOADU(a + i), vs));                                                 \
+    }                                                                                         \
+    for (; i < n; ++i) {                                                                      \
+      out[i] = a[i] * s;                                                                      \
+    }                                                                                         \
+  }                                                                                           \
+  TARGET void axpy_##ISA(int64_t n, float alpha, const float* x, float* y) {                  \
+    const auto va = SET1(alpha);                                                              \
+    int64_t i = 0;                                                                            \
+    for (; i + WIDTH <= n; i += WIDTH) {                                                      \
+      STOREU(y + i, FMADD(va, LOADU(x + i), LOADU(y + i)));                                   \
+    }                                                                                         \
+    for (; i < n; ++i) {                                                                      \
+      y[i] += alpha * x[i];                                                                   \
+    }                                                                                         \
+  }                                                                                           \
+  TARGET void relu_##ISA(int64_t n, const float* x, float* out) {                             \
+    const auto zero = ZERO();                                                                 \
+    int64_t i = 0;                                                                            \
+    for (; i + WIDTH <= n; i += WIDTH) {                                                      \
+      /* max returns its second operand for NaN, matching the scalar loop */                  \
+      STOREU(out + i, MAX(LOADU(x + i), zero));                                               \
+    }                                                                                         \
+    for (; i < n; ++i) {                                                                      \
+      out[i] = x[i] > 0.0f ? x[i] : 0.0f;                                                     \
+    }                                                                                         \
+  }                                                                                           \
+  TARGET void relu_backward_##ISA(int64_t n, const float* x, const float* grad, float* out) { \
+    int64_t i = 0;                                                                            \
+    for (; i + WIDTH <= n; i += WIDTH) {                                                      \
+      STOREU(out + i, SELECT_GT0(LOADU(x + i), LOADU(grad + i)));                             \
+    }                                                                                         \
+    for (; i < n; ++i) {                                                                      \
+      out[i] = x[i] > 0.0f ? grad[i] : 0.0f;                                                  \
+    }                                                                                         \
+  }
+
+// mask(x > 0) & g: the compare yields all-ones lanes where it holds
+#define TS_SSE_FMADD(a, b, c) _mm_add_ps(_mm_mul_ps(a, b), c)
+#define TS_SSE_SELECT_GT0(x, g) _mm_and_ps(_mm_cmpgt_ps(x, _mm_setzero_ps()), g)
+#define TS_AVX2_SELECT_GT0(x, g) _mm256_and_ps(_mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_GT_OQ), g)
+// Full-mask maskz form: the plain intrinsic's undefined passthrough trips
+// -Wmaybe-uninitialized in GCC's headers
+#define TS_AVX512_MAX(a, b) _mm512_maskz_max_ps(static_cast<__mmask16>(0xFFFF), a, b)
+#define TS_AVX512_SELECT_GT0(x, g) \
+  _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(x, _mm512_setzero_ps(), _CMP_GT_OQ), g)
+
+TS_DEFINE_ELEMENTWISE_KERNELS(SSE42, __attribute__((target("sse4.2"))), 4, _mm_loadu_ps,
+                              _mm_storeu_ps, _mm_set1_ps, _mm_add_ps, _mm_sub_ps, _mm_mul_ps,
+                              TS_SSE_FMADD, _mm_max_ps, _mm_setzero_ps, TS_SSE_SELECT_GT0)
+TS_DEFINE_ELEMENTWISE_KERNELS(AVX2, __attribute__((target("avx2,fma"))), 8, _mm256_loadu_ps,
+                              _mm256_storeu_ps, _mm256_set1_ps, _mm256_add_ps, _mm256_sub_ps,
+                              _mm256_mul_ps, _mm256_fmadd_ps, _mm256_max_ps, _mm256_setzero_ps,
+                              TS_AVX2_SELECT_GT0)
+TS_DEFINE_ELEMENTWISE_KERNELS(AVX512, __attribute__((target("avx512f"))), 16, _mm512_loadu_ps,
+                              _mm512_storeu_ps, _mm512_set1_ps, _mm512_add_ps, _mm512_sub_ps,
+                              _mm512_mul_ps, _mm512_fmadd_ps, TS_AVX512_MAX, _mm512_setzero_ps,
+                              TS_AVX512_SELECT_GT0)
+
+#endif  // TS_VEC_X86
+
+// Transcendentals. Each instruction set provides the same small vocabulary of
+// vector ops (Vec/IVec/Mask plus load, fmadd, select, ...) in its own
+// namespace; the approximations below are written once against it. The scalar
+// namespace also serves the tails of the SIMD loops.
+
+// Cephes-style single-precision approximations
+#define TS_DEFINE_MATH_APPROX                                                             \
+  TS_MATH_TARGET inline Vec abs_value(Vec x) {                                            \
+    return as_float(iand(as_int(x), iset1(0x7fffffff)));                                 \
+  }                                                                                       \
+  /* exp(x) = 2^n * exp(r), n = round(x / ln2), |r| <= ln2 / 2 */                          \
+  TS_MATH_TARGET inline Vec exp_approx(Vec x) {                                           \
+    /* Operand order keeps NaN: max/min return their second operand when unordered */    \
+    const Vec c = min(set1(88.72283935546875f), max(set1(-110.0f), x));               \
+    const Vec n = round(mul(c, set1(1.44269504088896341f)));                              \
+    /* ln2 split in two so n * ln2 is exact in the high part */                           \
+    Vec r = fmadd(n, set1(-0.693359375f), c);                                             \
+    r = fmadd(n, set1(2.12194440e-4f), r);                                                \
+    Vec p = set1(1.9875691500e-4f);                                                       \
+    p = fmadd(p, r, set1(1.3981999507e-3f));                                              \
+    p = fmadd(p, r, set1(8.3334519073e-3f));                                              \
+    p = fmadd(p, r, set1(4.1665795894e-2f));                                              \
+    p = fmadd(p, r, set1(1.6666665459e-1f));                                              \
+    p = fmadd(p, r, set1(5.0000001201e-1f));                                              \
+    p = fmadd(mul(p, r), r, add(r, set1(1.0f)));                                          \
+    /* Scale in two halves so 2^n stays a normal float down to the denormal results */    \
+    const Vec n1 = round(mul(n, set1(0.5f)));                                             \
+    const Vec n2 = sub(n, n1);                                                            \
+    p = mul(mul(p, pow2(n1)), pow2(n2));                                                  \
+    return select(gt(x, set1(88.72283935546875f)), set1(HUGE_VALF), p);                   \
+  }                                                                                       \
+  /* log(x) = e * ln2 + log(m), m in [sqrt(1/2), sqrt(2)) */                               \
+  TS_MATH_TARGET inline Vec log_approx(Vec x) {                                           \
+    /* Denormals are scaled into the normal range first */                                \
+    const Mask tiny = lt(x, set1(1.17549435e-38f));                                       \
+    const Vec v = select(tiny, mul(x, set1(8388608.0f)), x);                              \
+    const IVec bits = as_int(v);                                                          \
+    Vec e = add(select(tiny, set1(-23.0f), set1(0.0f)),                                   \
+                int_to_float(isub(shr23(bits), iset1(126))));                             \
+    Vec m = as_float(ior(iand(bits, iset1(0x007fffff)), iset1(0x3f000000)));              \
+    const Mask low = lt(m, set1(0.707106781186547524f));                                  \
+    e = sub(e, select(low, set1(1.0f), set1(0.0f)));                                      \
+    m = sub(add(m, select(low, m, set1(0.0f))), set1(1.0f));                              \
+    const Vec z = mul(m, m);                                                              \
+    Vec p = set1(7.0376836292e-2f);                                                       \
+    p = fmadd(p, m, set1(-1.1514610310e-1f));                                             \
+    p = fmadd(p, m, set1(1.1676998740e-1f));                                              \
+    p = fmadd(p, m, set1(-1.2420140846e-1f));                                             \
+    p = fmadd(p, m, set1(1.4249322787e-1f));                                              \
+    p = fmadd(p, m, set1(-1.6668057665e-1f));                                             \
+    p = fmadd(p, m, set1(2.0000714765e-1f));                                              \
+    p = fmadd(p, m, set1(-2.4999993993e-1f));                                             \
+    p = fmadd(p, m, set1(3.3333331174e-1f));                                              \
+    p = mul(mul(p, m), z);                                                                \
+    p = fmadd(e, set1(-2.12194440e-4f), p);                                               \
+    p = fmadd(z, set1(-0.5f), p);                                                         \
+    Vec r = fmadd(e, set1(0.693359375f), add(m, p));                                      \
+    r = select(eq(x, set1(0.0f)), set1(-HUGE_VALF), r);                                   \
+    r = select(eq(x, set1(HUGE_VALF)), x, r);                                             \
+    /* Negative or NaN */                                                                 \
+    return select(nge(x, set1(0.0f)), set1(NAN), r);                                      \
+  }                                                                                       \
+  TS_MATH_TARGET inline Vec tanh_approx(Vec x) {                                          \
+    const Vec z = abs_value(x);                                                           \
+    /* Small |x|: odd polynomial, avoiding the cancellation in 1 - 2 / (e^2x + 1) */      \
+    const Vec s = mul(x, x);                                                              \
+    Vec p = set1(-5.70498872745e-3f);                                                     \
+    p = fmadd(p, s, set1(2.06390887954e-2f));                                             \
+    p = fmadd(p, s, set1(-5.37397155531e-2f));                                            \
+    p = fmadd(p, s, set1(1.33314422036e-1f));                                             \
+    p = fmadd(p, s, set1(-3.33332819422e-1f));                                            \
+    p = fmadd(mul(p, s), x, x);                                                           \
+    Vec q = sub(set1(1.0f), div(set1(2.0f), add(exp_approx(add(z, z)), set1(1.0f))));     \
+    q = as_float(ior(as_int(q), iand(as_int(x), as_int(set1(-0.0f)))));                  \
+    return select(lt(z, set1(0.625f)), p, q);                                             \
+  }                                                                                       \
+  /* With e = exp(-|x|): 1 / (1 + e) for x >= 0, e / (1 + e) below, so large negative */ \
+  /* inputs keep their tiny results instead of dividing by an overflowed exp(-x) */      \
+  TS_MATH_TARGET inline Vec sigmoid_approx(Vec x) {                                       \
+    const Vec e = exp_approx(sub(set1(0.0f), abs_value(x)));                              \
+    return div(select(lt(x, set1(0.0f)), e, set1(1.0f)), add(set1(1.0f), e));             \
+  }
+
+// Loops over the approximations, kWidth lanes at a time with a scalar tail, and
+// the sigmoid/tanh derivatives (plain arithmetic, identical on every ISA)
+#define TS_DEFINE_MATH_KERNELS                                                            \
+  TS_MATH_TARGET void exp_kernel(int64_t n, const float* x, float* out) {                 \
+    int64_t i = 0;                                                                        \
+    for (; i + kWidth <= n; i += kWidth) {                                                \
+      store(out + i, exp_approx(load(x + i)));                                            \
+    }                                                                                     \
+    for (; i < n; ++i) {                                                                  \
+      out[i] = scalar_math::exp_approx(x[i]);                                             \
+    }                                                                                     \
+  }                                                                                       \
+  TS_MATH_TARGET void log_kernel(int64_t n, const float* x, float* out) {                 \
+    int64_t i = 0;                                                                        \
+    for (; i + kWidth <= n; i += kWidth) {                                                \
+      store(out + i, log_approx(load(x + i)));                                            \
+    }                                                                                     \
+    for (; i < n; ++i) {                                                                  \
+      out[i] = scalar_math::log_approx(x[i]);                                             \
+    }                                                                                     \
+  }                                                                                       \
+  TS_MATH_TARGET void tanh_kernel(int64_t n, const float* x, float* out) {                \
+    int64_t i = 0;                                                                        \
+    for (; i + kWidth <= n; i += kWidth) {                                                \
+      store(out + i, tanh_approx(load(x + i)));                                           \
+    }                                                                                     \
+    for (; i < n; ++i) {                                                                  \
+      out[i] = scalar_math::tanh_approx(x[i]);                                            \
+    }                                                                                     \
+  }                                                                                       \
+  TS_MATH_TARGET void sigmoid_kernel(int64_t n, const float* x, float* out) {             \
+    int64_t i = 0;                                                                        \
+    for (; i + kWidth <= n; i += kWidth) {                                                \
+      store(out + i, sigmoid_approx(load(x + i)));                                        \
+    }                                                                                     \
+    for (; i < n; ++i) {                                                                  \
+      out[i] = scalar_math::sigmoid_approx(x[i]);                                         \
+    }                                                                                     \
+  }                                                                                       \
+  TS_MATH_TARGET void sigmoid_backward_kernel(int64_t n, const float* y, const float* grad, \
+                                              float* out) {                               \
+    int64_t i = 0;                                                                        \
+    for (; i + kWidth <= n; i += kWidth) {                                                \
+      const Vec yv = load(y + i);                                                         \
+      store(out + i, mul(mul(load(grad + i), yv), sub(set1(1.0f), yv)));                  \
+    }                                                                                     \
+    for (; i < n; ++i) {                                                                  \
+      out[i] = grad[i] * y[i] * (1.0f - y[i]);                                            \
+    }                                                                                     \
+  }                                                                                       \
+  TS_MATH_TARGET void tanh_backward_kernel(int64_t n, const float* y, const float* grad,  \
+                                           float* out) {                                  \
+    int64_t i = 0;                                                                        \
+    for (; i + kWidth <= n; i += kWidth) {                                                \
+      const Vec yv = load(y + i);                                                         \
+      store(out + i, mul(load(grad + i), sub(set1(1.0f), mul(yv, yv))));                  \
+    }                                                                                     \
+    for (; i < n; ++i) {                                                                  \
+      out[i] = grad[i] * (1.0f - y[i] * y[i]);                                            \
+    }                                                                                     \
+  }
+
+namespace scalar_math {
+
+#define TS_MATH_TARGET
+using Vec = float;
+using IVec = int32_t;
+using Mask = bool;
+constexpr int64_t kWidth = 1;
+
+inline Vec load(const float* p) { return *p; }
+inline void store(float* p, Vec v) { *p = v; }
+inline Vec set1(float v) { return v; }
+inline Vec add(Vec a, Vec b) { return a + b; }
+inline Vec sub(Vec a, Vec b) { return a - b; }
+inline Vec mul(Vec a, Vec b) { return a * b; }
+inline Vec div(Vec a, Vec b) { return a / b; }
+inline Vec fmadd(Vec a, Vec b, Vec c) { return a * b + c; }
+// x86 semantics: the second operand wins when either is NaN
+inline Vec max(Vec a, Vec b) { return a > b ? a : b; }
+inline Vec min(Vec a, Vec b) { return a < b ? a : b; }
+inline Vec round(Vec v) { return std::nearbyint(v); }
+inline IVec iset1(int32_t v) { return v; }
+inline IVec iadd(IVec a, IVec b) { return static_cast<IVec>(static_cast<uint32_t>(a) + b); }
+inline IVec isub(IVec a, IVec b) { return static_cast<IVec>(static_cast<uint32_t>(a) - b); }
+inline IVec iand(IVec a, IVec b) { return a & b; }
+inline IVec ior(IVec a, IVec b) { return a | b; }
+inline IVec shr23(IVec a) { return static_cast<IVec>(static_cast<uint32_t>(a) >> 23); }
+inline Vec int_to_float(IVec a) { return static_cast<float>(a); }
+inline IVec as_int(Vec v) {
+  IVec bits;
+  std::memcpy(&bits, &v, sizeof(bits));
+  return bits;
+}
+inline Vec as_float(IVec bits) {
+  Vec v;
+  std::memcpy(&v, &bits, sizeof(v));
+  return v;
+}
+// 2^n for an integral n in [-126, 127]
+inline Vec pow2(Vec n) {
+  const IVec e = n == n ? static_cast<IVec>(n) : 0;
+  return as_float(static_cast<IVec>(static_cast<uint32_t>(e + 127) << 23));
+}
+inline Mask lt(Vec a, Vec b) { return a < b; }
+inline Mask gt(Vec a, Vec b) { return a > b; }
+inline Mask eq(Vec a, Vec b) { return a == b; }
+inline Mask nge(Vec a, Vec b) { return !(a >= b); }
+inline Vec select(Mask m, Vec a, Vec b) { return m ? a : b; }
+
+TS_DEFINE_MATH_APPROX
+TS_DEFINE_MATH_KERNELS
+#undef TS_MATH_TARGET
+
+}  // namespace scalar_math
+
+#if TS_VEC_X86
+
+namespace sse42_math {
+
+#define TS_MATH_TARGET __attribute__((target("sse4.2")))
+using Vec = __m128;
+using IVec = __m128i;
+using Mask = __m128;
+constexpr int64_t kWidth = 4;
+
+TS_MATH_TARGET inline Vec load(const float* p) { return _mm_loadu_ps(p); }
+TS_MATH_TARGET inline void store(float* p, Vec v) { _mm_storeu_ps(p, v); }
+TS_MATH_TARGET inline Vec set1(float v) { return _mm_set1_ps(v); }
+TS_MATH_TARGET inline Vec add(Vec a, Vec b) { return _mm_add_ps(a, b); }
+TS_MATH_TARGET inline Vec sub(Vec a, Vec b) { return _mm_sub_ps(a, b); }
+TS_MATH_TARGET inline Vec mul(Vec a, Vec b) { return _mm_mul_ps(a, b); }
+TS_MATH_TARGET inline Vec div(Vec a, Vec b) { return _mm_div_ps(a, b); }
+TS_MATH_TARGET inline Vec fmadd(Vec a, Vec b, Vec c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+TS_MATH_TARGET inline Vec max(Vec a, Vec b) { return _mm_max_ps(a, b); }
+TS_MATH_TARGET inline Vec min(Vec a, Vec b) { return _mm_min_ps(a, b); }
+TS_MATH_TARGET inline Vec round(Vec v) {
+  return _mm_round_ps(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+}
+TS_MATH_TARGET inline IVec iset1(int32_t v) { return _mm_set1_epi32(v); }
+TS_MATH_TARGET inline IVec iadd(IVec a, IVec b) { return _mm_add_epi32(a, b); }
+TS_MATH_TARGET inline IVec isub(IVec a, IVec b) { return _mm_sub_epi32(a, b); }
+TS_MATH_TARGET inline IVec iand(IVec a, IVec b) { return _mm_and_si128(a, b); }
+TS_MATH_TARGET inline IVec ior(IVec a, IVec b) { return _mm_or_si128(a, b); }
+TS_MATH_TARGET inline IVec shr23(IVec a) { return _mm_srli_epi32(a, 23); }
+TS_MATH_TARGET inline Vec int_to_float(IVec a) { return _mm_cvtepi32_ps(a); }
+TS_MATH_TARGET inline IVec as_int(Vec v) { return _mm_castps_si128(v); }
+TS_MATH_TARGET inline Vec as_float(IVec bits) { return _mm_castsi128_ps(bits); }
+TS_MATH_TARGET inline Vec pow2(Vec n) {
+  return as_float(_mm_slli_epi32(_mm_add_epi32(_mm_cvtps_epi32(n), iset1(127)), 23));
+}
+TS_MATH_TARGET inline Mask lt(Vec a, Vec b) { return _mm_cmplt_ps(a, b); }
+TS_MATH_TARGET inline Mask gt(Vec a, Vec b) { return _mm_cmpgt_ps(a, b); }
+TS_MATH_TARGET inline Mask eq(Vec a, Vec b) { return _mm_cmpeq_ps(a, b); }
+TS_MATH_TARGET inline Mask nge(Vec a, Vec b) { return _mm_cmpnge_ps(a, b); }
+TS_MATH_TARGET inline Vec select(Mask m, Vec a, Vec b) { return _mm_blendv_ps(b, a, m); }
+
+TS_DEFINE_MATH_APPROX
+TS_DEFINE_MATH_KERNELS
+#undef TS_MATH_TARGET
+
+}  // namespace sse42_math
+
+namespace avx2_math {
+
+#define TS_MATH_TARGET __attribute__((target("avx2,fma")))
+using Vec = __m256;
+using IVec = __m256i;
+using Mask = __m256;
+constexpr int64_t kWidth = 8;
+
+TS_MATH_TARGET inline Vec load(const float* p) { return _mm256_loadu_ps(p); }
+TS_MATH_TARGET inline void store(float* p, Vec v) { _mm256_storeu_ps(p, v); }
+TS_MATH_TARGET inline Vec set1(float v) { return _mm256_set1_ps(v); }
+TS_MATH_TARGET inline Vec add(Vec a, Vec b) { return _mm256_add_ps(a, b); }
+TS_MATH_TARGET inline Vec sub(Vec a, Vec b) { return _mm256_sub_ps(a, b); }
+TS_MATH_TARGET inline Vec mul(Vec a, Vec b) { return _mm256_mul_ps(a, b); }
+TS_MATH_TARGET inline Vec div(Vec a, Vec b) { return _mm256_div_ps(a, b); }
+TS_MATH_TARGET inline Vec fmadd(Vec a, Vec b, Vec c) { return _mm256_fmadd_ps(a, b, c); }
+TS_MATH_TARGET inline Vec max(Vec a, Vec b) { return _mm256_max_ps(a, b); }
+TS_MATH_TARGET inline Vec min(Vec a, Vec b) { return _mm256_min_ps(a, b); }
+TS_MATH_TARGET inline Vec round(Vec v) {
+  return _mm256_round_ps(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+}
+TS_MATH_TARGET inline IVec iset1(int32_t v) { return _mm256_set1_epi32(v); }
+TS_MATH_TARGET inline IVec iadd(IVec a, IVec b) { return _mm256_add_epi32(a, b); }
+TS_MATH_TARGET inline IVec isub(IVec a, IVec b) { return _mm256_sub_epi32(a, b); }
+TS_MATH_TARGET inline IVec iand(IVec a, IVec b) { return _mm256_and_si256(a, b); }
+TS_MATH_TARGET inline IVec ior(IVec a, IVec b) { return _mm256_or_si256(a, b); }
+TS_MATH_TARGET inline IVec shr23(IVec a) { return _mm256_srli_epi32(a, 23); }
+TS_MATH_TARGET inline Vec int_to_float(IVec a) { return _mm256_cvtepi32_ps(a); }
+TS_MATH_TARGET inline IVec as_int(Vec v) { return _mm256_castps_si256(v); }
+TS_MATH_TARGET inline Vec as_float(IVec bits) { return _mm256_castsi256_ps(bits); }
+TS_MATH_TARGET inline Vec pow2(Vec n) {
+  return as_float(_mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), iset1(127)), 23));
+}
+TS_MATH_TARGET inline Mask lt(Vec a, Vec b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+TS_MATH_TARGET inline Mask gt(Vec a, Vec b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+TS_MATH_TARGET inline Mask eq(Vec a, Vec b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+TS_MATH_TARGET inline Mask nge(Vec a, Vec b) { return _mm256_cmp_ps(a, b, _CMP_NGE_UQ); }
+TS_MATH_TARGET inline Vec select(Mask m, Vec a, Vec b) { return _mm256_blendv_ps(b, a, m); }
+
+TS_DEFINE_MATH_APPROX
+TS_DEFINE_MATH_KERNELS
+#undef TS_MATH_TARGET
+
+}  // namespace avx2_math
+
+namespace avx512_math {
+
+#define TS_MATH_TARGET __attribute__((target("avx512f")))
+using Vec = __m512;
+using IVec = __m512i;
+using Mask = __mmask16;
+constexpr int64_t kWidth = 16;
+constexpr __mmask16 kAll = 0xFFFF;
+
+// Full-mask maskz forms where the plain intrinsic has an undefined passthrough
+TS_MATH_TARGET inline Vec load(const float* p) { return _mm512_loadu_ps(p); }
+TS_MATH_TARGET inline void store(float* p, Vec v) { _mm512_storeu_ps(p, v); }
+TS_MATH_TARGET inline Vec set1(float v) { return _mm512_set1_ps(v); }
+TS_MATH_TARGET inline Vec add(Vec a, Vec b) { return _mm512_add_ps(a, b); }
+TS_MATH_TARGET inline Vec sub(Vec a, Vec b) { return _mm512_sub_ps(a, b); }
+TS_MATH_TARGET inline Vec mul(Vec a, Vec b) { return _mm512_mul_ps(a, b); }
+TS_MATH_TARGET inline Vec div(Vec a, Vec b) { return _mm512_div_ps(a, b); }
+TS_MATH_TARGET inline Vec fmadd(Vec a, Vec b, Vec c) { return _mm512_fmadd_ps(a, b, c); }
+TS_MATH_TARGET inline Vec max(Vec a, Vec b) { return _mm512_maskz_max_ps(kAll, a, b); }
+TS_MATH_TARGET inline Vec min(Vec a, Vec b) { return _mm512_maskz_min_ps(kAll, a, b); }
+TS_MATH_TARGET inline Vec round(Vec v) {
+  return _mm512_maskz_roundscale_ps(kAll, v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+}
+TS_MATH_TARGET inline IVec iset1(int32_t v) { return _mm512_set1_epi32(v); }
+TS_MATH_TARGET inline IVec iadd(IVec a, IVec b) { return _mm512_add_epi32(a, b); }
+TS_MATH_TARGET inline IVec isub(IVec a, IVec b) { return _mm512_sub_epi32(a, b); }
+TS_MATH_TARGET inline IVec iand(IVec a, IVec b) { return _mm512_and_si512(a, b); }
+TS_MATH_TARGET inline IVec ior(IVec a, IVec b) { return _mm512_or_si512(a, b); }
+TS_MATH_TARGET inline IVec shr23(IVec a) { return _mm512_maskz_srli_epi32(kAll, a, 23); }
+TS_MATH_TARGET inline Vec int_to_float(IVec a) { return _mm512_maskz_cvtepi32_ps(kAll, a); }
+TS_MATH_TARGET inline IVec as_int(Vec v) { return _mm512_castps_si512(v); }
+TS_MATH_TARGET inline Vec as_float(IVec bits) { return _mm512_castsi512_ps(bits); }
+TS_MATH_TARGET inline Vec pow2(Vec n) {
+  const IVec e = _mm512_add_epi32(_mm512_maskz_cvtps_epi32(kAll, n), iset1(127));
+  return as_float(_mm512_maskz_slli_epi32(kAll, e, 23));
+}
+TS_MATH_TARGET inline Mask lt(Vec a, Vec b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+TS_MATH_TARGET inline Mask gt(Vec a, Vec b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+TS_MATH_TARGET inline Mask eq(Vec a, Vec b) { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+TS_MATH_TARGET inline Mask nge(Vec a, Vec b) { return _mm512_cmp_ps_mask(a, b, _CMP_NGE_UQ); }
+TS_MATH_TARGET inline Vec select(Mask m, Vec a, Vec b) { return _mm512_mask_blend_ps(m, b, a); }
+
+TS_DEFINE_MATH_APPROX
+TS_DEFINE_MATH_KERNELS
+#undef TS_MATH_TARGET
+
+}  // namespace avx512_math
+
+#endif  // TS_VEC_X86
+
+// MathAccuracy::Precise: the C library, correctly rounded or within 1 ulp
+void exp_libm(int64_t n, const float* x, float* out) {
+  for (int64_t i = 0; i < n; ++i) {
+    out[i] = std::exp(x[i]);
+  }
+}
+
+void log_libm(int64_t n, const float* x, float* out) {
+  for (int64_t i = 0; i < n; ++i) {
+    out[i] = std::log(x[i]);
+  }
+}
+
+void tanh_libm(int64_t n, const float* x, float* out) {
+  for (int64_t i = 0; i < n; ++i) {
+    out[i] = std::tanh(x[i]);
+  }
+}
+
+void sigmoid_libm(int64_t n, const float* x, float* out) {
+  for (int64_t i = 0; i < n; ++i) {
+    const float e = std::exp(-std::fabs(x[i]));
+    out[i] = (x[i] < 0.0f ? e : 1.0f) / (1.0f + e);
+  }
+}
+
+CpuIsa detect_isa() {
+#if TS_VEC_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return CpuIsa::AVX512;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return CpuIsa::AVX2;
+  }
+  if (__builtin_cpu_supports("sse4.2")) {
+    return CpuIsa::SSE42;
+  }
+#endif
+  return CpuIsa::Scalar;
+}
+
+// cpu_max_isa(), lowered by TORCHSCRATCH_CPU_ISA if that names a lower set
+CpuIsa initial_isa() {
+  const CpuIsa max_isa = cpu_max_isa();
+  const char* requested = std::getenv("TORCHSCRATCH_CPU_ISA");
+  if (!requested || !*requested) {
+    return max_isa;
+  }
+  try {
+    const CpuIsa isa = parse_cpu_isa(requested);
+    if (static_cast<int>(isa) > static_cast<int>(max_isa)) {
+      std::cerr << "TORCHSCRATCH_CPU_ISA=" << requested << " is not supported on this CPU; using "
+                << cpu_isa_name(max_isa) << std::endl;
+      return max_isa;
+    }
+    return isa;
+  } catch (const std::runtime_error& error) {
+    std::cerr << error.what() << "; ignoring TORCHSCRATCH_CPU_ISA" << std::endl;
+    return max_isa;
+  }
+}
+
+// MathAccuracy::Fast unless TORCHSCRATCH_MATH_ACCURACY says otherwise
+MathAccuracy initial_accuracy() {
+  const char* requested = std::getenv("TORCHSCRATCH_MATH_ACCURACY");
+  if (!requested || !*requested) {
+    return MathAccuracy::Fast;
+  }
+  try {
+    return parse_math_accuracy(requested);
+  } catch (const std::runtime_error& error) {
+    std::cerr << error.what() << "; ignoring TORCHSCRATCH_MATH_ACCURACY" << std::endl;
+    return MathAccuracy::Fast;
+  }
+}
+
+#define TS_BIND_ELEMENTWISE_KERNELS(k, ISA) \
+  k.add = add_##ISA;                        \
+  k.sub = sub_##ISA;                        \
+  k.mul = mul_##ISA;                        \
+  k.add_scalar = add_scalar_##ISA;          \
+  k.mul_scalar = mul_scalar_##ISA;          \
+  k.axpy = axpy_##ISA;                      \
+  k.relu = relu_##ISA;                      \
+  k.relu_backward = relu_backward_##ISA
+
+#define TS_BIND_MATH_KERNELS(k, NS)                   \
+  k.exp = NS::exp_kernel;                             \
+  k.log = NS::log_kernel;                             \
+  k.tanh = NS::tanh_kernel;                           \
+  k.sigmoid = NS::sigmoid_kernel;                     \
+  k.sigmoid_backward = NS::sigmoid_backward_kernel;   \
+  k.tanh_backward = NS::tanh_backward_kernel
+
+ElementwiseKernels make_kernels(CpuIsa isa, MathAccuracy accuracy) {
+  ElementwiseKernels k{};
+  switch (isa) {
+#if TS_VEC_X86
+    case CpuIsa::AVX512:
+      TS_BIND_ELEMENTWISE_KERNELS(k, AVX512);
+      TS_BIND_MATH_KERNELS(k, avx512_math);
+      break;
+    case CpuIsa::AVX2:
+      TS_BIND_ELEMENTWISE_KERNELS(k, AVX2);
+      TS_BIND_MATH_KERNELS(k, avx2_math);
+      break;
+    case CpuIsa::SSE42:
+      TS_BIND_ELEMENTWISE_KERNELS(k, SSE42);
+      TS_BIND_MATH_KERNELS(k, sse42_math);
+      break;
+#endif
+    default:
+      TS_BIND_ELEMENTWISE_KERNELS(k, scalar_isa);
+      TS_BIND_MATH_KERNELS(k, scalar_math);
+      break;
+  }
+  if (accuracy == MathAccuracy::Precise) {
+    k.exp = exp_libm;
+    k.log = log_libm;
+    k.tanh = tanh_libm;
+    k.sigmoid = sigmoid_libm;
+  }
+  return k;
+}
+
+const ElementwiseKernels& kernels_for(CpuIsa isa, MathAccuracy accuracy) {
+  // Every (ISA, accuracy) pair, built once
+  static const std::vector<ElementwiseKernels> tables = [] {
+    std::vector<ElementwiseKernels> all;
+    for (CpuIsa i : {CpuIsa::Scalar, CpuIsa::SSE42, CpuIsa::AVX2, CpuIsa::AVX512}) {
+      all.push_back(make_kernels(i, MathAccuracy::Fast));
+      all.push_back(make_kernels(i, MathAccuracy::Precise));
+    }
+    return all;
+  }();
+  return tables[static_cast<size_t>(isa) * 2 + (accuracy == MathAccuracy::Precise ? 1 : 0)];
+}
+
+void check_supported(CpuIsa isa) {
+  if (static_cast<int>(isa) > static_cast<int>(cpu_max_isa())) {
+    throw std::runtime_error(std::string("CPU instruction set ") + cpu_isa_name(isa) +
+                             " is not supported on this CPU");
+  }
+}
+
+// The selection and the table it resolves to. Readers only load the table
+// pointer; the setters serialize so it always matches the pair they store.
+struct ActiveKernels {
+  std::mutex mutex;
+  std::atomic<CpuIsa> isa{initial_isa()};
+  std::atomic<MathAccuracy> accuracy{initial_accuracy()};
+  std::atomic<const ElementwiseKernels*> kernels{&kernels_for(isa, accuracy)};
+};
+
+ActiveKernels& active() {
+  static ActiveKernels state;
+  return state;
+}
+
+}  // namespace
+
+const char* cpu_isa_name(CpuIsa isa) {
+  switch (isa) {
+    case CpuIsa::Scalar:
+      return "scalar";
+    case CpuIsa::SSE42:
+      return "sse4.2";
+    case CpuIsa::AVX2:
+      return "avx2";
+    case CpuIsa::AVX512:
+      return "avx512";
+  }
+  return "unknown";
+}
+
+CpuIsa parse_cpu_isa(const std::string& name) {
+  for (CpuIsa isa : {CpuIsa::Scalar, CpuIsa::SSE42, CpuIsa::AVX2, CpuIsa::AVX512}) {
+    if (name == cpu_isa_name(isa)) {
+      return isa;
+    }
+  }
+  throw std::runtime_error("Unknown CPU instruction set '" + name +
+                           "' (expected scalar, sse4.2, avx2 or avx512)");
+}
+
+CpuIsa cpu_max_isa() {
+  static const CpuIsa isa = detect_isa();
+  return isa;
+}
+
+CpuIsa cpu_isa() { return active().isa.load(std::memory_order_relaxed); }
+
+void set_cpu_isa(CpuIsa isa) {
+  check_supported(isa);
+  ActiveKernels& state = active();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  state.isa.store(isa, std::memory_order_relaxed);
+  state.kernels.store(&kernels_for(isa, state.accuracy), std::memory_order_release);
+}
+
+const char* math_accuracy_name(MathAccuracy accuracy) {
+  return accuracy == MathAccuracy::Precise ? "precise" : "fast";
+}
+
+MathAccuracy parse_math_accuracy(const std::string& name) {
+  if (name == "fast") {
+    return MathAccuracy::Fast;
+  }
+  if (name == "precise") {
+    return MathAccuracy::Precise;
+  }
+  throw std::runtime_error("Unknown math accuracy '" + name + "' (expected fast or precise)");
+}
+
+MathAccuracy math_accuracy() { return active().accuracy.load(std::memory_order_relaxed); }
+
+void set_math_accuracy(MathAccuracy accuracy) {
+  ActiveKernels& state = active();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  state.accuracy.store(accuracy, std::memory_order_relaxed);
+  state.kernels.store(&kernels_for(state.isa, accuracy), std::memory_order_release);
+}
+
+const ElementwiseKernels& elementwise_kernels() {
+  return *active().kernels.load(std::memory_order_acquire);
+}
+
+const ElementwiseKernels& elementwise_kernels(CpuIsa isa) {
+  return elementwise_kernels(isa, math_accuracy());
+}
+
+const ElementwiseKernels& elementwise_kernels(CpuIsa isa, MathAccuracy accuracy) {
+  check_supported(isa);
+  return kernels_for(isa, accuracy);
+}
+
+}  // namespace tensor
+}  // namespace core
+}  // namespace torchscratch
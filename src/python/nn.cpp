@@ -32,14 +32,40 @@ void init_nn(py::module& m) {
                &ts::core::nn::Linear::bias),
            py::return_value_policy::reference);
 
+  // Fused linear layer: activation(input @ weight.T + bias)
+  py::enum_<ts::core::tensor::Activation>(nn, "Activation")
+      .value("none", ts::core::tensor::Activation::None)
+      .value("relu", ts::core::tensor::Activation::ReLU)
+      .value("sigmoid", ts::core::tensor::Activation::Sigmoid)
+      .value("tanh", ts::core::tensor::Activation::Tanh);
+  nn.def(
+      "linear_act",
+      [](const ts::core::autograd::Variable& input, const ts::core::autograd::Variable& weight,
+         const ts::core::autograd::Variable* bias, ts::core::tensor::Activation activation) {
+        return bias ? ts::core::nn::linear_act(input, weight, *bias, activation)
+                    : ts::core::nn::linear_act(input, weight, activation);
+      },
+      "Linear layer with bias and activation fused into the matmul", py::arg("input"),
+      py::arg("weight"), py::arg("bias") = nullptr,
+      py::arg("activation") = ts::core::tensor::Activation::None);
+
   // Activation functions
   nn.def("relu", &ts::core::nn::relu, "ReLU activation function");
   nn.def("sigmoid", &ts::core::nn::sigmoid, "Sigmoid activation function");
   nn.def("tanh", &ts::core::nn::tanh_activation, "Tanh activation function");
 
   // Loss functions
-  nn.def("mse_loss", &ts::core::nn::mse_loss, "Mean Squared Error loss");
+  nn.def(
+      "mse_loss",
+      [](const ts::core::autograd::Variable& predicted, const ts::core::autograd::Variable& target,
+         const std::string& reduction) {
+        return ts::core::nn::mse_loss(predicted, target, ts::core::nn::parse_reduction(reduction));
+      },
+      "Mean Squared Error loss; reduction is 'none', 'sum' or 'mean'", py::arg("predicted"),
+      py::arg("target"), py::arg("reduction") = "mean");
   nn.def("binary_cross_entropy_loss", &ts::core::nn::binary_cross_entropy_loss,
          "Binary Cross Entropy loss");
-  nn.def("cross_entropy_loss", &ts::core::nn::cross_entropy_loss, "Cross Entropy loss");
+  nn.def("cross_entropy_loss", &ts::core::nn::cross_entropy_loss, "Cross Entropy loss",
+         py::arg("predicted"), py::arg("target"), py::arg("label_smoothing") = 0.0f,
+         py::arg("ignore_index") = -100);
 }
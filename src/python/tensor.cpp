@@ -5,15 +5,43 @@
 #include <pybind11/stl.h>
 
 #include <memory>
+#include <string>
 #include <vector>
 
+#include "core/autograd/engine.h"
 #include "core/autograd/function.h"
+#include "core/autograd/grad_mode.h"
 #include "core/autograd/variable.h"
+#include "core/tensor/allocator.h"
+#include "core/tensor/arena.h"
 #include "core/tensor/ops.h"
+#include "core/tensor/parallel.h"
+#include "core/tensor/vectorized.h"
 
 namespace py = pybind11;
 namespace ts = torchscratch;
 
+// Python-side StepArena: the guard lives between __enter__ and __exit__
+struct PyStepArena {
+  explicit PyStepArena(size_t chunk_size) : arena(chunk_size) {}
+
+  ts::core::tensor::StepArena arena;
+  std::unique_ptr<ts::core::tensor::StepArenaGuard> guard;
+};
+
+// Python-side grad mode scopes, guarded between __enter__ and __exit__ like
+// PyStepArena
+struct PyNoGrad {
+  std::unique_ptr<ts::core::autograd::NoGradGuard> guard;
+};
+
+struct PyInferenceMode {
+  explicit PyInferenceMode(bool enabled) : enabled(enabled) {}
+
+  bool enabled;
+  std::unique_ptr<ts::core::autograd::InferenceMode> guard;
+};
+
 // Helper function to convert numpy array to our Tensor
 ts::core::tensor::Tensor numpy_to_tensor(py::array_t<float> array) {
   py::buffer_info buf = array.request();
@@ -42,26 +70,62 @@ py::array_t<float> tensor_to_numpy(const ts::core::tensor::Tensor& tensor) {
   py::array_t<float> array(numpy_shape);
   py::buffer_info buf = array.request();
 
-  // Copy data from tensor to numpy array
-  std::memcpy(buf.ptr, tensor.data_ptr<float>(),
+  // Copy data from tensor to numpy array (views are densified first)
+  std::memcpy(buf.ptr, tensor.contiguous().data_ptr<float>(),
               sizeof(float) * static_cast<size_t>(tensor.numel()));
 
   return array;
 }
 
 void init_tensor(py::module& m) {
+  // Element types
+  py::enum_<ts::core::tensor::DType>(m, "dtype")
+      .value("float32", ts::core::tensor::DType::Float32)
+      .value("float64", ts::core::tensor::DType::Float64)
+      .value("int32", ts::core::tensor::DType::Int32)
+      .value("int8", ts::core::tensor::DType::Int8)
+      .value("bfloat16", ts::core::tensor::DType::BFloat16)
+      .value("float16", ts::core::tensor::DType::Float16)
+      .export_values();
+
   // Define Tensor class
   py::class_<ts::core::tensor::Tensor>(m, "Tensor")
       .def(py::init<>())
-      .def(py::init<const std::vector<int64_t>&>())
+      .def(py::init<const std::vector<int64_t>&, ts::core::tensor::DType>(), py::arg("shape"),
+           py::arg("dtype") = ts::core::tensor::DType::Float32)
       .def(py::init([](py::array_t<float> array) { return numpy_to_tensor(array); }))
-      .def("shape", &ts::core::tensor::Tensor::shape)
-      .def("strides", &ts::core::tensor::Tensor::strides)
+      .def_static(
+          "from_mmap",
+          [](const std::string& path, int64_t offset, const std::vector<int64_t>& shape,
+             ts::core::tensor::DType dtype, bool copy_on_write) {
+            return ts::core::tensor::Tensor::from_mmap(
+                path, offset, shape, dtype,
+                copy_on_write ? ts::core::tensor::MmapMode::CopyOnWrite
+                              : ts::core::tensor::MmapMode::ReadOnly);
+          },
+          py::arg("path"), py::arg("offset"), py::arg("shape"),
+          py::arg("dtype") = ts::core::tensor::DType::Float32, py::arg("copy_on_write") = false,
+          "Create a tensor backed by a memory-mapped file")
+      .def("shape",
+           [](const ts::core::tensor::Tensor& tensor) -> std::vector<int64_t> {
+             return tensor.shape();
+           })
+      .def("strides",
+           [](const ts::core::tensor::Tensor& tensor) -> std::vector<int64_t> {
+             return tensor.strides();
+           })
       .def("dim", &ts::core::tensor::Tensor::dim)
       .def("numel", &ts::core::tensor::Tensor::numel)
+      .def("dtype", &ts::core::tensor::Tensor::dtype)
+      .def("to", &ts::core::tensor::Tensor::to, py::arg("dtype"))
       .def("is_contiguous", &ts::core::tensor::Tensor::is_contiguous)
-      .def("reshape", &ts::core::tensor::Tensor::reshape)
+      .def("version", &ts::core::tensor::Tensor::version)
+      .def("reshape",
+           [](const ts::core::tensor::Tensor& tensor, const std::vector<int64_t>& shape) {
+             return tensor.reshape(shape);
+           })
       .def("clone", &ts::core::tensor::Tensor::clone)
+      .def("contiguous", &ts::core::tensor::Tensor::contiguous)
       .def("allocate", &ts::core::tensor::Tensor::allocate)
       .def("deallocate", &ts::core::tensor::Tensor::deallocate)
       .def("is_cuda", &ts::core::tensor::Tensor::is_cuda)
@@ -75,7 +139,7 @@ void init_tensor(py::module& m) {
           if (i < shape.size() - 1)
             ss << ", ";
         }
-        ss << "])";
+        ss << "], dtype=" << ts::core::tensor::dtype_name(tensor.dtype()) << ")";
         return ss.str();
       });
 
@@ -83,10 +147,209 @@ void init_tensor(py::module& m) {
   m.def("add", &ts::core::tensor::add, "Element-wise addition of two tensors");
   m.def("sub", &ts::core::tensor::sub, "Element-wise subtraction of two tensors");
   m.def("mul", &ts::core::tensor::mul, "Element-wise multiplication of two tensors");
-  m.def("matmul", &ts::core::tensor::matmul, "Matrix multiplication");
+  m.def("matmul", &ts::core::tensor::matmul, "Matrix multiplication", py::arg("a"), py::arg("b"),
+        py::arg("trans_a") = false, py::arg("trans_b") = false);
+  m.def("bmm", &ts::core::tensor::bmm, "Batched matrix multiplication of 3-D tensors");
   m.def("transpose", &ts::core::tensor::transpose, "Transpose a tensor", py::arg("tensor"),
         py::arg("dim0") = 0, py::arg("dim1") = 1);
 
+  m.def(
+      "expand",
+      [](const ts::core::tensor::Tensor& tensor, const std::vector<int64_t>& shape) {
+        return ts::core::tensor::expand(tensor, shape);
+      },
+      "Broadcast view of a tensor with stride 0 along expanded dimensions", py::arg("tensor"),
+      py::arg("shape"));
+  m.def(
+      "sum_to",
+      [](const ts::core::tensor::Tensor& tensor, const std::vector<int64_t>& shape) {
+        return ts::core::tensor::sum_to(tensor, shape);
+      },
+      "Sum a tensor down to a shape it was broadcast from", py::arg("tensor"), py::arg("shape"));
+  m.def(
+      "broadcast_shapes",
+      [](const std::vector<int64_t>& a, const std::vector<int64_t>& b) -> std::vector<int64_t> {
+        return ts::core::tensor::broadcast_shapes(a, b);
+      },
+      "Shape that two shapes broadcast to");
+
+  // Reductions; an empty dims list reduces over every dimension
+  m.def(
+      "sum",
+      [](const ts::core::tensor::Tensor& tensor, const std::vector<int64_t>& dims, bool keepdim) {
+        return ts::core::tensor::sum(tensor, dims, keepdim);
+      },
+      "Sum over dimensions", py::arg("tensor"), py::arg("dims") = std::vector<int64_t>(),
+      py::arg("keepdim") = false);
+  m.def(
+      "mean",
+      [](const ts::core::tensor::Tensor& tensor, const std::vector<int64_t>& dims, bool keepdim) {
+        return ts::core::tensor::mean(tensor, dims, keepdim);
+      },
+      "Mean over dimensions", py::arg("tensor"), py::arg("dims") = std::vector<int64_t>(),
+      py::arg("keepdim") = false);
+  m.def(
+      "max",
+      [](const ts::core::tensor::Tensor& tensor, const std::vector<int64_t>& dims, bool keepdim) {
+        return ts::core::tensor::max(tensor, dims, keepdim);
+      },
+      "Maximum over dimensions", py::arg("tensor"), py::arg("dims") = std::vector<int64_t>(),
+      py::arg("keepdim") = false);
+  m.def(
+      "min",
+      [](const ts::core::tensor::Tensor& tensor, const std::vector<int64_t>& dims, bool keepdim) {
+        return ts::core::tensor::min(tensor, dims, keepdim);
+      },
+      "Minimum over dimensions", py::arg("tensor"), py::arg("dims") = std::vector<int64_t>(),
+      py::arg("keepdim") = false);
+  m.def(
+      "norm",
+      [](const ts::core::tensor::Tensor& tensor, double p, const std::vector<int64_t>& dims,
+         bool keepdim) { return ts::core::tensor::norm(tensor, p, dims, keepdim); },
+      "p-norm over dimensions", py::arg("tensor"), py::arg("p") = 2.0,
+      py::arg("dims") = std::vector<int64_t>(), py::arg("keepdim") = false);
+  m.def(
+      "argmax",
+      [](const ts::core::tensor::Tensor& tensor, py::object dim, bool keepdim) {
+        if (dim.is_none()) {
+          return ts::core::tensor::argmax(tensor);
+        }
+        return ts::core::tensor::argmax(tensor, dim.cast<int64_t>(), keepdim);
+      },
+      "Int32 index of the first maximum along dim, or of the flattened tensor",
+      py::arg("tensor"), py::arg("dim") = py::none(), py::arg("keepdim") = false);
+
+  // Out and in-place variants; they write into an existing tensor and return it
+  m.def("add_out", &ts::core::tensor::add_out, "Element-wise addition into out", py::arg("out"),
+        py::arg("a"), py::arg("b"));
+  m.def("sub_out", &ts::core::tensor::sub_out, "Element-wise subtraction into out",
+        py::arg("out"), py::arg("a"), py::arg("b"));
+  m.def("mul_out", &ts::core::tensor::mul_out, "Element-wise multiplication into out",
+        py::arg("out"), py::arg("a"), py::arg("b"));
+  m.def("matmul_out", &ts::core::tensor::matmul_out, "Matrix multiplication into out",
+        py::arg("out"), py::arg("a"), py::arg("b"), py::arg("trans_a") = false,
+        py::arg("trans_b") = false);
+  m.def("bmm_out", &ts::core::tensor::bmm_out, "Batched matrix multiplication into out",
+        py::arg("out"), py::arg("a"), py::arg("b"));
+  m.def("add_", &ts::core::tensor::add_, "In-place addition: self += other");
+  m.def("sub_", &ts::core::tensor::sub_, "In-place subtraction: self -= other");
+  m.def("mul_", &ts::core::tensor::mul_, "In-place multiplication: self *= other");
+  m.def("scale_", &ts::core::tensor::scale_, "In-place scaling: self *= alpha", py::arg("self"),
+        py::arg("alpha"));
+  m.def("axpy_", &ts::core::tensor::axpy_, "In-place self += alpha * x", py::arg("self"),
+        py::arg("alpha"), py::arg("x"));
+
+  // Caching allocator controls
+  m.def(
+      "memory_stats",
+      []() {
+        auto stats = ts::core::tensor::CachingAllocator::instance().stats();
+        py::dict result;
+        result["hits"] = stats.hits;
+        result["misses"] = stats.misses;
+        result["bytes_cached"] = stats.bytes_cached;
+        result["bytes_in_use"] = stats.bytes_in_use;
+        result["peak_bytes_in_use"] = stats.peak_bytes_in_use;
+        return result;
+      },
+      "Statistics of the caching tensor allocator");
+  m.def(
+      "empty_cache", []() { ts::core::tensor::CachingAllocator::instance().empty_cache(); },
+      "Release all cached tensor memory back to the system");
+
+  // Intra-op thread pool controls
+  m.def("get_num_threads", &ts::core::tensor::get_num_threads,
+        "Number of threads used by intra-op parallel kernels");
+  m.def("set_num_threads", &ts::core::tensor::set_num_threads,
+        "Set the number of threads used by intra-op parallel kernels", py::arg("num_threads"));
+  m.def("get_num_backward_threads", &ts::core::autograd::get_num_backward_threads,
+        "Number of threads a backward pass may run independent graph branches on");
+  m.def("set_num_backward_threads", &ts::core::autograd::set_num_backward_threads,
+        "Set the number of threads used for inter-op parallelism in backward",
+        py::arg("num_threads"));
+  m.def("deterministic_backward", &ts::core::autograd::deterministic_backward,
+        "Whether backward sums gradients in a fixed order, independent of scheduling");
+  m.def("set_deterministic_backward", &ts::core::autograd::set_deterministic_backward,
+        "Make gradients bitwise reproducible regardless of backward threading",
+        py::arg("deterministic"));
+
+  // Instruction set of the element-wise SIMD kernels
+  m.def(
+      "get_cpu_isa",
+      []() { return std::string(ts::core::tensor::cpu_isa_name(ts::core::tensor::cpu_isa())); },
+      "Instruction set used by element-wise kernels (scalar, sse4.2, avx2 or avx512)");
+  m.def(
+      "get_max_cpu_isa",
+      []() {
+        return std::string(ts::core::tensor::cpu_isa_name(ts::core::tensor::cpu_max_isa()));
+      },
+      "Best instruction set supported by this CPU");
+  m.def(
+      "set_cpu_isa",
+      [](const std::string& name) {
+        ts::core::tensor::set_cpu_isa(ts::core::tensor::parse_cpu_isa(name));
+      },
+      "Switch element-wise kernels to another supported instruction set", py::arg("name"));
+  m.def(
+      "get_math_accuracy",
+      []() {
+        return std::string(
+            ts::core::tensor::math_accuracy_name(ts::core::tensor::math_accuracy()));
+      },
+      "Accuracy tier of exp/log/tanh/sigmoid kernels (fast or precise)");
+  m.def(
+      "set_math_accuracy",
+      [](const std::string& name) {
+        ts::core::tensor::set_math_accuracy(ts::core::tensor::parse_math_accuracy(name));
+      },
+      "Select SIMD approximations ('fast') or the C library ('precise') for exp/log/tanh/sigmoid",
+      py::arg("name"));
+
+  // Per-step arena: `with ts.StepArena():` around one training step
+  py::class_<PyStepArena>(m, "StepArena")
+      .def(py::init<size_t>(), py::arg("chunk_size") = static_cast<size_t>(4) << 20)
+      .def("__enter__",
+           [](PyStepArena& self) -> PyStepArena& {
+             self.guard = std::make_unique<ts::core::tensor::StepArenaGuard>(self.arena);
+             return self;
+           })
+      .def("__exit__", [](PyStepArena& self, py::object, py::object, py::object) {
+        self.guard.reset();
+        return false;
+      })
+      .def("bytes_used", [](const PyStepArena& self) { return self.arena.bytes_used(); })
+      .def("capacity", [](const PyStepArena& self) { return self.arena.capacity(); });
+
+  // Gradient recording, per thread: `with ts.no_grad():` or `with ts.inference_mode():`
+  m.def("is_grad_enabled", &ts::core::autograd::GradMode::is_enabled,
+        "Whether operations on this thread record the autograd graph");
+  m.def("set_grad_enabled", &ts::core::autograd::GradMode::set_enabled,
+        "Enable or disable autograd graph recording on this thread", py::arg("enabled"));
+  m.def("is_inference_mode_enabled", &ts::core::autograd::InferenceMode::is_enabled,
+        "Whether this thread is inside an inference_mode scope");
+  py::class_<PyNoGrad>(m, "no_grad")
+      .def(py::init<>())
+      .def("__enter__",
+           [](PyNoGrad& self) -> PyNoGrad& {
+             self.guard = std::make_unique<ts::core::autograd::NoGradGuard>();
+             return self;
+           })
+      .def("__exit__", [](PyNoGrad& self, py::object, py::object, py::object) {
+        self.guard.reset();
+        return false;
+      });
+  py::class_<PyInferenceMode>(m, "inference_mode")
+      .def(py::init<bool>(), py::arg("enabled") = true)
+      .def("__enter__",
+           [](PyInferenceMode& self) -> PyInferenceMode& {
+             self.guard = std::make_unique<ts::core::autograd::InferenceMode>(self.enabled);
+             return self;
+           })
+      .def("__exit__", [](PyInferenceMode& self, py::object, py::object, py::object) {
+        self.guard.reset();
+        return false;
+      });
+
   // Tensor creation functions
   m.def(
       "tensor",
@@ -138,7 +401,9 @@ void init_tensor(py::module& m) {
       .def("requires_grad", &ts::core::autograd::Variable::requires_grad)
       .def("backward", &ts::core::autograd::Variable::backward)
       .def("detach", &ts::core::autograd::Variable::detach)
-      .def("shape", [](const ts::core::autograd::Variable& var) { return var.data().shape(); })
+      .def("shape", [](const ts::core::autograd::Variable& var) -> std::vector<int64_t> {
+             return var.data().shape();
+           })
       .def("item",
            [](const ts::core::autograd::Variable& var) {
              if (var.data().numel() != 1) {
@@ -159,67 +424,63 @@ void init_tensor(py::module& m) {
   m.def(
       "add",
       [](const ts::core::autograd::Variable& a, const ts::core::autograd::Variable& b) {
-        // Create an AddFunction to handle backward pass
-        auto func = std::make_shared<ts::core::autograd::AddFunction>();
-
-        // Forward pass
-        ts::core::tensor::Tensor result_tensor = ts::core::tensor::add(a.data(), b.data());
-
-        // Create result variable with requires_grad if either input requires grad
-        bool requires_grad = a.requires_grad() || b.requires_grad();
-        ts::core::autograd::Variable result(result_tensor, requires_grad);
-
-        // Setup backward computation if needed
-        if (requires_grad) {
-          result.set_grad_fn(func);
-          // Save inputs for backward pass
-          func->save_for_backward({const_cast<ts::core::autograd::Variable*>(&a),
-                                   const_cast<ts::core::autograd::Variable*>(&b)});
-        }
-
-        return result;
+        return ts::core::autograd::add(a, b);
       },
       "Add two Variables");
 
   m.def(
       "mul",
       [](const ts::core::autograd::Variable& a, const ts::core::autograd::Variable& b) {
-        auto func = std::make_shared<ts::core::autograd::MulFunction>();
-
-        // Forward pass
-        ts::core::tensor::Tensor result_tensor = ts::core::tensor::mul(a.data(), b.data());
-
-        bool requires_grad = a.requires_grad() || b.requires_grad();
-        ts::core::autograd::Variable result(result_tensor, requires_grad);
-
-        if (requires_grad) {
-          result.set_grad_fn(func);
-          func->save_for_backward({const_cast<ts::core::autograd::Variable*>(&a),
-                                   const_cast<ts::core::autograd::Variable*>(&b)});
-        }
-
-        return result;
+        return ts::core::autograd::mul(a, b);
       },
       "Multiply two Variables");
 
   m.def(
       "matmul",
       [](const ts::core::autograd::Variable& a, const ts::core::autograd::Variable& b) {
-        auto func = std::make_shared<ts::core::autograd::MatMulFunction>();
-
-        // Forward pass
-        ts::core::tensor::Tensor result_tensor = ts::core::tensor::matmul(a.data(), b.data());
-
-        bool requires_grad = a.requires_grad() || b.requires_grad();
-        ts::core::autograd::Variable result(result_tensor, requires_grad);
+        return ts::core::autograd::matmul(a, b);
+      },
+      "Matrix multiplication of two Variables");
 
-        if (requires_grad) {
-          result.set_grad_fn(func);
-          func->save_for_backward({const_cast<ts::core::autograd::Variable*>(&a),
-                                   const_cast<ts::core::autograd::Variable*>(&b)});
-        }
+  m.def(
+      "bmm",
+      [](const ts::core::autograd::Variable& a, const ts::core::autograd::Variable& b) {
+        return ts::core::autograd::bmm(a, b);
+      },
+      "Batched matrix multiplication of two 3-D Variables");
 
-        return result;
+  m.def(
+      "sum",
+      [](const ts::core::autograd::Variable& a, const std::vector<int64_t>& dims, bool keepdim) {
+        return ts::core::autograd::sum(a, dims, keepdim);
       },
-      "Matrix multiplication of two Variables");
-}
\ No newline at end of file
+      "Sum of a Variable over dimensions", py::arg("a"), py::arg("dims") = std::vector<int64_t>(),
+      py::arg("keepdim") = false);
+  m.def(
+      "mean",
+      [](const ts::core::autograd::Variable& a, const std::vector<int64_t>& dims, bool keepdim) {
+        return ts::core::autograd::mean(a, dims, keepdim);
+      },
+      "Mean of a Variable over dimensions", py::arg("a"),
+      py::arg("dims") = std::vector<int64_t>(), py::arg("keepdim") = false);
+  m.def(
+      "max",
+      [](const ts::core::autograd::Variable& a, const std::vector<int64_t>& dims, bool keepdim) {
+        return ts::core::autograd::max(a, dims, keepdim);
+      },
+      "Maximum of a Variable over dimensions", py::arg("a"),
+      py::arg("dims") = std::vector<int64_t>(), py::arg("keepdim") = false);
+  m.def(
+      "min",
+      [](const ts::core::autograd::Variable& a, const std::vector<int64_t>& dims, bool keepdim) {
+        return ts::core::autograd::min(a, dims, keepdim);
+      },
+      "Minimum of a Variable over dimensions", py::arg("a"),
+      py::arg("dims") = std::vector<int64_t>(), py::arg("keepdim") = false);
+  m.def(
+      "norm",
+      [](const ts::core::autograd::Variable& a, double p, const std::vector<int64_t>& dims,
+         bool keepdim) { return ts::core::autograd::norm(a, p, dims, keepdim); },
+      "p-norm of a Variable over dimensions", py::arg("a"), py::arg("p") = 2.0,
+      py::arg("dims") = std::vector<int64_t>(), py::arg("keepdim") = false);
+}
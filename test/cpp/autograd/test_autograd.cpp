@@ -1,6 +1,17 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#include "core/autograd/engine.h"
+#include "core/autograd/grad_mode.h"
 #include "core/autograd/variable.h"
+#include "core/nn/activation.h"
+#include "core/nn/linear.h"
+#include "core/nn/loss.h"
+#include "core/tensor/arena.h"
 #include "core/tensor/ops.h"
 #include "core/tensor/tensor.h"
 
@@ -156,9 +167,9 @@ Variable safe_add(const Variable& a, const Variable& b) {
   Variable result(result_tensor, requires_grad);
 
   if (requires_grad) {
-    // Set gradient function and save inputs for backward pass
+    // Connect the gradient function to the inputs' graph nodes
+    func->set_next_edges({a.gradient_edge(), b.gradient_edge()});
     result.set_grad_fn(func);
-    func->save_for_backward({const_cast<Variable*>(&a), const_cast<Variable*>(&b)});
   }
 
   return result;
@@ -174,8 +185,8 @@ Variable safe_mul(const Variable& a, const Variable& b) {
   Variable result(result_tensor, requires_grad);
 
   if (requires_grad) {
+    func->set_next_edges({a.gradient_edge(), b.gradient_edge()});
     result.set_grad_fn(func);
-    func->save_for_backward({const_cast<Variable*>(&a), const_cast<Variable*>(&b)});
   }
 
   return result;
@@ -197,8 +208,8 @@ Variable safe_matmul(const Variable& a, const Variable& b) {
   Variable result(result_tensor, requires_grad);
 
   if (requires_grad) {
+    func->set_next_edges({a.gradient_edge(), b.gradient_edge()});
     result.set_grad_fn(func);
-    func->save_for_backward({const_cast<Variable*>(&a), const_cast<Variable*>(&b)});
   }
 
   return result;
@@ -219,11 +230,8 @@ TEST(AutogradTest, VariableConstructor) {
   // Test Variable constructor with requires_grad=true
   Variable var_with_grad(t, true);
   EXPECT_TRUE(var_with_grad.requires_grad());
-  EXPECT_TRUE(var_with_grad.grad().data_ptr() != nullptr);  // Gradient tensor allocated
+  EXPECT_FALSE(var_with_grad.grad().data_ptr());  // Allocated by the first backward
   EXPECT_EQ(var_with_grad.grad_fn(), nullptr);
-
-  // Check gradient is initialized to zeros
-  check_tensor_values(var_with_grad.grad(), {0.0f, 0.0f, 0.0f, 0.0f});
 }
 
 TEST(AutogradTest, VariableDetach) {
@@ -383,6 +391,573 @@ TEST(AutogradTest, MatMulOperation) {
   EXPECT_EQ(b.grad().shape(), std::vector<int64_t>({3, 2}));
 }
 
+TEST(AutogradTest, BmmOperation) {
+  // a: [2, 2, 3], b: [1, 3, 2] broadcast over the batch
+  tensor::Tensor t1({2, 2, 3});
+  tensor::Tensor t2({1, 3, 2});
+  fill_tensor_data(t1, {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f});
+  fill_tensor_data(t2, {7.0f, 8.0f, 9.0f, 10.0f, 11.0f, 12.0f});
+
+  Variable a(t1, true);
+  Variable b(t2, true);
+  Variable result = bmm(a, b);
+  EXPECT_EQ(result.grad_fn()->name(), "BmmFunction");
+  EXPECT_EQ(result.shape(), std::vector<int64_t>({2, 2, 2}));
+  check_tensor_values(result.data(), {58.0f, 64.0f, 139.0f, 154.0f, 7.0f, 8.0f, 9.0f, 10.0f});
+
+  tensor::Tensor ones({2, 2, 2});
+  fill_tensor_data(ones, std::vector<float>(8, 1.0f));
+  result.set_grad(ones);
+  result.backward();
+
+  // With grad_output all ones: d/da = row sums of b, d/db = column sums of a
+  // over both batches, since b was broadcast
+  EXPECT_EQ(a.grad().shape(), std::vector<int64_t>({2, 2, 3}));
+  EXPECT_EQ(b.grad().shape(), std::vector<int64_t>({1, 3, 2}));
+  check_tensor_values(a.grad(),
+                      {15.0f, 19.0f, 23.0f, 15.0f, 19.0f, 23.0f, 15.0f, 19.0f, 23.0f, 15.0f,
+                       19.0f, 23.0f});
+  check_tensor_values(b.grad(), {6.0f, 6.0f, 8.0f, 8.0f, 9.0f, 9.0f});
+}
+
+TEST(AutogradTest, ReductionOperations) {
+  tensor::Tensor t({2, 3});
+  fill_tensor_data(t, {1.0f, 5.0f, 5.0f, -4.0f, 0.0f, 3.0f});
+
+  // sum over rows: every element receives its row's gradient
+  Variable a(t, true);
+  Variable s = sum(a, {1});
+  EXPECT_EQ(s.grad_fn()->name(), "SumFunction");
+  EXPECT_EQ(s.shape(), std::vector<int64_t>({2}));
+  check_tensor_values(s.data(), {11.0f, -1.0f});
+  tensor::Tensor g({2});
+  fill_tensor_data(g, {1.0f, 2.0f});
+  s.set_grad(g);
+  s.backward();
+  check_tensor_values(a.grad(), {1.0f, 1.0f, 1.0f, 2.0f, 2.0f, 2.0f});
+
+  // mean over everything
+  Variable b(t, true);
+  Variable m = mean(b, {}, true);
+  EXPECT_EQ(m.shape(), std::vector<int64_t>({1, 1}));
+  tensor::Tensor one({1, 1});
+  fill_tensor_data(one, {1.0f});
+  m.set_grad(one);
+  m.backward();
+  check_tensor_values(b.grad(), std::vector<float>(6, 1.0f / 6.0f));
+
+  // max splits the gradient evenly between tied maxima
+  Variable c(t, true);
+  Variable mx = max(c, {1});
+  check_tensor_values(mx.data(), {5.0f, 3.0f});
+  tensor::Tensor ones({2});
+  fill_tensor_data(ones, {1.0f, 1.0f});
+  mx.set_grad(ones);
+  mx.backward();
+  check_tensor_values(c.grad(), {0.0f, 0.5f, 0.5f, 0.0f, 0.0f, 1.0f});
+
+  // 2-norm of each row: d/dx = x / ||x||
+  Variable d(t, true);
+  Variable n = norm(d, 2, {1});
+  check_tensor_values(n.data(), {std::sqrt(51.0f), 5.0f});
+  n.set_grad(ones);
+  n.backward();
+  const float r = std::sqrt(51.0f);
+  check_tensor_values(d.grad(), {1.0f / r, 5.0f / r, 5.0f / r, -0.8f, 0.0f, 0.6f});
+}
+
+TEST(AutogradTest, MseLoss) {
+  tensor::Tensor p_data({2, 2});
+  tensor::Tensor t_data({2, 2});
+  fill_tensor_data(p_data, {1.0f, 2.0f, 3.0f, 4.0f});
+  fill_tensor_data(t_data, {0.0f, 2.0f, 5.0f, 3.0f});
+  tensor::Tensor one({1});
+  fill_tensor_data(one, {1.0f});
+
+  // Mean: only the prediction needs a gradient
+  Variable p(p_data, true);
+  Variable t(t_data, false);
+  Variable loss = nn::mse_loss(p, t);
+  EXPECT_EQ(loss.grad_fn()->name(), "MSELossFunction");
+  check_tensor_values(loss.data(), {1.5f});
+  loss.set_grad(one);
+  loss.backward();
+  check_tensor_values(p.grad(), {0.5f, 0.0f, -1.0f, 0.5f});
+
+  // Sum, with gradients for both sides
+  Variable p2(p_data, true);
+  Variable t2(t_data, true);
+  Variable total = nn::mse_loss(p2, t2, nn::Reduction::Sum);
+  check_tensor_values(total.data(), {6.0f});
+  total.set_grad(one);
+  total.backward();
+  check_tensor_values(p2.grad(), {2.0f, 0.0f, -4.0f, 2.0f});
+  check_tensor_values(t2.grad(), {-2.0f, 0.0f, 4.0f, -2.0f});
+
+  // None keeps the shape and scales by the incoming gradient
+  Variable t3(t_data, true);
+  Variable p3(p_data, false);
+  Variable terms = nn::mse_loss(p3, t3, nn::Reduction::None);
+  EXPECT_EQ(terms.shape(), std::vector<int64_t>({2, 2}));
+  check_tensor_values(terms.data(), {1.0f, 0.0f, 4.0f, 1.0f});
+  tensor::Tensor g({2, 2});
+  fill_tensor_data(g, {1.0f, 1.0f, 0.5f, 2.0f});
+  terms.set_grad(g);
+  terms.backward();
+  check_tensor_values(t3.grad(), {-2.0f, 0.0f, 2.0f, -4.0f});
+
+  // A broadcast target falls back to the generic ops
+  tensor::Tensor row({2});
+  fill_tensor_data(row, {1.0f, 2.0f});
+  Variable p4(p_data, true);
+  Variable t4(row, true);
+  Variable bcast = nn::mse_loss(p4, t4, nn::Reduction::Sum);
+  check_tensor_values(bcast.data(), {8.0f});
+  bcast.set_grad(one);
+  bcast.backward();
+  check_tensor_values(p4.grad(), {0.0f, 0.0f, 4.0f, 4.0f});
+  check_tensor_values(t4.grad(), {-4.0f, -4.0f});
+
+  EXPECT_EQ(nn::parse_reduction("sum"), nn::Reduction::Sum);
+  EXPECT_THROW(nn::parse_reduction("avg"), std::runtime_error);
+}
+
+TEST(AutogradTest, CrossEntropyLoss) {
+  const int64_t batch = 3;
+  const int64_t classes = 300;  // Spans more than one exp block per row
+  tensor::Tensor logits_data({batch, classes});
+  std::vector<float> values(batch * classes);
+  for (size_t i = 0; i < values.size(); ++i) {
+    values[i] = std::sin(0.37f * static_cast<float>(i)) * 8.0f;
+  }
+  values[5] = 1000.0f;  // Would overflow a naive exp
+  fill_tensor_data(logits_data, values);
+  tensor::Tensor target_data({batch}, tensor::DType::Int32);
+  target_data.allocate();
+  const int32_t targets[] = {5, 42, 7};
+  std::copy(targets, targets + batch, target_data.data_ptr<int32_t>());
+
+  // Reference in double: row 2 is ignored
+  const double smoothing = 0.1;
+  std::vector<double> expected_grad(values.size(), 0.0);
+  double expected_loss = 0.0;
+  for (int64_t r = 0; r < 2; ++r) {
+    const float* x = values.data() + r * classes;
+    double m = *std::max_element(x, x + classes);
+    double s = 0.0;
+    double mean_x = 0.0;
+    for (int64_t j = 0; j < classes; ++j) {
+      s += std::exp(x[j] - m);
+      mean_x += x[j] / classes;
+    }
+    double lse = m + std::log(s);
+    expected_loss += ((1 - smoothing) * (lse - x[targets[r]]) + smoothing * (lse - mean_x)) / 2;
+    for (int64_t j = 0; j < classes; ++j) {
+      double onehot = j == targets[r] ? 1.0 : 0.0;
+      expected_grad[r * classes + j] =
+          (std::exp(x[j] - lse) - (1 - smoothing) * onehot - smoothing / classes) / 2;
+    }
+  }
+
+  Variable logits(logits_data, true);
+  Variable target(target_data, false);
+  Variable loss = nn::cross_entropy_loss(logits, target, 0.1f, 7);
+  EXPECT_EQ(loss.grad_fn()->name(), "CrossEntropyLossFunction");
+  EXPECT_EQ(loss.shape(), std::vector<int64_t>({1}));
+  EXPECT_NEAR(loss.data().data_ptr<float>()[0], expected_loss, 1e-4 * expected_loss);
+
+  tensor::Tensor one({1});
+  fill_tensor_data(one, {1.0f});
+  loss.set_grad(one);
+  loss.backward();
+  const float* grad = logits.grad().data_ptr<float>();
+  for (size_t i = 0; i < values.size(); ++i) {
+    EXPECT_NEAR(grad[i], expected_grad[i], 1e-6) << "at " << i;
+  }
+
+  // Defaults: no smoothing, nothing ignored
+  Variable plain = nn::cross_entropy_loss(logits, target);
+  EXPECT_GT(plain.data().data_ptr<float>()[0], 0.0f);
+
+  // Class indices are not differentiable, even when they require gradients
+  Variable indices(target_data, true);
+  EXPECT_FALSE(nn::cross_entropy_loss(logits.detach(), indices).grad_fn());
+  Variable with_indices = nn::cross_entropy_loss(logits, indices);
+  ASSERT_EQ(with_indices.grad_fn()->next_edges().size(), 2u);
+  EXPECT_FALSE(with_indices.grad_fn()->next_edges()[1].valid());
+
+  tensor::Tensor bad_target({batch}, tensor::DType::Int32);
+  bad_target.allocate();
+  std::fill(bad_target.data_ptr<int32_t>(), bad_target.data_ptr<int32_t>() + batch, classes);
+  EXPECT_THROW(nn::cross_entropy_loss(logits, Variable(bad_target, false)), std::runtime_error);
+  EXPECT_THROW(nn::cross_entropy_loss(logits, target, 1.5f), std::runtime_error);
+}
+
+TEST(AutogradTest, BackwardScheduling) {
+  tensor::Tensor t({2});
+  fill_tensor_data(t, {1.0f, 3.0f});
+  tensor::Tensor ones({2});
+  fill_tensor_data(ones, {1.0f, 1.0f});
+
+  // Two copies of an intermediate feed the same consumer: the producer runs
+  // once, after both gradients have arrived. z = x*x + x*x, dz/dx = 4x
+  Variable x(t, true);
+  Variable y = mul(x, x);
+  Variable y_copy = y;
+  Variable z = add(y, y_copy);
+  z.set_grad(ones);
+  z.backward();
+  check_tensor_values(x.grad(), {4.0f, 12.0f});
+
+  // The saved state is freed after the first backward
+  EXPECT_TRUE(y.grad_fn()->released());
+  EXPECT_THROW(z.backward(), std::runtime_error);
+
+  // A long chain is walked, and later destroyed, without recursion:
+  // out = x + x + ... + x, with only the last result held
+  const int depth = 100000;
+  Variable w(t, true);
+  Variable out = add(w, w);
+  for (int i = 0; i < depth; ++i) {
+    out = add(out, w);
+  }
+  out.set_grad(ones);
+  out.backward();
+  check_tensor_values(w.grad(), {depth + 2.0f, depth + 2.0f});
+}
+
+TEST(AutogradTest, GraphOwnsItsEdges) {
+  tensor::Tensor t({2});
+  fill_tensor_data(t, {0.5f, -1.0f});
+  tensor::Tensor ones({2});
+  fill_tensor_data(ones, {1.0f, 1.0f});
+
+  // The intermediates go out of scope before backward; the graph keeps what
+  // it needs. y = sigmoid(x * x + x)
+  Variable x(t, true);
+  auto build = [](const Variable& input) {
+    Variable square = mul(input, input);
+    return nn::sigmoid(add(square, input));
+  };
+  Variable y = build(x);
+  ASSERT_FALSE(y.grad_fn()->saved_tensors().empty());
+  y.set_grad(ones);
+  y.backward();
+  for (int i = 0; i < 2; ++i) {
+    const float v = t.data_ptr<float>()[i];
+    const float s = 1.0f / (1.0f + std::exp(-(v * v + v)));
+    EXPECT_NEAR(x.grad().data_ptr<float>()[i], s * (1 - s) * (2 * v + 1), 1e-6);
+  }
+  // Saved tensors are dropped once backward has used them
+  EXPECT_TRUE(y.grad_fn()->saved_tensors().empty());
+
+  // Copies of a variable share its gradient
+  Variable x_copy = x;
+  EXPECT_EQ(x_copy.grad().data_ptr(), x.grad().data_ptr());
+  EXPECT_FALSE(x.detach().requires_grad());
+
+  // Inputs that do not require gradients get no edge and no gradient
+  Variable c(t, false);
+  Variable z = mul(x, c);
+  EXPECT_TRUE(z.grad_fn()->needs_input_grad(0));
+  EXPECT_FALSE(z.grad_fn()->needs_input_grad(1));
+  z.set_grad(ones);
+  z.backward();
+  EXPECT_FALSE(c.grad().data_ptr());
+}
+
+TEST(AutogradTest, LazyGradientAccumulation) {
+  tensor::Tensor t1({2});
+  tensor::Tensor t2({2});
+  fill_tensor_data(t1, {1.0f, 2.0f});
+  fill_tensor_data(t2, {3.0f, 4.0f});
+  tensor::Tensor ones({2});
+  fill_tensor_data(ones, {1.0f, 1.0f});
+
+  // Nothing is allocated until a gradient arrives, and only for leaves
+  Variable a(t1, true);
+  Variable b(t2, true);
+  Variable prod = mul(a, b);
+  Variable out = add(prod, a);
+  EXPECT_FALSE(a.grad().data_ptr());
+  out.set_grad(ones);
+  out.backward();
+  EXPECT_FALSE(prod.grad().data_ptr());
+  check_tensor_values(a.grad(), {4.0f, 5.0f});
+  check_tensor_values(b.grad(), {1.0f, 2.0f});
+
+  // A second backward accumulates into the same buffers
+  const void* a_buffer = a.grad().data_ptr();
+  Variable again = mul(a, b);
+  again.set_grad(ones);
+  again.backward();
+  EXPECT_EQ(a.grad().data_ptr(), a_buffer);
+  check_tensor_values(a.grad(), {7.0f, 9.0f});
+
+  // add hands one tensor to both inputs and the root gradient belongs to the
+  // caller: neither may end up shared between gradients
+  Variable c(t1, true);
+  Variable d(t2, true);
+  Variable sum_cd = add(c, d);
+  sum_cd.set_grad(ones);
+  sum_cd.backward();
+  EXPECT_NE(c.grad().data_ptr(), d.grad().data_ptr());
+  EXPECT_NE(c.grad().data_ptr(), ones.data_ptr());
+  Variable more = add(c, c);
+  more.set_grad(ones);
+  more.backward();
+  check_tensor_values(c.grad(), {3.0f, 3.0f});
+  check_tensor_values(d.grad(), {1.0f, 1.0f});
+  check_tensor_values(ones, {1.0f, 1.0f});
+}
+
+TEST(AutogradTest, GradMode) {
+  tensor::Tensor t1({2, 2});
+  tensor::Tensor t2({2, 2});
+  fill_tensor_data(t1, {1.0f, 2.0f, 3.0f, 4.0f});
+  fill_tensor_data(t2, {5.0f, 6.0f, 7.0f, 8.0f});
+  Variable a(t1, true);
+  Variable b(t2, true);
+  nn::Linear linear(2, 3);
+
+  EXPECT_TRUE(GradMode::is_enabled());
+  {
+    NoGradGuard no_grad;
+    EXPECT_FALSE(GradMode::is_enabled());
+
+    // Results are computed but nothing is recorded
+    Variable prod = mul(a, b);
+    check_tensor_values(prod.data(), {5.0f, 12.0f, 21.0f, 32.0f});
+    for (const Variable& v :
+         {prod, add(a, b), matmul(a, b), sum(a, {1}), nn::relu(a), nn::sigmoid(a),
+          nn::mse_loss(a, b), linear.forward(a)}) {
+      EXPECT_FALSE(v.requires_grad());
+      EXPECT_FALSE(v.grad_fn());
+    }
+
+    // The mode is per thread
+    bool other_thread_enabled = false;
+    std::thread([&] { other_thread_enabled = GradMode::is_enabled(); }).join();
+    EXPECT_TRUE(other_thread_enabled);
+
+    // Guards nest and restore the enclosing mode
+    {
+      AutoGradMode enable(true);
+      EXPECT_TRUE(add(a, b).grad_fn());
+    }
+    EXPECT_FALSE(GradMode::is_enabled());
+  }
+  EXPECT_TRUE(GradMode::is_enabled());
+  EXPECT_TRUE(mul(a, b).grad_fn());
+
+  EXPECT_FALSE(InferenceMode::is_enabled());
+  {
+    InferenceMode guard;
+    EXPECT_TRUE(InferenceMode::is_enabled());
+    EXPECT_FALSE(GradMode::is_enabled());
+    EXPECT_FALSE(linear.forward(a).requires_grad());
+  }
+  EXPECT_FALSE(InferenceMode::is_enabled());
+  EXPECT_TRUE(GradMode::is_enabled());
+}
+
+TEST(AutogradTest, ParallelBackward) {
+  const int saved_threads = get_num_backward_threads();
+  const bool saved_deterministic = deterministic_backward();
+
+  tensor::Tensor x_data({4, 16});
+  x_data.allocate();
+  for (int64_t i = 0; i < x_data.numel(); ++i) {
+    x_data.data_ptr<float>()[i] = std::sin(0.7f * i);
+  }
+  std::vector<tensor::Tensor> w_data;
+  for (int k = 0; k < 8; ++k) {
+    tensor::Tensor w({16, 16});
+    w.allocate();
+    for (int64_t i = 0; i < w.numel(); ++i) {
+      w.data_ptr<float>()[i] = 0.1f * std::cos(0.3f * i + k);
+    }
+    w_data.push_back(w);
+  }
+
+  // Eight towers over a shared input meet in one loss; their backward passes
+  // are independent and all send gradients to x
+  auto build_loss = [&](const Variable& x) {
+    Variable loss(tensor::Tensor(), false);
+    for (int k = 0; k < 8; ++k) {
+      Variable h = nn::tanh_activation(matmul(x, Variable(w_data[k], true)));
+      Variable tower = sum(mul(h, h));
+      loss = k == 0 ? tower : add(loss, tower);
+    }
+    return loss;
+  };
+  auto x_grad = [&](int threads, bool deterministic) {
+    set_num_backward_threads(threads);
+    set_deterministic_backward(deterministic);
+    Variable x(x_data, true);
+    build_loss(x).backward();
+    return x.grad();
+  };
+
+  const tensor::Tensor serial = x_grad(1, false);
+  const tensor::Tensor parallel = x_grad(4, false);
+  for (int64_t i = 0; i < serial.numel(); ++i) {
+    EXPECT_NEAR(parallel.data_ptr<float>()[i], serial.data_ptr<float>()[i], 1e-5f);
+  }
+
+  // Deterministic mode gives the same bits whatever the schedule
+  const tensor::Tensor reference = x_grad(1, true);
+  const size_t bytes = reference.numel() * sizeof(float);
+  for (int run = 0; run < 5; ++run) {
+    const tensor::Tensor repeat = x_grad(4, true);
+    EXPECT_EQ(std::memcmp(repeat.data_ptr(), reference.data_ptr(), bytes), 0);
+  }
+
+  // A node failing on a pool thread fails the whole backward pass
+  set_num_backward_threads(4);
+  set_deterministic_backward(false);
+  Variable x(x_data, true);
+  Variable loss = build_loss(x);
+  loss.backward();
+  EXPECT_THROW(loss.backward(), std::runtime_error);
+
+  set_num_backward_threads(saved_threads);
+  set_deterministic_backward(saved_deterministic);
+  EXPECT_THROW(set_num_backward_threads(0), std::runtime_error);
+}
+
+TEST(AutogradTest, StepArenaKeepsGradientsOnTheHeap) {
+  nn::Linear linear(8, 4);
+  tensor::Tensor x_data({16, 8});
+  tensor::Tensor y_data({16, 4});
+  x_data.allocate();
+  y_data.allocate();
+  for (int64_t i = 0; i < x_data.numel(); ++i) {
+    x_data.data_ptr<float>()[i] = std::sin(0.1f * i);
+  }
+  for (int64_t i = 0; i < y_data.numel(); ++i) {
+    y_data.data_ptr<float>()[i] = std::cos(0.2f * i);
+  }
+  Variable x(x_data);
+  Variable y(y_data);
+
+  // The first backward creates the parameters' gradients inside the guard;
+  // they must not pin a chunk, or every later step would need a fresh one
+  tensor::StepArena arena(1 << 16);
+  size_t capacity = 0;
+  for (int step = 0; step < 3; ++step) {
+    {
+      tensor::StepArenaGuard guard(arena);
+      Variable loss = nn::mse_loss(linear.forward(x), y);
+      loss.backward();
+    }
+    if (step == 0) {
+      capacity = arena.capacity();
+    }
+    EXPECT_EQ(arena.capacity(), capacity) << "step " << step;
+  }
+  for (Variable* param : linear.parameters()) {
+    ASSERT_TRUE(param->grad().data_ptr());
+    EXPECT_FALSE(param->grad().storage()->from_arena());
+  }
+}
+
+TEST(AutogradTest, LinearActOperation) {
+  tensor::Tensor x_data({2, 3});
+  tensor::Tensor w_data({2, 3});
+  tensor::Tensor b_data({2});
+  fill_tensor_data(x_data, {1.0f, -2.0f, 0.5f, 0.0f, 1.0f, -1.0f});
+  fill_tensor_data(w_data, {0.5f, 0.25f, -1.0f, 1.0f, -0.5f, 0.75f});
+  fill_tensor_data(b_data, {0.1f, -0.2f});
+
+  Variable x(x_data, true);
+  Variable w(w_data, true);
+  Variable b(b_data, true);
+  Variable y = nn::linear_act(x, w, b, nn::Activation::Sigmoid);
+  EXPECT_EQ(y.grad_fn()->name(), "LinearActFunction");
+  EXPECT_EQ(y.shape(), std::vector<int64_t>({2, 2}));
+
+  tensor::Tensor ones({2, 2});
+  fill_tensor_data(ones, std::vector<float>(4, 1.0f));
+  y.set_grad(ones);
+  y.backward();
+
+  // With grad_output all ones: dz = y * (1 - y), then
+  // d/dx = dz @ w, d/dw = dz.T @ x, d/db = column sums of dz
+  const float* out = y.data().data_ptr<float>();
+  float dz[4];
+  for (int i = 0; i < 4; ++i) {
+    dz[i] = out[i] * (1.0f - out[i]);
+  }
+  const float* xs = x_data.data_ptr<float>();
+  const float* ws = w_data.data_ptr<float>();
+  std::vector<float> grad_x(6, 0.0f);
+  std::vector<float> grad_w(6, 0.0f);
+  for (int i = 0; i < 2; ++i) {
+    for (int j = 0; j < 2; ++j) {
+      for (int p = 0; p < 3; ++p) {
+        grad_x[i * 3 + p] += dz[i * 2 + j] * ws[j * 3 + p];
+        grad_w[j * 3 + p] += dz[i * 2 + j] * xs[i * 3 + p];
+      }
+    }
+  }
+  for (int i = 0; i < 6; ++i) {
+    EXPECT_NEAR(x.grad().data_ptr<float>()[i], grad_x[i], 1e-6);
+    EXPECT_NEAR(w.grad().data_ptr<float>()[i], grad_w[i], 1e-6);
+  }
+  EXPECT_NEAR(b.grad().data_ptr<float>()[0], dz[0] + dz[2], 1e-6);
+  EXPECT_NEAR(b.grad().data_ptr<float>()[1], dz[1] + dz[3], 1e-6);
+}
+
+TEST(AutogradTest, LinearActBiasGradAcrossRowBlocks) {
+  // 150 rows span several row blocks of the fused activation/bias backward
+  const int64_t rows = 150;
+  const int64_t in = 3;
+  const int64_t out = 5;
+  std::vector<float> xs(rows * in);
+  std::vector<float> grads(rows * out);
+  for (size_t i = 0; i < xs.size(); ++i) {
+    xs[i] = static_cast<float>(static_cast<int>(i % 7) - 3) * 0.25f;
+  }
+  for (size_t i = 0; i < grads.size(); ++i) {
+    grads[i] = static_cast<float>(static_cast<int>(i % 5) - 2) * 0.5f;
+  }
+  for (nn::Activation activation :
+       {nn::Activation::None, nn::Activation::ReLU, nn::Activation::Tanh}) {
+    tensor::Tensor x_data({rows, in});
+    tensor::Tensor w_data({out, in});
+    tensor::Tensor b_data({out});
+    tensor::Tensor g_data({rows, out});
+    fill_tensor_data(x_data, xs);
+    fill_tensor_data(w_data, {0.5f, 0.25f, -1.0f, 1.0f, -0.5f, 0.75f, 0.1f, 0.2f, 0.3f,
+                              -0.4f, 0.6f, -0.2f, 0.3f, -0.1f, 0.9f});
+    fill_tensor_data(b_data, {0.1f, -0.2f, 0.0f, 0.3f, -0.1f});
+    fill_tensor_data(g_data, grads);
+
+    Variable x(x_data, false);
+    Variable w(w_data, true);
+    Variable b(b_data, true);
+    Variable y = nn::linear_act(x, w, b, activation);
+    y.set_grad(g_data);
+    y.backward();
+
+    const float* ys = y.data().data_ptr<float>();
+    std::vector<double> expected(out, 0.0);
+    for (int64_t i = 0; i < rows * out; ++i) {
+      double dz = grads[i];
+      if (activation == nn::Activation::ReLU) {
+        dz = ys[i] > 0 ? dz : 0.0;
+      } else if (activation == nn::Activation::Tanh) {
+        dz *= 1.0 - static_cast<double>(ys[i]) * ys[i];
+      }
+      expected[i % out] += dz;
+    }
+    for (int64_t j = 0; j < out; ++j) {
+      EXPECT_NEAR(b.grad().data_ptr<float>()[j], expected[j], 1e-4);
+    }
+  }
+}
+
 TEST(AutogradTest, ComposedOperations) {
   // Create input variables
   tensor::Tensor t1({2, 2});
@@ -533,6 +1108,50 @@ TEST(AutogradTest, GradientAccumulation) {
   check_tensor_values(b.grad(), {1.0f, 2.0f, 3.0f, 4.0f});  // a
 }
 
+TEST(AutogradTest, BroadcastGradientsMatchInputShapes) {
+  tensor::Tensor t1({2, 3});
+  tensor::Tensor t2({3});
+  fill_tensor_data(t1, {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f});
+  fill_tensor_data(t2, {1.0f, 2.0f, 3.0f});
+
+  AddFunction add_fn;
+  add_fn.forward({t1, t2});
+  tensor::Tensor grad_output({2, 3});
+  fill_tensor_data(grad_output, {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f});
+  auto add_grads = add_fn.backward({grad_output});
+  EXPECT_EQ(add_grads[0].shape(), std::vector<int64_t>({2, 3}));
+  EXPECT_EQ(add_grads[1].shape(), std::vector<int64_t>({3}));
+  check_tensor_values(add_grads[1], {2.0f, 2.0f, 2.0f});
+
+  // d(a*b)/db = sum over the broadcast rows of a * grad_output
+  MulFunction mul_fn;
+  mul_fn.forward({t1, t2});
+  auto mul_grads = mul_fn.backward({grad_output});
+  EXPECT_EQ(mul_grads[1].shape(), std::vector<int64_t>({3}));
+  check_tensor_values(mul_grads[1], {5.0f, 7.0f, 9.0f});
+  check_tensor_values(mul_grads[0], {1.0f, 2.0f, 3.0f, 1.0f, 2.0f, 3.0f});
+}
+
+TEST(AutogradTest, InPlaceModificationOfSavedTensor) {
+  tensor::Tensor t1({2, 2});
+  tensor::Tensor t2({2, 2});
+  fill_tensor_data(t1, {1.0f, 2.0f, 3.0f, 4.0f});
+  fill_tensor_data(t2, {5.0f, 6.0f, 7.0f, 8.0f});
+
+  Variable a(t1, true);
+  Variable b(t2, true);
+
+  Variable untouched = mul(a, b);
+  EXPECT_NO_THROW(untouched.backward());
+
+  // mul saves a for backward; writing into it afterwards must be detected
+  Variable result = mul(a, b);
+  uint64_t version = a.data().version();
+  tensor::add_(t1, t2);
+  EXPECT_EQ(a.data().version(), version + 1);
+  EXPECT_THROW(result.backward(), std::runtime_error);
+}
+
 TEST(AutogradTest, NoGradPropagation) {
   // Test that gradients don't propagate through variables with requires_grad=false
   tensor::Tensor t1({2, 2});
@@ -1,7 +1,18 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <string>
+
+#include "core/tensor/allocator.h"
+#include "core/tensor/arena.h"
+#include "core/tensor/gemm.h"
 #include "core/tensor/ops.h"  // Include tensor operations
+#include "core/tensor/parallel.h"
 #include "core/tensor/tensor.h"
+#include "core/tensor/vectorized.h"
 
 namespace torchscratch::core::tensor {
 
@@ -25,18 +36,129 @@ TEST(TensorTest, AllocateAndDeallocate) {
   EXPECT_FALSE(t.is_contiguous());
 }
 
+TEST(TensorTest, AllocationIsSizedAndAligned) {
+  Tensor t({3, 5});
+  t.allocate();
+  EXPECT_EQ(t.itemsize(), static_cast<int64_t>(sizeof(float)));
+  EXPECT_EQ(t.nbytes(), 15 * static_cast<int64_t>(sizeof(float)));
+  EXPECT_GE(t.storage()->nbytes(), static_cast<size_t>(t.nbytes()));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(t.data_ptr()) % Tensor::kAlignment, 0u);
+}
+
 TEST(TensorTest, Reshape) {
   Tensor t({2, 3});
   t.allocate();
   Tensor reshaped = t.reshape({3, 2});
   EXPECT_EQ(reshaped.shape(), std::vector<int64_t>({3, 2}));
   EXPECT_EQ(reshaped.numel(), 6);
-  EXPECT_FALSE(reshaped.is_contiguous());
+  EXPECT_TRUE(reshaped.is_contiguous());  // Reshape of dense data is a dense view
   EXPECT_EQ(reshaped.data_ptr(), t.data_ptr());
 
   EXPECT_THROW(t.reshape({2, 4}), std::runtime_error);
 }
 
+TEST(TensorTest, ViewsShareStorage) {
+  Tensor view;
+  {
+    Tensor t({2, 3});
+    t.allocate();
+    float* data = t.data_ptr<float>();
+    for (int i = 0; i < 6; ++i) {
+      data[i] = static_cast<float>(i);
+    }
+    view = transpose(t.reshape({3, 2}), 0, 1);
+    EXPECT_EQ(view.storage(), t.storage());
+    EXPECT_EQ(t.storage().use_count(), 2);
+  }
+
+  // The owning tensor is gone; the view keeps the buffer alive
+  ASSERT_TRUE(view.storage() != nullptr);
+  EXPECT_EQ(view.storage().use_count(), 1);
+  auto accessor = view.transposed_accessor<float>();
+  EXPECT_FLOAT_EQ(accessor[0], 0.0f);
+  EXPECT_FLOAT_EQ(accessor[1], 2.0f);
+  EXPECT_FLOAT_EQ(accessor[3], 1.0f);
+}
+
+TEST(TensorTest, InlineShapeMetadata) {
+  Tensor t({2, 3, 4});
+  EXPECT_TRUE(t.shape().is_inline());
+  EXPECT_TRUE(t.strides().is_inline());
+  EXPECT_EQ(t.numel(), 24);
+
+  // Copies and views carry their metadata inline too
+  t.allocate();
+  Tensor view = t.reshape({4, 6});
+  EXPECT_TRUE(view.shape().is_inline());
+  EXPECT_EQ(view.numel(), 24);
+
+  // Beyond kMaxInlineDims the shape spills to the heap but behaves the same
+  Tensor deep({1, 2, 1, 2, 1, 2, 1, 2});
+  EXPECT_FALSE(deep.shape().is_inline());
+  EXPECT_EQ(deep.dim(), 8);
+  EXPECT_EQ(deep.numel(), 16);
+  EXPECT_EQ(deep.strides(), std::vector<int64_t>({16, 8, 8, 4, 4, 2, 2, 1}));
+  Tensor deep_copy = deep;
+  EXPECT_EQ(deep_copy.shape(), deep.shape());
+}
+
+TEST(TensorTest, ContiguousMaterializesViews) {
+  // Large enough to span several copy tiles in both directions
+  Tensor t({3, 40, 70});
+  t.allocate();
+  float* data = t.data_ptr<float>();
+  for (int64_t i = 0; i < t.numel(); ++i) {
+    data[i] = static_cast<float>(i);
+  }
+  EXPECT_EQ(t.contiguous().data_ptr(), t.data_ptr());  // Already dense: no copy
+
+  Tensor view = transpose(t, 1, 2);  // [3, 70, 40]
+  EXPECT_FALSE(view.is_contiguous());
+  Tensor dense = view.contiguous();
+  EXPECT_TRUE(dense.is_contiguous());
+  EXPECT_NE(dense.data_ptr(), t.data_ptr());
+  const float* dense_data = dense.data_ptr<float>();
+  for (int64_t b = 0; b < 3; ++b) {
+    for (int64_t i = 0; i < 70; ++i) {
+      for (int64_t j = 0; j < 40; ++j) {
+        ASSERT_FLOAT_EQ(dense_data[(b * 70 + i) * 40 + j], data[(b * 40 + j) * 70 + i]);
+      }
+    }
+  }
+
+  // clone() and reshape() of a view go through the same copy
+  Tensor cloned = view.clone();
+  EXPECT_FLOAT_EQ(cloned.data_ptr<float>()[1], data[70]);
+  Tensor flat = view.reshape({3 * 70 * 40});
+  EXPECT_TRUE(flat.is_contiguous());
+  EXPECT_FLOAT_EQ(flat.data_ptr<float>()[1], data[70]);
+}
+
+TEST(TensorTest, KernelsHonorStrides) {
+  Tensor a({2, 3});
+  Tensor b({2, 3});
+  a.allocate();
+  b.allocate();
+  for (int i = 0; i < 6; ++i) {
+    a.data_ptr<float>()[i] = static_cast<float>(i + 1);
+    b.data_ptr<float>()[i] = static_cast<float>(2 * i);
+  }
+
+  // a @ b.T, with b.T a strided view: [[1,2,3],[4,5,6]] @ [[0,6],[2,8],[4,10]]
+  Tensor c = matmul(a, transpose(b, 0, 1));
+  EXPECT_FLOAT_EQ(c.data_ptr<float>()[0], 16.0f);
+  EXPECT_FLOAT_EQ(c.data_ptr<float>()[1], 52.0f);
+  EXPECT_FLOAT_EQ(c.data_ptr<float>()[3], 124.0f);
+
+  // In-place ops write through a transposed view
+  Tensor at = transpose(a, 0, 1);
+  Tensor bt = transpose(b, 0, 1);
+  add_(at, bt);
+  EXPECT_FLOAT_EQ(a.data_ptr<float>()[4], 5.0f + 8.0f);
+  scale_(at, 2.0);
+  EXPECT_FLOAT_EQ(a.data_ptr<float>()[4], 26.0f);
+}
+
 TEST(TensorTest, Clone) {
   Tensor t({2, 2});
   t.allocate();
@@ -60,6 +182,81 @@ TEST(TensorTest, CopyAndMove) {
   EXPECT_FALSE(t1.data_ptr());
 }
 
+TEST(TensorTest, CachingAllocatorReusesBlocks) {
+  CachingAllocator allocator;
+  EXPECT_EQ(CachingAllocator::round_size(1), 64u);
+  EXPECT_EQ(CachingAllocator::round_size(100), 112u);
+  EXPECT_EQ(CachingAllocator::round_size(129), 160u);
+
+  void* first = allocator.allocate(1000);
+  allocator.deallocate(first, 1000);
+  void* second = allocator.allocate(990);  // Same size class
+  EXPECT_EQ(first, second);
+
+  AllocatorStats stats = allocator.stats();
+  EXPECT_EQ(stats.misses, 1u);
+  EXPECT_EQ(stats.hits, 1u);
+  EXPECT_EQ(stats.bytes_in_use, CachingAllocator::round_size(1000));
+  EXPECT_EQ(stats.peak_bytes_in_use, CachingAllocator::round_size(1000));
+
+  allocator.deallocate(second, 990);
+  EXPECT_EQ(allocator.stats().bytes_cached, CachingAllocator::round_size(1000));
+  allocator.empty_cache();
+  EXPECT_EQ(allocator.stats().bytes_cached, 0u);
+  EXPECT_EQ(allocator.stats().bytes_in_use, 0u);
+}
+
+TEST(TensorTest, StepArenaBumpsAndResets) {
+  Tensor parameter({4, 4});
+  parameter.allocate();  // Outside the guard: heap
+
+  StepArena arena(1024);
+  Tensor escaped;
+  void* first_block = nullptr;
+  {
+    StepArenaGuard guard(arena);
+    EXPECT_EQ(StepArena::current(), &arena);
+
+    Tensor a({4, 4});
+    Tensor b({4, 4});
+    a.allocate();
+    b.allocate();
+    first_block = a.data_ptr();
+    EXPECT_EQ(static_cast<char*>(b.data_ptr()) - static_cast<char*>(a.data_ptr()), 64);
+    EXPECT_EQ(arena.bytes_used(), 128u);
+
+    Tensor big({1024});  // Larger than a chunk: gets a dedicated chunk
+    big.allocate();
+    escaped = add(parameter, parameter);
+    escaped = a;  // A view of the first chunk outlives the step
+  }
+  EXPECT_EQ(StepArena::current(), nullptr);
+  EXPECT_EQ(arena.bytes_used(), 0u);
+
+  // The escaped tensor is still readable and its chunk is not handed out again
+  EXPECT_EQ(escaped.data_ptr(), first_block);
+  {
+    StepArenaGuard guard(arena);
+    Tensor c({4, 4});
+    c.allocate();
+    EXPECT_NE(c.data_ptr(), first_block);
+  }
+
+  // Steps whose tensors all die recycle the same chunks
+  size_t capacity = arena.capacity();
+  void* recycled = nullptr;
+  for (int step = 0; step < 3; ++step) {
+    StepArenaGuard guard(arena);
+    Tensor d({4, 4});
+    d.allocate();
+    if (step > 0) {
+      EXPECT_EQ(d.data_ptr(), recycled);
+    }
+    recycled = d.data_ptr();
+  }
+  EXPECT_EQ(arena.capacity(), capacity);
+}
+
 TEST(TensorTest, Add) {
   Tensor a({2, 2});
   Tensor b({2, 2});
@@ -92,6 +289,58 @@ TEST(TensorTest, Add) {
   }
 }
 
+TEST(TensorTest, Broadcasting) {
+  EXPECT_EQ(broadcast_shapes({2, 1, 3}, {4, 1}), std::vector<int64_t>({2, 4, 3}));
+  EXPECT_THROW(broadcast_shapes({2, 3}, {4}), std::runtime_error);
+
+  Tensor a({2, 1, 3});
+  Tensor b({4, 1});
+  a.allocate();
+  b.allocate();
+  float* a_data = a.data_ptr<float>();
+  float* b_data = b.data_ptr<float>();
+  for (int i = 0; i < 6; ++i) {
+    a_data[i] = static_cast<float>(i);
+  }
+  for (int i = 0; i < 4; ++i) {
+    b_data[i] = 10.0f * (i + 1);
+  }
+
+  // c[i, j, k] = a[i, 0, k] - b[j, 0]
+  Tensor c = sub(a, b);
+  EXPECT_EQ(c.shape(), std::vector<int64_t>({2, 4, 3}));
+  const float* c_data = c.data_ptr<float>();
+  for (int i = 0; i < 2; ++i) {
+    for (int j = 0; j < 4; ++j) {
+      for (int k = 0; k < 3; ++k) {
+        EXPECT_FLOAT_EQ(c_data[(i * 4 + j) * 3 + k], a_data[i * 3 + k] - b_data[j]);
+      }
+    }
+  }
+
+  // Strided (transposed) operands are read in place
+  Tensor m({2, 3});
+  m.allocate();
+  for (int i = 0; i < 6; ++i) {
+    m.data_ptr<float>()[i] = static_cast<float>(i);
+  }
+  Tensor mt = transpose(m, 0, 1);
+  Tensor sq = mul(mt, mt);
+  EXPECT_EQ(sq.shape(), std::vector<int64_t>({3, 2}));
+  EXPECT_FLOAT_EQ(sq.data_ptr<float>()[1], 9.0f);  // mt[0, 1] = m[1, 0] = 3
+
+  // sum_to undoes the broadcast
+  Tensor a_grad = sum_to(c, a.shape());
+  Tensor b_grad = sum_to(c, b.shape());
+  EXPECT_EQ(a_grad.shape(), a.shape());
+  EXPECT_EQ(b_grad.shape(), b.shape());
+  // sum over j of (a[i, 0, k] - b[j]) = 4 * a[i, 0, k] - 100
+  EXPECT_FLOAT_EQ(a_grad.data_ptr<float>()[4], 4.0f * 4.0f - 100.0f);
+  // sum over i, k of (a[i, 0, k] - b[j]) = 15 - 6 * b[j]
+  EXPECT_FLOAT_EQ(b_grad.data_ptr<float>()[2], 15.0f - 6.0f * 30.0f);
+  EXPECT_EQ(sum_to(c, c.shape()).data_ptr(), c.data_ptr());
+}
+
 TEST(TensorTest, Mul) {
   Tensor a({2, 2});
   Tensor b({2, 2});
@@ -139,6 +388,658 @@ TEST(TensorTest, Matmul) {
   EXPECT_THROW(matmul(a, d), std::runtime_error);
 }
 
+TEST(TensorTest, InPlaceAndOutOps) {
+  Tensor a({2, 2});
+  Tensor b({2, 2});
+  a.allocate();
+  b.allocate();
+  float* a_data = a.data_ptr<float>();
+  float* b_data = b.data_ptr<float>();
+  for (int i = 0; i < 4; ++i) {
+    a_data[i] = static_cast<float>(i + 1);
+    b_data[i] = 10.0f;
+  }
+
+  // In-place ops write into the existing buffer and bump the shared version
+  Tensor view = a.reshape({4});
+  uint64_t version = a.version();
+  add_(a, b);
+  EXPECT_EQ(a.data_ptr<float>(), a_data);
+  EXPECT_FLOAT_EQ(a_data[3], 14.0f);
+  EXPECT_EQ(view.version(), version + 1);
+
+  scale_(a, 0.5);
+  EXPECT_FLOAT_EQ(a_data[0], 5.5f);
+  axpy_(a, -2.0, b);
+  EXPECT_FLOAT_EQ(a_data[0], -14.5f);
+  sub_(a, b);
+  mul_(a, b);
+  EXPECT_FLOAT_EQ(a_data[0], -245.0f);
+  EXPECT_EQ(a.version(), version + 5);
+
+  // Integer tensors round alpha * x instead of truncating alpha
+  Tensor counts({3}, DType::Int32);
+  Tensor steps({3}, DType::Int32);
+  counts.allocate();
+  steps.allocate();
+  for (int i = 0; i < 3; ++i) {
+    counts.data_ptr<int32_t>()[i] = 10 * (i + 1);
+    steps.data_ptr<int32_t>()[i] = 1000;
+  }
+  scale_(counts, 0.5);
+  EXPECT_EQ(counts.data_ptr<int32_t>()[2], 15);
+  axpy_(counts, -1e-3, steps);
+  EXPECT_EQ(counts.data_ptr<int32_t>()[0], 4);
+  scale_(counts, -0.25);
+  EXPECT_EQ(counts.data_ptr<int32_t>()[1], -2);
+
+  // Out variants reuse a preallocated destination...
+  Tensor out({2, 2});
+  out.allocate();
+  float* out_data = out.data_ptr<float>();
+  mul_out(out, b, b);
+  matmul_out(out, b, b);
+  EXPECT_EQ(out.data_ptr<float>(), out_data);
+  EXPECT_FLOAT_EQ(out_data[0], 200.0f);
+
+  // ...allocate an empty one, and reject mismatched or aliasing ones
+  Tensor fresh;
+  add_out(fresh, a, b);
+  EXPECT_EQ(fresh.shape(), std::vector<int64_t>({2, 2}));
+  Tensor wrong({3});
+  wrong.allocate();
+  EXPECT_THROW(add_out(wrong, a, b), std::runtime_error);
+  EXPECT_THROW(matmul_out(b, a, b), std::runtime_error);
+
+  // An output may be the very input it updates, or a disjoint part of its
+  // buffer, but not a different view overlapping it
+  Tensor square({4, 4});
+  square.allocate();
+  for (int i = 0; i < 16; ++i) {
+    square.data_ptr<float>()[i] = static_cast<float>(i);
+  }
+  EXPECT_THROW(add_(square, transpose(square, 0, 1)), std::runtime_error);
+  Tensor flat = square.reshape({16});
+  Tensor shifted = flat.as_strided({15}, {1}, 1);
+  Tensor head = flat.as_strided({15}, {1}, 0);
+  EXPECT_THROW(add_(head, shifted), std::runtime_error);
+  EXPECT_THROW(axpy_(head, 1.0, shifted), std::runtime_error);
+  EXPECT_THROW(mul_out(shifted, head, head), std::runtime_error);
+  Tensor low = flat.as_strided({8}, {1}, 0);
+  Tensor high = flat.as_strided({8}, {1}, 8);
+  add_(low, high);
+  EXPECT_FLOAT_EQ(square.data_ptr<float>()[0], 8.0f);
+  mul_(square, square);
+  EXPECT_FLOAT_EQ(square.data_ptr<float>()[0], 64.0f);
+}
+
+TEST(TensorTest, PackedGemmMatchesReference) {
+  // Odd sizes exercise partial register tiles; k > 256 spans several k-blocks
+  const int64_t m = 37;
+  const int64_t n = 53;
+  const int64_t k = 300;
+  Tensor a({m, k});
+  Tensor b_t({n, k});  // Used transposed, so B is read through strides
+  a.allocate();
+  b_t.allocate();
+  for (int64_t i = 0; i < a.numel(); ++i) {
+    a.data_ptr<float>()[i] = static_cast<float>((i * 7) % 13) / 13.0f - 0.5f;
+  }
+  for (int64_t i = 0; i < b_t.numel(); ++i) {
+    b_t.data_ptr<float>()[i] = static_cast<float>((i * 5) % 11) / 11.0f - 0.5f;
+  }
+  Tensor b = transpose(b_t, 0, 1);
+
+  std::vector<double> expected(m * n, 0.0);
+  for (int64_t i = 0; i < m; ++i) {
+    for (int64_t j = 0; j < n; ++j) {
+      for (int64_t p = 0; p < k; ++p) {
+        expected[i * n + j] += static_cast<double>(a.data_ptr<float>()[i * k + p]) *
+                               b_t.data_ptr<float>()[j * k + p];
+      }
+    }
+  }
+
+  const GemmIsa max_isa = gemm_max_isa();
+  for (GemmIsa isa : {GemmIsa::Scalar, GemmIsa::AVX2, GemmIsa::AVX512}) {
+    if (static_cast<int>(isa) > static_cast<int>(max_isa)) {
+      EXPECT_THROW(set_gemm_isa(isa), std::runtime_error);
+      continue;
+    }
+    set_gemm_isa(isa);
+    Tensor c = matmul(a, b);
+    for (int64_t i = 0; i < m * n; ++i) {
+      ASSERT_NEAR(c.data_ptr<float>()[i], expected[i], 1e-4) << gemm_isa_name(isa) << " at " << i;
+    }
+  }
+  set_gemm_isa(max_isa);
+
+  // Accumulating into C, and the double-precision path
+  Tensor c = matmul(a, b);
+  gemm<float>(m, n, k, a.data_ptr<float>(), k, 1, b_t.data_ptr<float>(), 1, k,
+              c.data_ptr<float>(), n, 1, /*accumulate=*/true);
+  EXPECT_NEAR(c.data_ptr<float>()[n + 1], 2.0 * expected[n + 1], 1e-4);
+  Tensor c64 = matmul(a.to(DType::Float64), b.to(DType::Float64));
+  EXPECT_NEAR(c64.data_ptr<double>()[m * n - 1], expected[m * n - 1], 1e-9);
+}
+
+TEST(TensorTest, ReducedPrecisionGemmAccumulatesInFloat) {
+  // C = ones @ B is the column sums of B. Column 0 reaches 99.609375 after the
+  // first 256-deep k-block, which BFloat16 would round to 99.5, and the second
+  // block brings it down to 3.609375: rounding the partial sum loses 0.11
+  const int64_t m = 3;
+  const int64_t n = 4;
+  const int64_t k = 512;
+  Tensor a({m, k});
+  Tensor b({k, n});
+  a.allocate();
+  b.allocate();
+  std::fill(a.data_ptr<float>(), a.data_ptr<float>() + a.numel(), 1.0f);
+  for (int64_t p = 0; p < k; ++p) {
+    float* row = b.data_ptr<float>() + p * n;
+    row[0] = p < 255 ? 0.390625f : (p == 255 ? 0.0f : -0.375f);
+    for (int64_t j = 1; j < n; ++j) {
+      row[j] = std::sin(0.37f * p + j) + (p < k / 2 ? 0.5f : -0.5f);
+    }
+  }
+  const Tensor a16 = a.to(DType::BFloat16);
+  const Tensor b16 = b.to(DType::BFloat16);
+
+  // Reference from the same BFloat16 inputs, summed in double
+  const Tensor b_rounded = b16.to(DType::Float32);
+  std::vector<double> expected(n, 0.0);
+  for (int64_t p = 0; p < k; ++p) {
+    for (int64_t j = 0; j < n; ++j) {
+      expected[j] += b_rounded.data_ptr<float>()[p * n + j];
+    }
+  }
+
+  const Tensor c = matmul(a16, b16).to(DType::Float32);
+  for (int64_t i = 0; i < m; ++i) {
+    for (int64_t j = 0; j < n; ++j) {
+      // Rounded once: within half a BFloat16 ulp of the exact sum
+      EXPECT_NEAR(c.data_ptr<float>()[i * n + j], expected[j], std::abs(expected[j]) / 256.0)
+          << "at " << i << ", " << j;
+    }
+  }
+  EXPECT_FLOAT_EQ(c.data_ptr<float>()[0], 3.609375f);
+
+  // The fused epilogue sees the float sums as well
+  Tensor bias({n});
+  bias.allocate();
+  std::fill(bias.data_ptr<float>(), bias.data_ptr<float>() + n, 0.0f);
+  const Tensor fused =
+      linear_act(a16, transpose(b16, 0, 1).contiguous(), bias.to(DType::BFloat16), Activation::ReLU)
+          .to(DType::Float32);
+  EXPECT_FLOAT_EQ(fused.data_ptr<float>()[0], 3.609375f);
+}
+
+TEST(TensorTest, ParallelGemmMatchesSingleThread) {
+  const int previous_threads = get_num_threads();
+  EXPECT_THROW(set_num_threads(0), std::runtime_error);
+
+  // parallel_for covers the range exactly once, in disjoint chunks
+  set_num_threads(4);
+  EXPECT_EQ(get_num_threads(), 4);
+  std::vector<int> hits(1000, 0);
+  parallel_for(0, 1000, 16, [&](int64_t begin, int64_t end) {
+    EXPECT_TRUE(in_parallel_region());
+    for (int64_t i = begin; i < end; ++i) {
+      ++hits[i];
+    }
+  });
+  EXPECT_EQ(std::count(hits.begin(), hits.end(), 1), 1000);
+  EXPECT_THROW(parallel_for(0, 100, 1,
+                            [](int64_t begin, int64_t) {
+                              if (begin > 0) {
+                                throw std::runtime_error("chunk failed");
+                              }
+                            }),
+               std::runtime_error);
+
+  // Large enough to be split over M blocks and N panels
+  const int64_t m = 150;
+  const int64_t n = 200;
+  const int64_t k = 300;
+  Tensor a({m, k});
+  Tensor b({k, n});
+  a.allocate();
+  b.allocate();
+  for (int64_t i = 0; i < a.numel(); ++i) {
+    a.data_ptr<float>()[i] = static_cast<float>((i * 7) % 13) / 13.0f - 0.5f;
+  }
+  for (int64_t i = 0; i < b.numel(); ++i) {
+    b.data_ptr<float>()[i] = static_cast<float>((i * 5) % 11) / 11.0f - 0.5f;
+  }
+
+  Tensor threaded = matmul(a, b);
+  set_num_threads(1);
+  Tensor serial = matmul(a, b);
+  for (int64_t i = 0; i < m * n; ++i) {
+    ASSERT_FLOAT_EQ(threaded.data_ptr<float>()[i], serial.data_ptr<float>()[i]) << "at " << i;
+  }
+  set_num_threads(previous_threads);
+}
+
+TEST(TensorTest, MatmulTransposeFlags) {
+  // a_t: [k, m] and b_t: [n, k] are the stored layouts of the transposed operands
+  const int64_t m = 19;
+  const int64_t n = 35;
+  const int64_t k = 270;
+  Tensor a_t({k, m});
+  Tensor b_t({n, k});
+  a_t.allocate();
+  b_t.allocate();
+  for (int64_t i = 0; i < a_t.numel(); ++i) {
+    a_t.data_ptr<float>()[i] = static_cast<float>((i * 7) % 13) / 13.0f - 0.5f;
+  }
+  for (int64_t i = 0; i < b_t.numel(); ++i) {
+    b_t.data_ptr<float>()[i] = static_cast<float>((i * 5) % 11) / 11.0f - 0.5f;
+  }
+  // Dense copies of the logical operands, for the plain NN reference
+  Tensor a = transpose(a_t, 0, 1).contiguous();
+  Tensor b = transpose(b_t, 0, 1).contiguous();
+  Tensor expected = matmul(a, b);
+
+  for (bool trans_a : {false, true}) {
+    for (bool trans_b : {false, true}) {
+      Tensor c = matmul(trans_a ? a_t : a, trans_b ? b_t : b, trans_a, trans_b);
+      ASSERT_EQ(c.shape(), std::vector<int64_t>({m, n}));
+      for (int64_t i = 0; i < m * n; ++i) {
+        ASSERT_NEAR(c.data_ptr<float>()[i], expected.data_ptr<float>()[i], 1e-4)
+            << "trans_a=" << trans_a << " trans_b=" << trans_b << " at " << i;
+      }
+    }
+  }
+
+  // Flags apply to the last two dimensions of batched operands too
+  Tensor batched = matmul(a_t.reshape({1, k, m}), b_t, true, true);
+  EXPECT_EQ(batched.shape(), std::vector<int64_t>({1, m, n}));
+  EXPECT_NEAR(batched.data_ptr<float>()[m * n - 1], expected.data_ptr<float>()[m * n - 1], 1e-4);
+  EXPECT_THROW(matmul(a, b, true, false), std::runtime_error);  // [k, m] @ [k, n]
+}
+
+TEST(TensorTest, LinearActEpilogue) {
+  // in_features > 256 spans several k-blocks; the epilogue must see the final sums
+  const int64_t rows = 37;
+  const int64_t in_features = 300;
+  const int64_t out_features = 53;
+  Tensor input({rows, in_features});
+  Tensor weight({out_features, in_features});
+  Tensor bias({out_features});
+  input.allocate();
+  weight.allocate();
+  bias.allocate();
+  for (int64_t i = 0; i < input.numel(); ++i) {
+    input.data_ptr<float>()[i] = static_cast<float>((i * 7) % 13) / 13.0f - 0.5f;
+  }
+  for (int64_t i = 0; i < weight.numel(); ++i) {
+    weight.data_ptr<float>()[i] = static_cast<float>((i * 5) % 11) / 11.0f - 0.5f;
+  }
+  for (int64_t i = 0; i < out_features; ++i) {
+    bias.data_ptr<float>()[i] = static_cast<float>(i % 5) - 2.0f;
+  }
+  Tensor z = add(matmul(input, weight, false, true), bias);
+
+  for (Activation activation :
+       {Activation::None, Activation::ReLU, Activation::Sigmoid, Activation::Tanh}) {
+    Tensor y = linear_act(input, weight, bias, activation);
+    ASSERT_EQ(y.shape(), std::vector<int64_t>({rows, out_features}));
+    for (int64_t i = 0; i < y.numel(); ++i) {
+      const float x = z.data_ptr<float>()[i];
+      float expected = x;
+      if (activation == Activation::ReLU) {
+        expected = std::max(x, 0.0f);
+      } else if (activation == Activation::Sigmoid) {
+        expected = 1.0f / (1.0f + std::exp(-x));
+      } else if (activation == Activation::Tanh) {
+        expected = std::tanh(x);
+      }
+      ASSERT_NEAR(y.data_ptr<float>()[i], expected, 1e-4) << static_cast<int>(activation);
+    }
+  }
+
+  // No bias, and leading batch dimensions flattened into rows
+  Tensor no_bias = linear_act(input.reshape({1, rows, in_features}), weight, Tensor());
+  EXPECT_EQ(no_bias.shape(), std::vector<int64_t>({1, rows, out_features}));
+  EXPECT_NEAR(no_bias.data_ptr<float>()[5],
+              z.data_ptr<float>()[5] - bias.data_ptr<float>()[5], 1e-4);
+  EXPECT_THROW(linear_act(weight, input, bias), std::runtime_error);
+}
+
+TEST(TensorTest, BatchedMatmul) {
+  // a is a strided batch view: [6, 5, 7] seen as [5, 6, 7] through a transpose
+  Tensor a_base({6, 5, 7});
+  Tensor b({1, 7, 3});  // Batch dimension broadcasts
+  a_base.allocate();
+  b.allocate();
+  for (int64_t i = 0; i < a_base.numel(); ++i) {
+    a_base.data_ptr<float>()[i] = static_cast<float>((i * 7) % 13) - 6.0f;
+  }
+  for (int64_t i = 0; i < b.numel(); ++i) {
+    b.data_ptr<float>()[i] = static_cast<float>((i * 5) % 11) - 5.0f;
+  }
+  Tensor a = transpose(a_base, 0, 1);
+
+  // Matrix i of a batched operand, as a 2-D view
+  auto matrix = [](const Tensor& t, int64_t i) {
+    return t.as_strided({t.shape()[1], t.shape()[2]}, {t.strides()[1], t.strides()[2]},
+                        t.storage_offset() + i * t.strides()[0]);
+  };
+
+  Tensor c = bmm(a, b);
+  EXPECT_EQ(c.shape(), std::vector<int64_t>({5, 6, 3}));
+  Tensor b_matrix = matrix(b, 0);
+  for (int64_t i = 0; i < 5; ++i) {
+    Tensor expected = matmul(matrix(a, i), b_matrix);
+    for (int64_t j = 0; j < expected.numel(); ++j) {
+      ASSERT_FLOAT_EQ(c.data_ptr<float>()[i * 18 + j], expected.data_ptr<float>()[j]);
+    }
+  }
+
+  // matmul batches any leading dimensions, including a 2-D operand against a 3-D one
+  Tensor flat = matmul(a, b_matrix);
+  EXPECT_EQ(flat.shape(), std::vector<int64_t>({5, 6, 3}));
+  EXPECT_FLOAT_EQ(flat.data_ptr<float>()[4 * 18 + 17], c.data_ptr<float>()[4 * 18 + 17]);
+
+  // Many small matrices are spread over the pool together
+  const int previous_threads = get_num_threads();
+  set_num_threads(4);
+  Tensor many_a({64, 40, 40});
+  Tensor many_b({64, 40, 40});
+  many_a.allocate();
+  many_b.allocate();
+  for (int64_t i = 0; i < many_a.numel(); ++i) {
+    many_a.data_ptr<float>()[i] = static_cast<float>(i % 17) / 17.0f;
+    many_b.data_ptr<float>()[i] = static_cast<float>(i % 19) / 19.0f;
+  }
+  Tensor threaded = bmm(many_a, many_b);
+  set_num_threads(1);
+  Tensor serial = bmm(many_a, many_b);
+  for (int64_t i = 0; i < threaded.numel(); ++i) {
+    ASSERT_FLOAT_EQ(threaded.data_ptr<float>()[i], serial.data_ptr<float>()[i]) << "at " << i;
+  }
+  set_num_threads(previous_threads);
+
+  // Integer matmul takes the same batch offsets
+  Tensor ints = bmm(a.to(DType::Int32), b.to(DType::Int32));
+  EXPECT_EQ(ints.data_ptr<int32_t>()[20], static_cast<int32_t>(c.data_ptr<float>()[20]));
+
+  Tensor wrong({5, 6, 3});
+  wrong.allocate();
+  EXPECT_THROW(bmm(a, wrong), std::runtime_error);        // Inner dimensions differ
+  EXPECT_THROW(bmm(a, b_matrix), std::runtime_error);     // bmm wants 3-D operands
+  EXPECT_THROW(bmm_out(wrong, a, many_b), std::runtime_error);  // Batch sizes differ
+
+  // BFloat16 partial sums stay in float across k-blocks: each column sums to
+  // 99.609375 over the first 256 rows, which BFloat16 would round to 99.5
+  Tensor ones({2, 3, 512});
+  Tensor deep({2, 512, 2});
+  ones.allocate();
+  deep.allocate();
+  std::fill(ones.data_ptr<float>(), ones.data_ptr<float>() + ones.numel(), 1.0f);
+  for (int64_t i = 0; i < deep.numel(); ++i) {
+    const int64_t p = i / 2 % 512;
+    deep.data_ptr<float>()[i] = p < 255 ? 0.390625f : (p == 255 ? 0.0f : -0.375f);
+  }
+  const Tensor sums =
+      bmm(ones.to(DType::BFloat16), deep.to(DType::BFloat16)).to(DType::Float32);
+  for (int64_t i = 0; i < sums.numel(); ++i) {
+    ASSERT_FLOAT_EQ(sums.data_ptr<float>()[i], 3.609375f) << "at " << i;
+  }
+}
+
+TEST(TensorTest, VectorizedKernelsMatchScalar) {
+  EXPECT_EQ(parse_cpu_isa("avx2"), CpuIsa::AVX2);
+  EXPECT_THROW(parse_cpu_isa("neon"), std::runtime_error);
+
+  // Odd length so every ISA runs its scalar tail as well
+  const int64_t n = 1037;
+  std::vector<float> a(n), b(n);
+  for (int64_t i = 0; i < n; ++i) {
+    a[i] = static_cast<float>((i * 7) % 23) / 23.0f - 0.5f;
+    b[i] = static_cast<float>((i * 5) % 19) / 19.0f - 0.5f;
+  }
+
+  const ElementwiseKernels& ref = elementwise_kernels(CpuIsa::Scalar);
+  for (CpuIsa isa : {CpuIsa::Scalar, CpuIsa::SSE42, CpuIsa::AVX2, CpuIsa::AVX512}) {
+    if (static_cast<int>(isa) > static_cast<int>(cpu_max_isa())) {
+      EXPECT_THROW(set_cpu_isa(isa), std::runtime_error);
+      EXPECT_THROW(elementwise_kernels(isa), std::runtime_error);
+      continue;
+    }
+    SCOPED_TRACE(cpu_isa_name(isa));
+    const ElementwiseKernels& k = elementwise_kernels(isa);
+    std::vector<float> expected(n), actual(n);
+    auto check = [&](const char* what) {
+      for (int64_t i = 0; i < n; ++i) {
+        ASSERT_EQ(actual[i], expected[i]) << what << " at " << i;
+      }
+    };
+
+    ref.add(n, a.data(), b.data(), expected.data());
+    k.add(n, a.data(), b.data(), actual.data());
+    check("add");
+    ref.sub(n, a.data(), b.data(), expected.data());
+    k.sub(n, a.data(), b.data(), actual.data());
+    check("sub");
+    ref.mul(n, a.data(), b.data(), expected.data());
+    k.mul(n, a.data(), b.data(), actual.data());
+    check("mul");
+    ref.add_scalar(n, a.data(), 0.25f, expected.data());
+    k.add_scalar(n, a.data(), 0.25f, actual.data());
+    check("add_scalar");
+    ref.mul_scalar(n, a.data(), -3.0f, expected.data());
+    k.mul_scalar(n, a.data(), -3.0f, actual.data());
+    check("mul_scalar");
+    ref.relu(n, a.data(), expected.data());
+    k.relu(n, a.data(), actual.data());
+    check("relu");
+    ref.relu_backward(n, a.data(), b.data(), expected.data());
+    k.relu_backward(n, a.data(), b.data(), actual.data());
+    check("relu_backward");
+
+    // FMA rounds once, so axpy may differ in the last bit
+    expected = b;
+    actual = b;
+    ref.axpy(n, 0.1f, a.data(), expected.data());
+    k.axpy(n, 0.1f, a.data(), actual.data());
+    for (int64_t i = 0; i < n; ++i) {
+      ASSERT_NEAR(actual[i], expected[i], 1e-6f) << "axpy at " << i;
+    }
+  }
+
+  // The tensor ops give the same answer whichever ISA is active
+  Tensor x({n});
+  Tensor y({n});
+  x.allocate();
+  y.allocate();
+  std::copy(a.begin(), a.end(), x.data_ptr<float>());
+  std::copy(b.begin(), b.end(), y.data_ptr<float>());
+  const CpuIsa previous = cpu_isa();
+  set_cpu_isa(CpuIsa::Scalar);
+  EXPECT_EQ(cpu_isa(), CpuIsa::Scalar);
+  Tensor scalar_sum = add(x, y);
+  set_cpu_isa(cpu_max_isa());
+  Tensor simd_sum = add(x, y);
+  for (int64_t i = 0; i < n; ++i) {
+    ASSERT_EQ(simd_sum.data_ptr<float>()[i], scalar_sum.data_ptr<float>()[i]);
+  }
+  set_cpu_isa(previous);
+}
+
+TEST(TensorTest, VectorizedMathAccuracy) {
+  EXPECT_EQ(parse_math_accuracy("precise"), MathAccuracy::Precise);
+  EXPECT_THROW(parse_math_accuracy("exact"), std::runtime_error);
+
+  // Error in units of the spacing of floats around the exact result
+  auto ulps = [](float actual, double exact) {
+    const float rounded = static_cast<float>(exact);
+    const float spacing = std::nextafter(std::fabs(rounded), INFINITY) - std::fabs(rounded);
+    return std::fabs(static_cast<double>(actual) - exact) / spacing;
+  };
+
+  // Sweep the interesting range densely, plus values that hit the special cases
+  std::vector<float> x;
+  for (int i = -12000; i <= 12000; ++i) {
+    x.push_back(static_cast<float>(i) * 0.0091f);
+  }
+  for (float v : {1e-30f, 1e-39f, 0.5f, 1.0f, 1e30f, 3e38f, -95.0f, -110.0f, 100.0f}) {
+    x.push_back(v);
+  }
+  const int64_t n = static_cast<int64_t>(x.size());
+  std::vector<float> out(n);
+
+  for (CpuIsa isa : {CpuIsa::Scalar, CpuIsa::SSE42, CpuIsa::AVX2, CpuIsa::AVX512}) {
+    if (static_cast<int>(isa) > static_cast<int>(cpu_max_isa())) {
+      continue;
+    }
+    SCOPED_TRACE(cpu_isa_name(isa));
+    const ElementwiseKernels& k = elementwise_kernels(isa, MathAccuracy::Fast);
+
+    k.exp(n, x.data(), out.data());
+    for (int64_t i = 0; i < n; ++i) {
+      const double exact = std::exp(static_cast<double>(x[i]));
+      if (exact < 3.4e38) {
+        ASSERT_LE(ulps(out[i], exact), 1.5) << "exp(" << x[i] << ")";
+      }
+    }
+    k.tanh(n, x.data(), out.data());
+    for (int64_t i = 0; i < n; ++i) {
+      ASSERT_LE(ulps(out[i], std::tanh(static_cast<double>(x[i]))), 1.5) << "tanh(" << x[i] << ")";
+    }
+    k.sigmoid(n, x.data(), out.data());
+    for (int64_t i = 0; i < n; ++i) {
+      const double exact = 1.0 / (1.0 + std::exp(-static_cast<double>(x[i])));
+      ASSERT_LE(ulps(out[i], exact), 3.0) << "sigmoid(" << x[i] << ")";
+    }
+    k.log(n, x.data(), out.data());
+    for (int64_t i = 0; i < n; ++i) {
+      if (x[i] > 0.0f) {
+        ASSERT_LE(ulps(out[i], std::log(static_cast<double>(x[i]))), 1.0) << "log(" << x[i] << ")";
+      }
+    }
+
+    // Special values follow libm
+    const float special[] = {0.0f, -1.0f, INFINITY, -INFINITY, NAN, 100.0f};
+    float result[6];
+    k.log(6, special, result);
+    EXPECT_EQ(result[0], -INFINITY);
+    EXPECT_TRUE(std::isnan(result[1]));
+    EXPECT_EQ(result[2], INFINITY);
+    EXPECT_TRUE(std::isnan(result[4]));
+    k.exp(6, special, result);
+    EXPECT_EQ(result[2], INFINITY);
+    EXPECT_EQ(result[3], 0.0f);
+    EXPECT_TRUE(std::isnan(result[4]));
+    EXPECT_EQ(result[5], INFINITY);
+    k.tanh(6, special, result);
+    EXPECT_EQ(result[2], 1.0f);
+    EXPECT_EQ(result[3], -1.0f);
+    EXPECT_TRUE(std::isnan(result[4]));
+    k.sigmoid(6, special, result);
+    EXPECT_EQ(result[2], 1.0f);
+    EXPECT_EQ(result[3], 0.0f);
+    EXPECT_TRUE(std::isnan(result[4]));
+  }
+
+  // The precise tier is the C library
+  const MathAccuracy previous = math_accuracy();
+  set_math_accuracy(MathAccuracy::Precise);
+  EXPECT_EQ(math_accuracy(), MathAccuracy::Precise);
+  elementwise_kernels().tanh(n, x.data(), out.data());
+  for (int64_t i = 0; i < n; ++i) {
+    ASSERT_EQ(out[i], std::tanh(x[i]));
+  }
+  set_math_accuracy(previous);
+}
+
+TEST(TensorTest, DTypes) {
+  Tensor d({2, 2}, DType::Float64);
+  EXPECT_EQ(d.dtype(), DType::Float64);
+  EXPECT_EQ(d.itemsize(), 8);
+  d.allocate();
+  EXPECT_THROW(d.data_ptr<float>(), std::runtime_error);
+
+  double* d_data = d.data_ptr<double>();
+  for (int i = 0; i < 4; ++i) {
+    d_data[i] = 0.1 * (i + 1);
+  }
+  Tensor sum = add(d, d);
+  Tensor prod = matmul(d, d);
+  EXPECT_EQ(sum.dtype(), DType::Float64);
+  EXPECT_DOUBLE_EQ(sum.data_ptr<double>()[3], 0.8);
+  EXPECT_DOUBLE_EQ(prod.data_ptr<double>()[0], 0.1 * 0.1 + 0.2 * 0.3);
+
+  Tensor i32({3}, DType::Int32);
+  i32.allocate();
+  int32_t* i_data = i32.data_ptr<int32_t>();
+  i_data[0] = 1;
+  i_data[1] = -2;
+  i_data[2] = 3;
+  Tensor i_prod = mul(i32, i32);
+  EXPECT_EQ(i_prod.data_ptr<int32_t>()[1], 4);
+
+  // Mixed dtypes are rejected rather than silently reinterpreted
+  Tensor f({2, 2});
+  f.allocate();
+  EXPECT_THROW(add(f, d), std::runtime_error);
+
+  // Reduced-precision round trips
+  Tensor half = d.to(DType::Float16);
+  Tensor bf16 = d.to(DType::BFloat16);
+  EXPECT_EQ(half.itemsize(), 2);
+  EXPECT_NEAR(static_cast<float>(half.data_ptr<Half>()[2]), 0.3f, 1e-3f);
+  EXPECT_NEAR(static_cast<float>(bf16.data_ptr<BFloat16>()[2]), 0.3f, 1e-2f);
+  Tensor half_sum = add(half, half);
+  EXPECT_NEAR(half_sum.to(DType::Float32).data_ptr<float>()[3], 0.8f, 1e-3f);
+  EXPECT_FLOAT_EQ(static_cast<float>(Half(65504.0f)), 65504.0f);
+  EXPECT_FLOAT_EQ(static_cast<float>(Half(1e-7f)), 1.1920928955078125e-7f);
+}
+
+TEST(TensorTest, FromMmap) {
+  std::string path = ::testing::TempDir() + "torchscratch_mmap_test.bin";
+  const float header = 42.0f;
+  const float values[6] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f};
+  FILE* file = std::fopen(path.c_str(), "wb");
+  ASSERT_TRUE(file != nullptr);
+  std::fwrite(&header, sizeof(float), 1, file);
+  std::fwrite(values, sizeof(float), 6, file);
+  std::fclose(file);
+
+  Tensor view;
+  {
+    Tensor mapped = Tensor::from_mmap(path, sizeof(float), {2, 3});
+    EXPECT_EQ(mapped.shape(), std::vector<int64_t>({2, 3}));
+    view = transpose(mapped, 0, 1);
+  }
+  // The transposed view keeps the mapping alive
+  auto accessor = view.transposed_accessor<float>();
+  EXPECT_FLOAT_EQ(accessor[0], 1.0f);
+  EXPECT_FLOAT_EQ(accessor[1], 4.0f);
+
+  // Copy-on-write pages can be modified without touching the file
+  Tensor cow = Tensor::from_mmap(path, sizeof(float), {6}, DType::Float32, MmapMode::CopyOnWrite);
+  cow.data_ptr<float>()[0] = -1.0f;
+  Tensor reread = Tensor::from_mmap(path, sizeof(float), {6});
+  EXPECT_FLOAT_EQ(reread.data_ptr<float>()[0], 1.0f);
+  EXPECT_FLOAT_EQ(add(cow, reread).data_ptr<float>()[5], 12.0f);
+
+  // Read-only mappings are rejected by in-place and out= ops instead of faulting
+  EXPECT_TRUE(reread.storage()->read_only());
+  EXPECT_FALSE(cow.storage()->read_only());
+  EXPECT_THROW(add_(reread, cow), std::runtime_error);
+  EXPECT_THROW(scale_(reread, 2.0), std::runtime_error);
+  EXPECT_THROW(axpy_(reread, 1.0, cow), std::runtime_error);
+  EXPECT_THROW(mul_out(reread, cow, cow), std::runtime_error);
+  EXPECT_EQ(reread.version(), 0u);
+  add_(cow, reread);
+  EXPECT_FLOAT_EQ(cow.data_ptr<float>()[5], 12.0f);
+
+  EXPECT_THROW(Tensor::from_mmap(path, 0, {100}), std::runtime_error);
+  std::remove(path.c_str());
+}
+
 TEST(TensorTest, Transpose) {
   Tensor a({2, 3});
   a.allocate();
@@ -162,6 +1063,102 @@ TEST(TensorTest, Transpose) {
   EXPECT_THROW(transpose(a, -1, 0), std::runtime_error);
 }
 
+TEST(TensorTest, Reductions) {
+  // [2, 3, 4] filled with 0..23
+  Tensor a({2, 3, 4});
+  a.allocate();
+  for (int i = 0; i < 24; ++i) {
+    a.data_ptr<float>()[i] = static_cast<float>(i);
+  }
+
+  Tensor total = sum(a);
+  EXPECT_EQ(total.shape(), std::vector<int64_t>({}));
+  EXPECT_FLOAT_EQ(total.data_ptr<float>()[0], 276.0f);
+  EXPECT_FLOAT_EQ(mean(a).data_ptr<float>()[0], 11.5f);
+
+  Tensor rows = sum(a, {2});
+  EXPECT_EQ(rows.shape(), std::vector<int64_t>({2, 3}));
+  const float expected_rows[] = {6, 22, 38, 54, 70, 86};
+  for (int i = 0; i < 6; ++i) {
+    EXPECT_FLOAT_EQ(rows.data_ptr<float>()[i], expected_rows[i]);
+  }
+
+  Tensor middle = sum(a, {1}, true);
+  EXPECT_EQ(middle.shape(), std::vector<int64_t>({2, 1, 4}));
+  EXPECT_FLOAT_EQ(middle.data_ptr<float>()[0], 12.0f);
+  EXPECT_FLOAT_EQ(middle.data_ptr<float>()[7], 57.0f);
+
+  // Non-adjacent dims and negative indices
+  Tensor outer = sum(a, {0, -1});
+  EXPECT_EQ(outer.shape(), std::vector<int64_t>({3}));
+  EXPECT_FLOAT_EQ(outer.data_ptr<float>()[0], 6.0f + 54.0f);
+  EXPECT_FLOAT_EQ(outer.data_ptr<float>()[2], 38.0f + 86.0f);
+
+  Tensor largest = max(a, {1});
+  EXPECT_FLOAT_EQ(largest.data_ptr<float>()[0], 8.0f);
+  EXPECT_FLOAT_EQ(largest.data_ptr<float>()[7], 23.0f);
+  EXPECT_FLOAT_EQ(min(a, {0, 1}).data_ptr<float>()[3], 3.0f);
+  EXPECT_FLOAT_EQ(norm(a, 2, {2}).data_ptr<float>()[0], std::sqrt(14.0f));
+  EXPECT_FLOAT_EQ(norm(a, 1).data_ptr<float>()[0], 276.0f);
+  EXPECT_FLOAT_EQ(norm(a, INFINITY).data_ptr<float>()[0], 23.0f);
+
+  // Indices of the first maximum
+  Tensor idx = argmax(a, 1, true);
+  EXPECT_EQ(idx.dtype(), DType::Int32);
+  EXPECT_EQ(idx.shape(), std::vector<int64_t>({2, 1, 4}));
+  EXPECT_EQ(idx.data_ptr<int32_t>()[0], 2);
+  EXPECT_EQ(argmax(a).data_ptr<int32_t>()[0], 23);
+
+  // A column sum over a tall matrix goes through the row-blocked path
+  Tensor tall({1000, 3});
+  tall.allocate();
+  for (int i = 0; i < 3000; ++i) {
+    tall.data_ptr<float>()[i] = static_cast<float>(i % 3);
+  }
+  Tensor cols = sum(tall, {0});
+  EXPECT_FLOAT_EQ(cols.data_ptr<float>()[0], 0.0f);
+  EXPECT_FLOAT_EQ(cols.data_ptr<float>()[2], 2000.0f);
+
+  // Integer sums that do not fit the dtype throw instead of wrapping around
+  Tensor ints({3}, DType::Int32);
+  ints.allocate();
+  ints.data_ptr<int32_t>()[0] = std::numeric_limits<int32_t>::max();
+  ints.data_ptr<int32_t>()[1] = 1;
+  ints.data_ptr<int32_t>()[2] = -2;
+  // The int64_t accumulator carries the intermediate value past INT32_MAX
+  EXPECT_EQ(sum(ints).data_ptr<int32_t>()[0], std::numeric_limits<int32_t>::max() - 1);
+  ints.data_ptr<int32_t>()[2] = 0;
+  EXPECT_THROW(sum(ints), std::runtime_error);
+
+  // Pairwise accumulation keeps a long float sum accurate, and the result does
+  // not depend on the number of threads
+  const int64_t n = 1 << 22;
+  Tensor big({n});
+  big.allocate();
+  for (int64_t i = 0; i < n; ++i) {
+    big.data_ptr<float>()[i] = 0.1f;
+  }
+  const int threads = get_num_threads();
+  set_num_threads(1);
+  float serial = sum(big).data_ptr<float>()[0];
+  set_num_threads(4);
+  float parallel = sum(big).data_ptr<float>()[0];
+  set_num_threads(threads);
+  EXPECT_EQ(serial, parallel);
+  EXPECT_NEAR(serial, 0.1 * n, 0.1 * n * 1e-6);
+
+  // NaN propagates through max
+  a.data_ptr<float>()[5] = NAN;
+  EXPECT_TRUE(std::isnan(max(a, {1}).data_ptr<float>()[1]));
+  EXPECT_FALSE(std::isnan(max(a, {1}).data_ptr<float>()[0]));
+
+  EXPECT_THROW(sum(a, {3}), std::runtime_error);
+  EXPECT_THROW(sum(a, {1, 1}), std::runtime_error);
+  Tensor empty({0, 3});
+  EXPECT_FLOAT_EQ(sum(empty).data_ptr<float>()[0], 0.0f);
+  EXPECT_THROW(max(empty, {0}), std::runtime_error);
+}
+
 }  // namespace torchscratch::core::tensor
 
 int main(int argc, char** argv) {